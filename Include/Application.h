@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <thread>
+
 #include "IBackend.h"
 #include "Types.h"
 
@@ -27,6 +30,41 @@ public:
      */
     void Stop();
 
+    /**
+     * Renders frames back to back instead of at 60 per second and stops once this many have been
+     * rendered after IsReady() became true, for benchmarks and thumbnails. 0 runs until the window closes.
+     */
+    void SetFrameLimit(uint32 frames) { mFrameLimit = frames; }
+
+    /**
+     * Renders a frame only when something changed instead of 60 times a second. Input, Invalidate
+     * and main thread jobs wake the loop, in between it blocks waiting for events so an idle
+     * window uses no CPU or GPU time. Ignored by SetFrameLimit runs.
+     */
+    void SetRenderOnDemand(bool onDemand) { mRenderOnDemand = onDemand; }
+
+    /**
+     * @return true if frames are only rendered when something changed
+     */
+    bool GetRenderOnDemand() const { return mRenderOnDemand; }
+
+    /**
+     * Marks the frame as changed so the next one is rendered when rendering on demand.
+     * Can be called from any thread.
+     */
+    void Invalidate();
+
+    /**
+     * Marks the frame as changed once delay seconds pass, for progress and animations that redraw
+     * at their own rate. Only call it from the main thread.
+     */
+    void Invalidate(float64 delay);
+
+    /**
+     * @return true once the application has what it needs for frames counted by SetFrameLimit
+     */
+    virtual bool IsReady() const { return true; }
+
     /**
      * Get the current frames per second
      */
@@ -37,6 +75,17 @@ public:
      */
     float64 GetUpdateRate() const { return mUps; }
 
+    /**
+     * Updates step the application forward 1/60 of a second at a time, frames fall in between them.
+     * Draw moving things this far from their state at the last update towards the next, from 0 to 1.
+     */
+    float64 GetInterpolation() const { return mInterpolation; }
+
+    /**
+     * @return seconds between the last two frames
+     */
+    float64 GetFrameTime() const { return mFrameTime; }
+
     /**
      * Called when the application is initializing
      */
@@ -54,6 +103,12 @@ public:
      */
     virtual void OnRender() = 0;
 
+    /**
+     * Called after the last frame of a SetFrameLimit run, before OnDestroy, while the graphics
+     * device can still read back what was drawn
+     */
+    virtual void OnLastFrame() {}
+
     /**
      * Called when the application is ending
      */
@@ -67,10 +122,25 @@ protected:
     Video::IGraphicsDevice* Graphics = nullptr;
 private:
     void UpdateLoop();
+    void LimitedLoop();
+
+    /**
+     * Blocks until input, Invalidate or the delayed invalidate
+     */
+    void WaitForInvalidate();
 
     bool mRunning = false;
+    bool mRenderOnDemand = false;
+    /** Set when the next frame has to be rendered */
+    std::atomic<bool> mDirty{true};
+    /** When a delayed Invalidate is due in seconds, negative if there is none */
+    float64 mInvalidateTime = -1;
+    std::thread::id mMainThread;
     float64 mFps = 0.0;
     float64 mUps = 0.0;
+    float64 mInterpolation = 0.0;
+    float64 mFrameTime = 0.0;
+    uint32 mFrameLimit = 0;
 };
 
 }
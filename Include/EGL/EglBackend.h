@@ -0,0 +1,35 @@
+#pragma once
+
+#include "EGL/EglWindow.h"
+#include "IBackend.h"
+#include "OGL/OglGraphicsDevice.h"
+
+namespace Core
+{
+
+/**
+ * Backend that draws offscreen, for thumbnails and benchmarks on machines without a display
+ */
+class EglBackend : public IBackend
+{
+public:
+    EglBackend(uint width = 800, uint height = 600);
+    ~EglBackend();
+
+    /**
+     * @return false if no OpenGL context could be created, nothing can be drawn
+     */
+    bool IsValid() const { return mWindow.HasContext(); }
+
+    void Init();
+    void Update(float64 dt) { mGraphics.Ratio = mWindow.GetAspectRatio(); }
+    void Destroy();
+
+    IWindow* GetWindow() { return &mWindow; }
+    Video::IGraphicsDevice* GetGraphicsDevice() { return &mGraphics; }
+private:
+    EglWindow mWindow;
+    Video::OglGraphicsDevice mGraphics;
+};
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+
+#include <EGL/egl.h>
+#include <GL/glew.h>
+
+#include "SDL2/SdlMouse.h"
+#include "IWindow.h"
+#include "Types.h"
+
+namespace Gui
+{
+
+class Environment;
+
+}
+
+namespace Core
+{
+
+/**
+ * Window with nothing on screen, for machines without a display or GPU.
+ * An OpenGL context is created through EGL with no surface, on Mesa's llvmpipe if there is no GPU,
+ * and everything is drawn into a framebuffer object the size of the window so it can be read back.
+ */
+class EglWindow : public IWindow
+{
+public:
+    EglWindow(const std::string& title, uint width, uint height);
+    virtual ~EglWindow();
+
+    /**
+     * @return false if no OpenGL context could be created
+     */
+    bool HasContext() const { return mContext != EGL_NO_CONTEXT; }
+
+    virtual bool IsVisible() const { return mVisible; }
+    virtual void SetVisible(bool visible) { mVisible = visible; }
+
+    virtual const std::string& GetTitle() const { return mTitle; }
+    virtual void SetTitle(const std::string& title) { mTitle = title; }
+
+    virtual uint GetWidth() const { return mWidth; }
+    virtual uint GetHeight() const { return mHeight; }
+    virtual void SetSize(uint width, uint height);
+
+    /**
+     * There are no input events without a display
+     */
+    virtual void PollEvents() {}
+
+    /**
+     * Nothing can arrive without a display, returns right away
+     */
+    virtual void WaitEvents(float64 timeout) {}
+    virtual void Wake() {}
+
+    /**
+     * Waits for the frame to finish drawing, so frame times include the GPU's work
+     */
+    virtual void SwapBuffers();
+
+    float32 GetAspectRatio() { return (float32) mWidth / mHeight; }
+
+    virtual Gui::Environment* GetEnvironment() { return mEnv; }
+    virtual SdlMouse* GetMouse() { return mMouse; }
+private:
+    EglWindow(const EglWindow&) = delete;
+    EglWindow& operator=(const EglWindow&) = delete;
+
+    bool CreateContext();
+    void CreateFramebuffer();
+    void ReleaseFramebuffer();
+
+    std::string mTitle;
+    uint mWidth, mHeight;
+    bool mVisible;
+    EGLDisplay mDisplay;
+    EGLContext mContext;
+    GLuint mFramebuffer;
+    GLuint mColorBuffer;
+    GLuint mDepthBuffer;
+    SdlMouse* mMouse;
+    Gui::Environment* mEnv;
+};
+
+}
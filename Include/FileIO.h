@@ -1,8 +1,47 @@
 #pragma once
 
+#include <atomic>
 #include <boost/filesystem.hpp>
 #include <vector>
 #include <iostream>
+#include "Types.h"
+
+/**
+ * Mesh loaded from an .obj file, stored as one contiguous array per attribute.
+ * FaceElements holds a v/vt/vn index triplet for each corner of each triangle,
+ * indices start at 1 and missing texture coordinates or normals are 0.
+ */
+struct ObjMesh
+{
+	std::vector< float32 > GeometricVertices;
+	std::vector< float32 > TextureCoordinates;
+	std::vector< float32 > NormalVertices;
+	std::vector< uint32 > FaceElements;
+
+	size_t GetVertexCount( ) const { return GeometricVertices.size( ) / 3; }
+	size_t GetTextureCoordinateCount( ) const { return TextureCoordinates.size( ) / 2; }
+	size_t GetNormalCount( ) const { return NormalVertices.size( ) / 3; }
+	size_t GetTriangleCount( ) const { return FaceElements.size( ) / 9; }
+};
+
+/**
+ * Shared between a loader and the thread watching it. The loader adds to Processed as it works
+ * through the Total bytes of work, and stops early once Cancelled is set.
+ */
+struct ObjLoadProgress
+{
+	std::atomic< uint64 > Processed;
+	std::atomic< uint64 > Total;
+	std::atomic< bool > Cancelled;
+
+	ObjLoadProgress( ) : Processed( 0 ), Total( 0 ), Cancelled( false ) {}
+
+	float32 GetFraction( ) const
+	{
+		uint64 total = Total;
+		return total ? static_cast< float32 >( static_cast< float64 >( Processed ) / total ) : 0.0f;
+	}
+};
 
 /**
  * Class header file for loading and saving for 3d modeler
@@ -34,4 +73,18 @@ class FileIO{
 		void LoadObj2( boost::filesystem::path p, std::vector< std::vector< double > > &refGeometricVertices,
 				std::vector< std::vector< double > > &refTextureCoordinates, std::vector< std::vector<double > > &refNormalVertices,
 				std::vector< std::vector< std::vector< int > > > &refFaceElements );
+
+		//load method for .obj files that maps the file into memory and parses it in place, returns false if the file can't be read
+		bool LoadObjMapped( boost::filesystem::path p, std::vector< std::vector< double > > &refGeometricVertices,
+				std::vector< std::vector< double > > &refTextureCoordinates, std::vector< std::vector<double > > &refNormalVertices,
+				std::vector< std::vector< std::vector< int > > > &refFaceElements );
+
+		//load method for .obj files that parses newline aligned chunks of the file on threadCount threads, 0 uses one per core
+		bool LoadObjParallel( boost::filesystem::path p, std::vector< std::vector< double > > &refGeometricVertices,
+				std::vector< std::vector< double > > &refTextureCoordinates, std::vector< std::vector<double > > &refNormalVertices,
+				std::vector< std::vector< std::vector< int > > > &refFaceElements, uint threadCount = 0 );
+
+		//load method for .obj files into flat float and index arrays, 0 threads uses one per core
+		//progress is optional, returns false if the file can't be read or the load was cancelled
+		bool LoadObjMesh( boost::filesystem::path p, ObjMesh &refMesh, uint threadCount = 0, ObjLoadProgress* progress = nullptr );
 };
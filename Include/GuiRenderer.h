@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "IGraphicsDevice.h"
 #include "Types.h"
 
@@ -9,13 +12,26 @@ namespace Video
 {
 
 /**
- * Interface for 2D drawing
+ * Interface for 2D drawing.
+ * Rectangles are collected into one vertex buffer and drawn together when the texture
+ * changes, the buffer fills up or Flush is called at the end of the frame. The font and
+ * the GUI images share one atlas texture so drawing them doesn't break the batch.
  *
  * @author Nicholas Hamilton
  */
 class GuiRenderer
 {
 public:
+    /**
+     * Images in the atlas
+     */
+    enum class Image
+    {
+        None,
+        Button,
+        Font
+    };
+
     GuiRenderer(IGraphicsDevice* gd);
     ~GuiRenderer();
 
@@ -30,6 +46,11 @@ public:
         mTranslate = 0;
     }
 
+    /**
+     * Draws everything drawn since the last flush, call at the end of the frame
+     */
+    void Flush();
+
     /**
      * Set an offset to render from
      */
@@ -44,6 +65,15 @@ public:
     void SetColor(const Core::Math::Vector3f& r) { SetColor(r.R, r.G, r.B); }
     void SetColor(const Core::Math::Vector4f& r) { SetColor(r.R, r.G, r.B, r.A); }
 
+    /**
+     * Sets the image from the atlas that rectangles are filled with, None fills them with the color alone
+     */
+    void SetImage(Image image);
+
+    /**
+     * Fills rectangles with a texture that isn't in the atlas, nullptr goes back to the atlas with no image.
+     * Each change of texture costs a draw call.
+     */
     void SetTexture(ITexture2D* texture);
 
     /**
@@ -55,13 +85,30 @@ public:
     void DrawText(const std::string& str, float32 size, float32 x, float32 y, float32 xWeight = 0.5f, float32 yWeight = 0.5f);
 
 private:
+    /**
+     * Part of a texture that texture coordinates from 0 to 1 are mapped to
+     */
+    struct TextureRegion
+    {
+        ITexture2D* Texture;
+        float32 U, V, Width, Height;
+    };
+
+    void BuildAtlas();
+
     IGraphicsDevice* mGraphics;
     IShader* mShader;
+    UniformHandle mTextureUniform;
     IGeometry* mGeometry;
     IIndexBuffer* mIndices;
     IVertexBuffer* mVertices;
-    ITexture2D* mTexture;
-    ITexture2D* mFontTex;
+    ITexture2D* mAtlas;
+    /** Where each Image is in the atlas */
+    std::vector<TextureRegion> mImages;
+    TextureRegion mRegion;
+    /** Vertices of the rectangles waiting to be drawn */
+    std::vector<float32> mBatch;
+    ITexture2D* mBatchTexture;
     Core::Math::Vector4f mColor;
     Core::Math::Vector2f mTranslate;
 };
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "IGeometry.h"
 #include "IIndexBuffer.h"
 #include "IShader.h"
@@ -35,6 +38,31 @@ enum class BufferHint
     Stream
 };
 
+/**
+ * Whether a buffer keeps a copy of its data in system memory
+ */
+enum class BufferShadow
+{
+    /** Only Dynamic buffers keep a copy */
+    Default,
+    /** Keep a copy so GetData doesn't read from the GPU */
+    Keep,
+    /** Don't keep a copy, halves the memory a large mesh uses, GetData reads back from the GPU */
+    None
+};
+
+/**
+ * Memory used by all the buffers a device has created
+ */
+struct BufferMemoryStats
+{
+    uint64 BufferCount;
+    /** Bytes allocated for buffer objects */
+    uint64 GpuBytes;
+    /** Bytes of copies kept in system memory */
+    uint64 ShadowBytes;
+};
+
 /**
  * Base interface for graphics
  *
@@ -65,14 +93,22 @@ public:
      *
      * @param count Number of vertices in the buffer
      */
-    virtual IVertexBuffer* CreateVertexBuffer(VertexFormat format, uint count, BufferHint hint = BufferHint::Dynamic) = 0;
+    virtual IVertexBuffer* CreateVertexBuffer(VertexFormat format, uint count, BufferHint hint = BufferHint::Dynamic,
+            BufferShadow shadow = BufferShadow::Default) = 0;
 
     /**
      * @return Index buffer created by the device
      *
      * @param count Number of indices in the buffer
+     * @param format Size of each index, UInt16 halves the memory used when every index fits
+     */
+    virtual IIndexBuffer* CreateIndexBuffer(uint count, BufferHint hint = BufferHint::Dynamic, IndexFormat format = IndexFormat::UInt32,
+            BufferShadow shadow = BufferShadow::Default) = 0;
+
+    /**
+     * @return memory used by the vertex and index buffers that haven't been released
      */
-    virtual IIndexBuffer* CreateIndexBuffer(uint count, BufferHint hint = BufferHint::Dynamic) = 0;
+    virtual BufferMemoryStats GetBufferMemory() const = 0;
 
     /**
      * @return Shader created by the device
@@ -92,6 +128,11 @@ public:
      */
     virtual ITexture2D* CreateTexture2D(const std::string& filename) = 0;
 
+    /**
+     * @return empty texture created by the device, fill it with SetData
+     */
+    virtual ITexture2D* CreateTexture2D(uint width, uint height) = 0;
+
     /**
      * Sets the color that the screen should be when being cleared.
      * values should be between 0 and 1.
@@ -103,6 +144,13 @@ public:
      */
     virtual void Clear(bool color = true, bool depth = true) = 0;
 
+    /**
+     * Reads back what has been drawn to the screen
+     *
+     * @param refPixels receives RGBA pixels, top row first
+     */
+    virtual void ReadPixels(std::vector<uint8>& refPixels, uint& refWidth, uint& refHeight) = 0;
+
     /**
      * @return Current geometry
      */
@@ -161,10 +209,33 @@ public:
      * Draw the current geometry with the set shader
      *
      * @param prim Primitive type to draw
-     * @param start Index of first vertex to draw
+     * @param start Position of the first index to draw in the index buffer
      * @param primCount Number of primitives to draw, NOT number of indices
      */
     virtual void DrawIndices(Primitive prim, uint start, uint primCount) = 0;
+
+    /**
+     * Draw the current geometry instanceCount times with the set shader. Vertex buffers whose
+     * format is instanced advance one vertex per instance, the others are read again for each.
+     *
+     * @param prim Primitive type to draw
+     * @param start Index of first vertex to draw
+     * @param primCount Number of primitives in each instance, NOT number of vertices
+     * @param instanceStart Vertex of the instanced vertex buffers the first instance reads
+     * @param instanceCount Number of instances to draw
+     */
+    virtual void DrawInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount) = 0;
+
+    /**
+     * Draw the current geometry instanceCount times with the set shader, see DrawInstanced
+     *
+     * @param prim Primitive type to draw
+     * @param start Position of the first index to draw in the index buffer
+     * @param primCount Number of primitives in each instance, NOT number of indices
+     * @param instanceStart Vertex of the instanced vertex buffers the first instance reads
+     * @param instanceCount Number of instances to draw
+     */
+    virtual void DrawIndicesInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount) = 0;
 };
 
 }
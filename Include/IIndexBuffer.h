@@ -6,6 +6,15 @@
 namespace Video
 {
 
+/**
+ * Size of each index stored in an index buffer
+ */
+enum class IndexFormat
+{
+    UInt16,
+    UInt32
+};
+
 /**
  * Interface for a index buffer
  *
@@ -14,8 +23,6 @@ namespace Video
 class IIndexBuffer : public IGraphicsResource
 {
 public:
-    static const uint BytesPerIndex = 4;
-
     virtual ~IIndexBuffer() {}
 
     /**
@@ -23,10 +30,20 @@ public:
      */
     virtual uint GetLength() const = 0;
 
+    /**
+     * @return size of each index in the buffer
+     */
+    virtual IndexFormat GetFormat() const = 0;
+
+    /**
+     * @return number of bytes each index uses
+     */
+    uint GetBytesPerIndex() const { return GetFormat() == IndexFormat::UInt16 ? 2 : 4; }
+
     /**
      * @return number of bytes the buffer uses
      */
-    virtual uint GetSizeInBytes() const { return GetLength() * BytesPerIndex; }
+    virtual uint GetSizeInBytes() const { return GetLength() * GetBytesPerIndex(); }
 
     /**
      * @param out location to put the data
@@ -34,7 +51,7 @@ public:
     virtual void GetData(uint32* out, uint start, uint count) const = 0;
 
     /**
-     * @param in location of data to set
+     * @param in location of data to set, narrowed to 16 bits if the buffer uses IndexFormat::UInt16
      */
     virtual void SetData(const uint32* in, uint start, uint count) = 0;
 };
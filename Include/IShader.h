@@ -10,7 +10,22 @@ namespace Video
 {
 
 /**
- * Interface for a shader
+ * Refers to a uniform of one shader
+ */
+struct UniformHandle
+{
+    int32 Index;
+
+    UniformHandle() : Index(-1) {}
+    explicit UniformHandle(int32 index) : Index(index) {}
+
+    bool IsValid() const { return Index >= 0; }
+};
+
+/**
+ * Interface for a shader.
+ * Uniform values are kept by the shader and sent to the GPU when it is next drawn with,
+ * only if they changed.
  *
  * @author Nicholas Hamilton
  */
@@ -29,40 +44,54 @@ public:
      */
     virtual const std::string& GetFragmentSource() const = 0;
 
+    /**
+     * Looks a uniform up by name, keep the handle to set it without the lookup
+     *
+     * @return handle of the uniform, not valid if the shader doesn't use it
+     */
+    virtual UniformHandle GetUniform(const std::string& name) const = 0;
+
     /**
      * Set a 4x4 matrix uniform
      */
-    virtual void SetMatrix4f(const std::string& name, const Core::Math::Matrix4f& mat) = 0;
+    virtual void SetMatrix4f(UniformHandle uniform, const Core::Math::Matrix4f& mat) = 0;
+    void SetMatrix4f(const std::string& name, const Core::Math::Matrix4f& mat) { SetMatrix4f(GetUniform(name), mat); }
 
     /**
      * Set a 3x3 matrix uniform
      */
-    virtual void SetMatrix3f(const std::string& name, const Core::Math::Matrix3f& mat) = 0;
+    virtual void SetMatrix3f(UniformHandle uniform, const Core::Math::Matrix3f& mat) = 0;
+    void SetMatrix3f(const std::string& name, const Core::Math::Matrix3f& mat) { SetMatrix3f(GetUniform(name), mat); }
 
     /**
      * Set a 4-vector uniform
      */
-    virtual void SetVector4f(const std::string& name, const Core::Math::Vector4f& vec) = 0;
+    virtual void SetVector4f(UniformHandle uniform, const Core::Math::Vector4f& vec) = 0;
+    void SetVector4f(const std::string& name, const Core::Math::Vector4f& vec) { SetVector4f(GetUniform(name), vec); }
 
     /**
      * Set a 3-vector uniform
      */
-    virtual void SetVector3f(const std::string& name, const Core::Math::Vector3f& vec) = 0;
+    virtual void SetVector3f(UniformHandle uniform, const Core::Math::Vector3f& vec) = 0;
+    void SetVector3f(const std::string& name, const Core::Math::Vector3f& vec) { SetVector3f(GetUniform(name), vec); }
 
     /**
      * Set a 2-vector uniform
      */
-    virtual void SetVector2f(const std::string& name, const Core::Math::Vector2f& vec) = 0;
+    virtual void SetVector2f(UniformHandle uniform, const Core::Math::Vector2f& vec) = 0;
+    void SetVector2f(const std::string& name, const Core::Math::Vector2f& vec) { SetVector2f(GetUniform(name), vec); }
 
     /**
      * Set a float uniform
      */
-    virtual void SetFloat32(const std::string& name, float32 f) = 0;
+    virtual void SetFloat32(UniformHandle uniform, float32 f) = 0;
+    void SetFloat32(const std::string& name, float32 f) { SetFloat32(GetUniform(name), f); }
 
     /**
-     * Set an integer uniform
+     * Set an integer, boolean or sampler uniform
      */
-    virtual void SetInt32(const std::string& name, int32 i) = 0;
+    virtual void SetInt32(UniformHandle uniform, int32 i) = 0;
+    void SetInt32(const std::string& name, int32 i) { SetInt32(GetUniform(name), i); }
 };
 
 }
@@ -52,6 +52,19 @@ public:
      */
     virtual void PollEvents() = 0;
 
+    /**
+     * Blocks until there are events for PollEvents, Wake is called or timeout seconds pass.
+     * Leaves the events for PollEvents to handle.
+     *
+     * @param timeout negative waits with no time limit
+     */
+    virtual void WaitEvents(float64 timeout) = 0;
+
+    /**
+     * Makes WaitEvents return, can be called from any thread
+     */
+    virtual void Wake() = 0;
+
     /**
      * Call to render to screen
      */
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+
+#include "Types.h"
+
+namespace Core
+{
+
+/**
+ * Read-only view of an entire file mapped into memory.
+ * The bytes are not null terminated, always use GetSize().
+ */
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    /**
+     * Maps a file into memory, closing any previously mapped file
+     *
+     * @return true if the file could be mapped
+     */
+    bool Open(const std::string& filename);
+
+    /**
+     * Unmaps the file
+     */
+    void Close();
+
+    /**
+     * @return true if a file is currently mapped
+     */
+    bool IsOpen() const { return mOpen; }
+
+    /**
+     * @return pointer to the first byte of the file, null if the file is empty
+     */
+    const char* GetData() const { return mData; }
+
+    /**
+     * @return size of the file in bytes
+     */
+    uint64 GetSize() const { return mSize; }
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool mOpen;
+    const char* mData;
+    uint64 mSize;
+#ifdef _WIN32
+    void* mFile;
+    void* mMapping;
+#else // UNIX
+    int mFd;
+#endif
+};
+
+}
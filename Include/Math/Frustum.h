@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Types.h"
+#include "Matrix4.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+namespace Core
+{
+
+namespace Math
+{
+
+/**
+ * The six planes around the volume a projection * view matrix shows, for skipping objects that
+ * can't be seen before drawing them.
+ *
+ * @tparam Type type for the plane values
+ */
+template <typename Type>
+class Frustum
+{
+public:
+	Frustum() {}
+
+	/**
+	 * Finds the planes of a projection * view matrix, points it maps to -w <= x, y, z <= w are inside
+	 */
+	Frustum(const Matrix4<Type>& clip)
+	{
+		//rows of the column major matrix, every plane is the w row plus or minus another one
+		Vector4<Type> rows[4];
+		for (uint i = 0; i < 4; i++)
+		{
+			rows[i] = Vector4<Type>(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+		}
+
+		for (uint i = 0; i < 3; i++)
+		{
+			mPlanes[i * 2] = rows[3] + rows[i];
+			mPlanes[i * 2 + 1] = rows[3] - rows[i];
+		}
+
+		//normalized so distances to the planes are in world units
+		for (uint i = 0; i < 6; i++)
+		{
+			Type length = Length(Vector3<Type>(mPlanes[i].X, mPlanes[i].Y, mPlanes[i].Z));
+			if (length > 0) mPlanes[i] /= length;
+		}
+	}
+
+	/**
+	 * @return false if a sphere is entirely outside the volume, true if some of it may be inside
+	 */
+	bool Intersects(const Vector3<Type>& center, Type radius) const
+	{
+		for (uint i = 0; i < 6; i++)
+		{
+			const Vector4<Type>& plane = mPlanes[i];
+			if (plane.X * center.X + plane.Y * center.Y + plane.Z * center.Z + plane.W < -radius) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @return plane i as (normal, distance), the left, right, bottom, top, near and far planes in
+	 *         that order, normals point inside
+	 */
+	const Vector4<Type>& GetPlane(uint i) const { return mPlanes[i]; }
+private:
+	Vector4<Type> mPlanes[6];
+};
+
+typedef Frustum<float32> Frustumf;
+typedef Frustum<float64> Frustumd;
+
+}
+
+}
@@ -4,6 +4,7 @@
 #include <cmath>
 
 #include "Types.h"
+#include "Simd.h"
 #include "Vector3.h"
 #include "Vector4.h"
 
@@ -324,6 +325,27 @@ struct Matrix4
     }
 };
 
+#ifdef CORE_MATH_SIMD
+//float32 matrix product, every column is a sum of this matrix's columns scaled by the other's
+template <>
+inline Matrix4<float32>& Matrix4<float32>::operator*=(const Matrix4<float32>& m)
+{
+	Simd::Float4 c0 = Simd::Load(&mMatrix[0].X);
+	Simd::Float4 c1 = Simd::Load(&mMatrix[1].X);
+	Simd::Float4 c2 = Simd::Load(&mMatrix[2].X);
+	Simd::Float4 c3 = Simd::Load(&mMatrix[3].X);
+	for(int32 i = 0; i < 4; ++i)
+	{
+		Simd::Float4 column = Simd::Mul(c0, Simd::Splat(m.mMatrix[i].X));
+		column = Simd::Add(column, Simd::Mul(c1, Simd::Splat(m.mMatrix[i].Y)));
+		column = Simd::Add(column, Simd::Mul(c2, Simd::Splat(m.mMatrix[i].Z)));
+		column = Simd::Add(column, Simd::Mul(c3, Simd::Splat(m.mMatrix[i].W)));
+		Simd::Store(&mMatrix[i].X, column);
+	}
+	return *this;
+}
+#endif
+
 //Macro to define all standard math for the matrix
 CORE_MATH_GEN_MATRIX_OPERATORS(Matrix4);
 
@@ -344,6 +366,20 @@ Vector4<Type> operator*(const Matrix4<Type>& m, const Vector4<Type2>& v)
 	return ret;
 }
 
+#ifdef CORE_MATH_SIMD
+inline Vector4<float32> operator*(const Matrix4<float32>& m, const Vector4<float32>& v)
+{
+	Simd::Float4 ret = Simd::Mul(Simd::Load(&m.mMatrix[0].X), Simd::Splat(v.X));
+	ret = Simd::Add(ret, Simd::Mul(Simd::Load(&m.mMatrix[1].X), Simd::Splat(v.Y)));
+	ret = Simd::Add(ret, Simd::Mul(Simd::Load(&m.mMatrix[2].X), Simd::Splat(v.Z)));
+	ret = Simd::Add(ret, Simd::Mul(Simd::Load(&m.mMatrix[3].X), Simd::Splat(v.W)));
+
+	Vector4<float32> result;
+	Simd::Store(&result.X, ret);
+	return result;
+}
+#endif
+
 /**
  * Returns the inverse of a 4x4 Matrix
  *
@@ -454,6 +490,10 @@ Matrix4<Type> Inverse(Matrix4<Type> m)
             int32 xx = 0;
             for(int32 x = 0; x < 4; ++x)
             {
+                // the minor leaves out row i, copying it too would write past m3 when i is the last row
+                if(x == i)
+                    continue;
+
                 int32 yy = 0;
                 for(int32 y = 0; y < 4; ++y)
                 {
@@ -462,8 +502,7 @@ Matrix4<Type> Inverse(Matrix4<Type> m)
                         yy += 1;
                     }
                 }
-                if(x != i)
-                    xx += 1;
+                xx += 1;
             }
             inverse[i][j] = std::pow(-1,i+j) * Math::Determinant(m3);
         }
@@ -475,6 +514,84 @@ Matrix4<Type> Inverse(Matrix4<Type> m)
     return inverse;
 }
 
+#ifdef CORE_MATH_SIMD
+namespace Simd
+{
+
+/**
+ * Returns the 2x2 minors of rows a and b taken from columns (2, 2, 1, 1) and (3, 3, 3, 2) in turn,
+ * see Inverse
+ */
+template <uint A, uint B>
+inline Float4 InverseFactor(Float4 c1, Float4 c2, Float4 c3)
+{
+	Float4 a21 = Shuffle<A, A, A, A>(c2, c1);
+	Float4 b32 = Shuffle<B, B, B, B>(c3, c2);
+	Float4 a32 = Shuffle<A, A, A, A>(c3, c2);
+	Float4 b21 = Shuffle<B, B, B, B>(c2, c1);
+	return Sub(Mul(a21, Shuffle<0, 0, 0, 2>(b32, b32)), Mul(Shuffle<0, 0, 0, 2>(a32, a32), b21));
+}
+
+/**
+ * Returns (column 1, column 0, column 0, column 0) of row r
+ */
+template <uint R>
+inline Float4 InverseRow(Float4 c0, Float4 c1)
+{
+	Float4 r10 = Shuffle<R, R, R, R>(c1, c0);
+	return Shuffle<0, 2, 2, 2>(r10, r10);
+}
+
+}
+
+//float32 inverse by cofactors, the 2x2 minors of the bottom rows are shared by the four columns
+template <>
+inline Matrix4<float32> Inverse(Matrix4<float32> m)
+{
+	using namespace Simd;
+
+	Float4 c0 = Load(&m.mMatrix[0].X);
+	Float4 c1 = Load(&m.mMatrix[1].X);
+	Float4 c2 = Load(&m.mMatrix[2].X);
+	Float4 c3 = Load(&m.mMatrix[3].X);
+
+	Float4 fac0 = InverseFactor<2, 3>(c1, c2, c3);
+	Float4 fac1 = InverseFactor<1, 3>(c1, c2, c3);
+	Float4 fac2 = InverseFactor<1, 2>(c1, c2, c3);
+	Float4 fac3 = InverseFactor<0, 3>(c1, c2, c3);
+	Float4 fac4 = InverseFactor<0, 2>(c1, c2, c3);
+	Float4 fac5 = InverseFactor<0, 1>(c1, c2, c3);
+
+	Float4 row0 = InverseRow<0>(c0, c1);
+	Float4 row1 = InverseRow<1>(c0, c1);
+	Float4 row2 = InverseRow<2>(c0, c1);
+	Float4 row3 = InverseRow<3>(c0, c1);
+
+	Float4 signA = Set(1, -1, 1, -1);
+	Float4 signB = Set(-1, 1, -1, 1);
+	Float4 inv0 = Mul(signA, Add(Sub(Mul(row1, fac0), Mul(row2, fac1)), Mul(row3, fac2)));
+	Float4 inv1 = Mul(signB, Add(Sub(Mul(row0, fac0), Mul(row2, fac3)), Mul(row3, fac4)));
+	Float4 inv2 = Mul(signA, Add(Sub(Mul(row0, fac1), Mul(row1, fac3)), Mul(row3, fac5)));
+	Float4 inv3 = Mul(signB, Add(Sub(Mul(row0, fac2), Mul(row1, fac4)), Mul(row2, fac5)));
+
+	//first row of the inverse times the first column gives the determinant
+	Float4 firstRow = Shuffle<0, 2, 0, 2>(Shuffle<0, 0, 0, 0>(inv0, inv1), Shuffle<0, 0, 0, 0>(inv2, inv3));
+	float32 determinant = Dot(c0, firstRow);
+	if(determinant == 0)
+	{
+		return Matrix4<float32>(0); //return zero matrix
+	}
+
+	Float4 scale = Splat(determinant);
+	Matrix4<float32> inverse;
+	Store(&inverse.mMatrix[0].X, Div(inv0, scale));
+	Store(&inverse.mMatrix[1].X, Div(inv1, scale));
+	Store(&inverse.mMatrix[2].X, Div(inv2, scale));
+	Store(&inverse.mMatrix[3].X, Div(inv3, scale));
+	return inverse;
+}
+#endif
+
 }
 
 }
@@ -7,3 +7,4 @@
 #include "Math/MatrixMath.h"
 #include "Math/Quaternion.h"
 #include "Math/Transform.h"
+#include "Math/Frustum.h"
@@ -3,6 +3,7 @@
 #include <cmath>
 
 #include "Types.h"
+#include "Simd.h"
 #include "Vector3.h"
 #include "Vector4.h"
 #include "Matrix4.h"
@@ -216,6 +217,32 @@ struct Quaternion
     }
 };
 
+#ifdef CORE_MATH_SIMD
+namespace Simd
+{
+
+/**
+ * Returns the product of two quaternions stored X, Y, Z, W, summed in the same order as
+ * Quaternion::operator*=
+ */
+inline Float4 QuaternionProduct(Float4 a, Float4 b)
+{
+	Float4 product = Mul(SplatLane<3>(a), b);
+	product = Add(product, Mul(Mul(Shuffle<0, 1, 2, 0>(a, a), Shuffle<3, 3, 3, 0>(b, b)), Set(1, 1, 1, -1)));
+	product = Add(product, Mul(Mul(Shuffle<1, 2, 0, 1>(a, a), Shuffle<2, 0, 1, 1>(b, b)), Set(1, 1, 1, -1)));
+	return Sub(product, Mul(Shuffle<2, 0, 1, 2>(a, a), Shuffle<1, 2, 0, 2>(b, b)));
+}
+
+}
+
+template <>
+inline Quaternion<float32>& Quaternion<float32>::operator*=(const Quaternion<float32>& q)
+{
+	Simd::Store(&X, Simd::QuaternionProduct(Simd::Load(&X), Simd::Load(&q.X)));
+	return *this;
+}
+#endif
+
 //Multiplying overloads
 template <typename Type, typename Type2>
 Quaternion<Type> operator*(Quaternion<Type> q, const Quaternion<Type2>& r)
@@ -355,6 +382,34 @@ Vector3<Type> Rotate(Vector3<Type> v, Quaternion<Type> q)
 	return Vector3<Type>(res.X, res.Y, res.Z);
 }
 
+#ifdef CORE_MATH_SIMD
+inline Quaternion<float32> Normalize(const Quaternion<float32> q)
+{
+	Simd::Float4 lanes = Simd::Load(&q.X);
+	float32 len = Simd::Dot(lanes, lanes);
+
+	Quaternion<float32> ret(0, 0, 0, 0);
+	if (len != 0.0)
+	{
+		Simd::Store(&ret.X, Simd::Div(lanes, Simd::Splat(std::sqrt(len))));
+	}
+	return ret;
+}
+
+inline Vector3<float32> Rotate(Vector3<float32> v, Quaternion<float32> q)
+{
+	Simd::Float4 rotation = Simd::Load(&q.X);
+	Simd::Float4 inverse = Simd::Div(Simd::Mul(rotation, Simd::Set(-1, -1, -1, 1)), Simd::Splat(Simd::Dot(rotation, rotation)));
+
+	Simd::Float4 res = Simd::QuaternionProduct(rotation, Simd::Set(v.X, v.Y, v.Z, 0));
+	res = Simd::QuaternionProduct(res, inverse);
+
+	float32 lanes[4];
+	Simd::Store(lanes, res);
+	return Vector3<float32>(lanes[0], lanes[1], lanes[2]);
+}
+#endif
+
 //To string
 template <typename Type>
 std::ostream& operator<<(std::ostream& out, const Quaternion<Type>& q)
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "Types.h"
+
+//Picks the instruction set the float32 vector and matrix kernels use, CORE_MATH_SIMD is left
+//undefined when there is none or CORE_MATH_NO_SIMD is defined, the plain templates are used then
+#if !defined(CORE_MATH_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CORE_MATH_SIMD 1
+#define CORE_MATH_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define CORE_MATH_SIMD 1
+#define CORE_MATH_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+#ifdef CORE_MATH_SIMD
+
+namespace Core
+{
+
+namespace Math
+{
+
+/**
+ * Four float32 lanes in one register, wrapping the intrinsics of each instruction set so the
+ * kernels in Matrix4.h, Vector4.h and Quaternion.h are only written once.
+ *
+ * Loads and stores are unaligned, Vector4 and Matrix4 aren't 16 byte aligned. Products and sums
+ * are separate instructions, never fused, so results round like the plain templates do.
+ */
+namespace Simd
+{
+
+#if defined(CORE_MATH_SSE)
+typedef __m128 Float4;
+#else
+typedef float32x4_t Float4;
+#endif
+
+/**
+ * Loads four consecutive floats, like the X, Y, Z, W of a Vector4
+ */
+inline Float4 Load(const float32* p)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_loadu_ps(p);
+#else
+	return vld1q_f32(p);
+#endif
+}
+
+inline void Store(float32* p, Float4 a)
+{
+#if defined(CORE_MATH_SSE)
+	_mm_storeu_ps(p, a);
+#else
+	vst1q_f32(p, a);
+#endif
+}
+
+/**
+ * Returns (x, y, z, w)
+ */
+inline Float4 Set(float32 x, float32 y, float32 z, float32 w)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_setr_ps(x, y, z, w);
+#else
+	const float32 values[4] = { x, y, z, w };
+	return vld1q_f32(values);
+#endif
+}
+
+/**
+ * Returns s in every lane
+ */
+inline Float4 Splat(float32 s)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_set1_ps(s);
+#else
+	return vdupq_n_f32(s);
+#endif
+}
+
+inline Float4 Add(Float4 a, Float4 b)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_add_ps(a, b);
+#else
+	return vaddq_f32(a, b);
+#endif
+}
+
+inline Float4 Sub(Float4 a, Float4 b)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_sub_ps(a, b);
+#else
+	return vsubq_f32(a, b);
+#endif
+}
+
+inline Float4 Mul(Float4 a, Float4 b)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_mul_ps(a, b);
+#else
+	return vmulq_f32(a, b);
+#endif
+}
+
+inline Float4 Div(Float4 a, Float4 b)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_div_ps(a, b);
+#else
+	return vdivq_f32(a, b);
+#endif
+}
+
+inline Float4 Min(Float4 a, Float4 b)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_min_ps(a, b);
+#else
+	return vminq_f32(a, b);
+#endif
+}
+
+inline Float4 Max(Float4 a, Float4 b)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_max_ps(a, b);
+#else
+	return vmaxq_f32(a, b);
+#endif
+}
+
+inline Float4 Sqrt(Float4 a)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_sqrt_ps(a);
+#else
+	return vsqrtq_f32(a);
+#endif
+}
+
+/**
+ * Returns all bits set in the lanes where a > b and zero in the others, for And
+ */
+inline Float4 Greater(Float4 a, Float4 b)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_cmpgt_ps(a, b);
+#else
+	return vreinterpretq_f32_u32(vcgtq_f32(a, b));
+#endif
+}
+
+/**
+ * Returns the bits of a and b and-ed together, a masked by Greater keeps the lanes that passed
+ */
+inline Float4 And(Float4 a, Float4 b)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_and_ps(a, b);
+#else
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#endif
+}
+
+/**
+ * Returns (a[A0], a[A1], b[B0], b[B1])
+ */
+template <uint A0, uint A1, uint B0, uint B1>
+inline Float4 Shuffle(Float4 a, Float4 b)
+{
+#if defined(CORE_MATH_SSE)
+	return _mm_shuffle_ps(a, b, _MM_SHUFFLE(B1, B0, A1, A0));
+#else
+	Float4 r = vdupq_n_f32(vgetq_lane_f32(a, A0));
+	r = vsetq_lane_f32(vgetq_lane_f32(a, A1), r, 1);
+	r = vsetq_lane_f32(vgetq_lane_f32(b, B0), r, 2);
+	return vsetq_lane_f32(vgetq_lane_f32(b, B1), r, 3);
+#endif
+}
+
+/**
+ * Returns lane I of a in every lane
+ */
+template <uint I>
+inline Float4 SplatLane(Float4 a)
+{
+	return Shuffle<I, I, I, I>(a, a);
+}
+
+/**
+ * Returns (a[0] + a[1]) + (a[2] + a[3])
+ */
+inline float32 Sum(Float4 a)
+{
+#if defined(CORE_MATH_SSE)
+	Float4 pairs = _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehl_ps(pairs, pairs)));
+#else
+	float32x2_t pairs = vpadd_f32(vget_low_f32(a), vget_high_f32(a));
+	return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+#endif
+}
+
+inline float32 Dot(Float4 a, Float4 b)
+{
+	return Sum(Mul(a, b));
+}
+
+}
+
+}
+
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <iostream>
 
 #include "Types.h"
+#include "Simd.h"
 #include "_math_define.h"
 
 namespace Core
@@ -127,6 +128,21 @@ Vector4<Type> Normalize(const Vector4<Type>& v)
     }
 }
 
+#ifdef CORE_MATH_SIMD
+inline Vector4<float32> Normalize(const Vector4<float32>& v)
+{
+	Simd::Float4 lanes = Simd::Load(&v.X);
+	float32 len = Simd::Dot(lanes, lanes);
+
+	Vector4<float32> ret(0);
+	if (len != 0.0)
+	{
+		Simd::Store(&ret.X, Simd::Div(lanes, Simd::Splat(std::sqrt(len))));
+	}
+	return ret;
+}
+#endif
+
 //To string
 template <typename Type>
 std::ostream& operator<<(std::ostream& out, const Vector4<Type>& v)
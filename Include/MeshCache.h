@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "MappedFile.h"
+#include "MeshData.h"
+#include "Types.h"
+#include "VertexFormat.h"
+
+namespace Core
+{
+
+/**
+ * Binary cache of the vertex and index arrays built from a model file.
+ * The cache lives next to the model as <model>.m3dcache and is only used while the model's
+ * size, modification time and a sampled content hash still match. A valid cache is mapped
+ * into memory so its arrays can be handed straight to a vertex or index buffer.
+ */
+class MeshCache
+{
+public:
+    /** Bump when the cache layout changes */
+    static const uint32 Version = 2;
+
+    MeshCache();
+    ~MeshCache();
+
+    /**
+     * Maps the cache for a model file
+     *
+     * @param source path of the model file the cache was built from
+     * @param buildKey identifies how the arrays were built, a cache with a different key is stale
+     * @return true if an up to date cache exists and was mapped
+     */
+    bool Open(const std::string& source, uint32 buildKey);
+
+    /**
+     * Unmaps the cache
+     */
+    void Close();
+
+    /**
+     * @return true if a cache is mapped
+     */
+    bool IsOpen() const { return mHeader != nullptr; }
+
+    /**
+     * @return format of the cached vertices
+     */
+    const Video::VertexFormat& GetFormat() const { return mFormat; }
+
+    uint64 GetVertexCount() const;
+    const float32* GetVertices() const;
+
+    uint64 GetIndexCount() const;
+    const uint32* GetIndices() const;
+
+    uint64 GetLodCount() const;
+    const MeshLod* GetLods() const;
+
+    /**
+     * @return the mapped arrays, valid until the cache is closed
+     */
+    MeshView GetMesh() const;
+
+    /**
+     * Writes the cache for a model file, replacing any old one
+     *
+     * @param source path of the model file the arrays were built from
+     * @param buildKey identifies how the arrays were built
+     * @param mesh arrays built from the model
+     * @param cancelled stops the write and removes what was written once it is set
+     * @return true if the cache was written
+     */
+    static bool Write(const std::string& source, uint32 buildKey, const MeshData& mesh,
+            const std::atomic<bool>* cancelled = nullptr);
+
+    /**
+     * @return path of the cache file for a model file
+     */
+    static std::string GetCachePath(const std::string& source);
+private:
+    struct Header;
+
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    MappedFile mFile;
+    const Header* mHeader;
+    Video::VertexFormat mFormat;
+};
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include "Types.h"
+#include "VertexFormat.h"
+
+namespace Core
+{
+
+/**
+ * One level of detail of a mesh, a range of the mesh's index array
+ */
+struct MeshLod
+{
+    uint32 IndexStart;
+    uint32 IndexCount;
+    /** Roughly how far in model units this level strays from the full detail surface */
+    float32 Error;
+};
+
+/**
+ * Vertex and index arrays ready to be uploaded to the GPU. Lods lists the levels of detail
+ * from full detail down, every level's indices point into the shared vertex array.
+ */
+struct MeshData
+{
+    Video::VertexFormat Format;
+    std::vector<float32> Vertices;
+    std::vector<uint32> Indices;
+    std::vector<MeshLod> Lods;
+    uint VertexCount = 0;
+};
+
+/**
+ * The arrays of a mesh without owning them, like the ones a mapped mesh cache holds, so they can be
+ * uploaded without copying them first
+ */
+struct MeshView
+{
+    Video::VertexFormat Format;
+    const float32* Vertices;
+    uint VertexCount;
+    const uint32* Indices;
+    uint IndexCount;
+    const MeshLod* Lods;
+    uint LodCount;
+
+    MeshView()
+        : Format(), Vertices(nullptr), VertexCount(0), Indices(nullptr), IndexCount(0), Lods(nullptr), LodCount(0)
+    {
+    }
+
+    MeshView(const MeshData& mesh)
+        : Format(mesh.Format),
+          Vertices(mesh.Vertices.data()),
+          VertexCount(mesh.VertexCount),
+          Indices(mesh.Indices.data()),
+          IndexCount(mesh.Indices.size()),
+          Lods(mesh.Lods.data()),
+          LodCount(mesh.Lods.size())
+    {
+    }
+};
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Types.h"
+
+namespace Core
+{
+
+namespace MeshOptimizer
+{
+
+/**
+ * How well an index buffer uses the GPU's post-transform vertex cache
+ */
+struct VertexCacheStats
+{
+    /** Average cache misses per triangle, 0.5 is the best a large closed mesh can do and 3 the worst */
+    float32 Acmr;
+    /** Average times each vertex is transformed, 1 is the best */
+    float32 Atvr;
+};
+
+/**
+ * Simulates a FIFO vertex cache over an index buffer
+ *
+ * @param cacheSize entries in the simulated cache, 16 is typical of real hardware
+ */
+VertexCacheStats AnalyzeVertexCache(const uint32* indices, uint indexCount, uint vertexCount, uint cacheSize = 16);
+
+/**
+ * Reorders triangles so they reuse recently transformed vertices, using Tom Forsyth's
+ * linear-speed vertex cache optimization
+ *
+ * @param indices 3 per triangle, each below vertexCount, reordered in place
+ */
+void OptimizeVertexCache(uint32* indices, uint indexCount, uint vertexCount);
+
+/**
+ * Reorders clusters of triangles so outward facing parts of the model are drawn first and hide
+ * what is behind them from any view, without giving up much vertex cache locality (Sander et al.).
+ * Run after OptimizeVertexCache.
+ *
+ * @param indices 3 per triangle, reordered in place
+ * @param vertices stride floats per vertex, starting with x, y, z
+ * @param threshold how much worse than the cache optimized order a cluster's ACMR may get, 1.05 allows 5%
+ */
+void OptimizeOverdraw(uint32* indices, uint indexCount, const float32* vertices, uint vertexCount, uint stride,
+        float32 threshold = 1.05f);
+
+/**
+ * Reorders vertices to the order the index buffer first uses them in, so vertex fetches walk
+ * memory forwards, and drops vertices that aren't used
+ *
+ * @param vertices stride floats per vertex, reordered in place
+ * @param indices rewritten to the new vertex order
+ * @return number of vertices left at the start of vertices
+ */
+uint OptimizeVertexFetch(float32* vertices, uint vertexCount, uint stride, uint32* indices, uint indexCount);
+
+}
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+
+#include "Math/ModelerMath.h"
+
+#include "Types.h"
+
+namespace Core
+{
+
+/**
+ * Reduces a triangle mesh by collapsing edges, cheapest first by quadric error (Garland and Heckbert).
+ * Instead of a priority queue, passes over the triangles collapse every edge under an error threshold
+ * that grows each pass, which keeps memory flat and scales to meshes with tens of millions of triangles.
+ * Simplify can be called again with a smaller target to continue from the current result, which
+ * is how a chain of levels of detail is built.
+ */
+class MeshSimplifier
+{
+public:
+    /**
+     * @param positions x, y, z for each of vertexCount vertices, vertices should be welded by position
+     * @param indices 3 per triangle, each below vertexCount
+     */
+    MeshSimplifier(const float32* positions, uint vertexCount, const uint32* indices, uint indexCount);
+
+    /**
+     * Collapses edges until at most targetTriangles are left, or no more edges can be collapsed
+     * without folding the surface over
+     *
+     * @return number of triangles left
+     */
+    uint Simplify(uint targetTriangles);
+
+    /**
+     * @return number of triangles left
+     */
+    uint GetTriangleCount() const { return mTriangles.size() - mDeletedTriangles; }
+
+    /**
+     * @return largest distance, in the units of the input positions, that a collapse has moved the surface
+     */
+    float32 GetError() const;
+
+    /**
+     * Copies out the simplified mesh, only vertices that are still used are kept
+     *
+     * @param refPositions receives x, y, z per vertex
+     * @param refIndices receives 3 indices per triangle
+     */
+    void GetMesh(std::vector<float32>& refPositions, std::vector<uint32>& refIndices) const;
+private:
+    /**
+     * Symmetric 4x4 matrix, the sum of squared distances to a set of planes
+     */
+    struct Quadric
+    {
+        float64 M[10];
+
+        Quadric();
+        Quadric(float64 a, float64 b, float64 c, float64 d);
+
+        float64 Det(uint a11, uint a12, uint a13, uint a21, uint a22, uint a23, uint a31, uint a32, uint a33) const;
+        float64 Error(const Math::Vector3f& p) const;
+
+        Quadric& operator+=(const Quadric& q);
+    };
+
+    struct Vertex
+    {
+        Math::Vector3f Position;
+        Quadric Q;
+        uint32 RefStart;
+        uint32 RefCount;
+        bool Border;
+    };
+
+    struct Triangle
+    {
+        uint32 V[3];
+        /** Cost of collapsing each edge, then the cheapest of the three */
+        float32 Error[4];
+        Math::Vector3f Normal;
+        bool Deleted;
+        bool Dirty;
+    };
+
+    /** A triangle using a vertex, and which of the triangle's corners the vertex is */
+    struct Ref
+    {
+        uint32 Face;
+        uint32 Corner;
+    };
+
+    float64 EdgeError(uint32 v0, uint32 v1, Math::Vector3f& refPosition) const;
+    void UpdateErrors(Triangle& refTriangle) const;
+    bool Flips(const Math::Vector3f& position, uint32 v0, uint32 v1, std::vector<bool>& refDeleted) const;
+    void UpdateTriangles(uint32 v0, const Vertex& vertex, const std::vector<bool>& deleted);
+    void Compact();
+    void BuildRefs();
+    void FindBorders();
+
+    std::vector<Vertex> mVertices;
+    std::vector<Triangle> mTriangles;
+    std::vector<Ref> mRefs;
+    uint mDeletedTriangles;
+    float64 mMaxError;
+    /** Positions are moved to the origin and scaled to fit a unit box so thresholds don't depend on model size */
+    Math::Vector3f mCenter;
+    float32 mScale;
+};
+
+}
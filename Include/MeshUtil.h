@@ -0,0 +1,145 @@
+#pragma once
+
+#include <vector>
+
+#include "Math/ModelerMath.h"
+#include "Types.h"
+
+namespace Core
+{
+
+namespace MeshUtil
+{
+
+/**
+ * Count vectors of 3 floats the batch functions below read or write, either interleaved with
+ * other attributes or kept in separate x, y and z arrays. Vector i is X[i * Stride], Y[i * Stride]
+ * and Z[i * Stride], see Interleaved and Separate.
+ *
+ * The batch functions split large arrays across the job system and process four vectors at a time
+ * where every array is separate. Their output holds as many vectors as the input and can be the
+ * input itself, but must not overlap it any other way.
+ *
+ * @tparam Float float32 for vectors that are written, const float32 for ones that are only read
+ */
+template <typename Float>
+struct Vector3Array
+{
+    Float* X;
+    Float* Y;
+    Float* Z;
+    /** Floats from one vector to the next */
+    uint Stride;
+    uint Count;
+
+    Vector3Array(Float* x, Float* y, Float* z, uint stride, uint count)
+        : X(x), Y(y), Z(z), Stride(stride), Count(count) {}
+
+    /**
+     * Lets writable vectors be passed where read only ones are expected
+     */
+    template <typename Other>
+    Vector3Array(const Vector3Array<Other>& other)
+        : X(other.X), Y(other.Y), Z(other.Z), Stride(other.Stride), Count(other.Count) {}
+};
+
+typedef Vector3Array<float32> Vector3Span;
+typedef Vector3Array<const float32> ConstVector3Span;
+
+/**
+ * Vectors stored x, y, z at the start of each vertex
+ *
+ * @param stride floats per vertex, 3 for bare positions, 6 for a position and a normal
+ */
+inline Vector3Span Interleaved(float32* data, uint count, uint stride = 3)
+{
+    return Vector3Span(data, data + 1, data + 2, stride, count);
+}
+
+inline ConstVector3Span Interleaved(const float32* data, uint count, uint stride = 3)
+{
+    return ConstVector3Span(data, data + 1, data + 2, stride, count);
+}
+
+/**
+ * Vectors stored as separate arrays of x, y and z, which the batch functions process four at a time
+ */
+inline Vector3Span Separate(float32* x, float32* y, float32* z, uint count)
+{
+    return Vector3Span(x, y, z, 1, count);
+}
+
+inline ConstVector3Span Separate(const float32* x, const float32* y, const float32* z, uint count)
+{
+    return ConstVector3Span(x, y, z, 1, count);
+}
+
+/**
+ * Transforms positions by a matrix, taking w as 1 and dropping the result's w, so for affine
+ * matrices. Matches m * Vector4f(x, y, z, 1) exactly.
+ */
+void TransformPoints(const Math::Matrix4f& m, const ConstVector3Span& in, const Vector3Span& out);
+
+/**
+ * Transforms directions by a matrix, taking w as 0 so translation is ignored. Normals need the
+ * inverse transpose of a matrix that doesn't scale evenly, followed by NormalizeArray.
+ */
+void TransformDirections(const Math::Matrix4f& m, const ConstVector3Span& in, const Vector3Span& out);
+
+/**
+ * Rotates vectors by a quaternion, through its rotation matrix
+ */
+void TransformDirections(const Math::Quaternionf& q, const ConstVector3Span& in, const Vector3Span& out);
+
+/**
+ * Scales vectors to unit length in place, zero vectors stay zero like Math::Normalize
+ */
+void NormalizeArray(const Vector3Span& vectors);
+
+/**
+ * Writes the cross product of each pair of vectors of a and b to out
+ */
+void CrossArray(const ConstVector3Span& a, const ConstVector3Span& b, const Vector3Span& out);
+
+/**
+ * Writes the dot product of each pair of vectors of a and b to out, which holds a.Count floats
+ */
+void DotArray(const ConstVector3Span& a, const ConstVector3Span& b, float32* out);
+
+/**
+ * Finds the axis aligned box around vectors
+ *
+ * @param refLow receives the smallest x, y and z
+ * @param refHigh receives the largest x, y and z
+ * @return false if there are no vectors, leaving refLow and refHigh alone
+ */
+bool ComputeBounds(const ConstVector3Span& vectors, Math::Vector3f& refLow, Math::Vector3f& refHigh);
+
+/**
+ * Merges vertices with identical contents into an indexed mesh. Vertices are compared
+ * bit for bit, except that 0 and -0 are treated as the same value.
+ *
+ * @param vertices vertexCount vertices of floatsPerVertex floats each, every 3 make a triangle
+ * @param refUnique receives each distinct vertex once, in order of first use
+ * @param refIndices receives one index into refUnique per input vertex
+ */
+void WeldVertices(const float32* vertices, uint vertexCount, uint floatsPerVertex,
+        std::vector<float32>& refUnique, std::vector<uint32>& refIndices);
+
+/**
+ * Builds a vertex with a smooth normal for every vertex of an indexed triangle list. Each face's
+ * normal is weighted by the face's angle at the vertex, and a vertex is split where faces around
+ * it meet at more than creaseAngle. Runs in parallel over face and vertex ranges.
+ *
+ * @param positions x, y, z for each of vertexCount vertices
+ * @param indices 3 per triangle, each below vertexCount
+ * @param creaseAngle in radians, pi keeps every vertex smooth
+ * @param refVertices receives x, y, z, nx, ny, nz per output vertex, unused positions are dropped
+ * @param refIndices receives the triangles pointing into refVertices
+ */
+void GenerateNormals(const float32* positions, uint vertexCount, const uint32* indices, uint indexCount,
+        float32 creaseAngle, std::vector<float32>& refVertices, std::vector<uint32>& refIndices);
+
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "FileIO.h"
+#include "MeshCache.h"
+#include "MeshData.h"
+#include "ThreadUtil.h"
+#include "Types.h"
+
+namespace Core
+{
+
+/**
+ * Loads model files as a job so the update loop keeps running.
+ * The job reads the mesh cache or parses and builds the model, then queues a main thread job that
+ * hands the finished mesh to the upload function, the only part that touches the graphics device.
+ */
+class ModelLoader
+{
+public:
+    enum class State
+    {
+        Idle,
+        /** Building the mesh or waiting for it to be uploaded */
+        Loading,
+        Done,
+        Failed,
+        Cancelled
+    };
+
+    /**
+     * Called on the main thread with each finished mesh and the file it was loaded from, the mesh's
+     * arrays are only valid during the call
+     */
+    typedef std::function<void(const std::string& file, const MeshView& mesh)> UploadFunction;
+
+    /**
+     * @param upload called from Thread::RunMainThreadJobs, never after the load was cancelled or
+     *        the loader destroyed
+     */
+    ModelLoader(const UploadFunction& upload);
+
+    /**
+     * Cancels any running load and waits for its job to stop
+     */
+    ~ModelLoader();
+
+    /**
+     * Starts loading a model in the background, cancelling the current load if there is one. The
+     * new load starts once the cancelled one stops, the calling thread doesn't wait for it.
+     */
+    void Load(const std::string& file);
+
+    /**
+     * Asks the current load to stop, the state becomes Cancelled once the job notices
+     */
+    void Cancel();
+
+    /**
+     * Sets the angle in degrees above which faces stop sharing generated normals, used by the next load.
+     * 180 shades every model smooth, 0 shades it flat. Normals stored in the file are always kept.
+     */
+    void SetCreaseAngle(uint32 degrees);
+
+    /**
+     * @return crease angle in degrees
+     */
+    uint32 GetCreaseAngle() const { return mCreaseAngle; }
+
+    /**
+     * Sets whether the next load reorders triangles and vertices for the GPU's vertex cache and to
+     * reduce overdraw. On by default, turning it off keeps the order the model was built in.
+     */
+    void SetOptimize(bool optimize) { mOptimize = optimize; }
+
+    /**
+     * @return true if loads reorder meshes for drawing
+     */
+    bool GetOptimize() const { return mOptimize; }
+
+    /**
+     * @return what the loader is doing
+     */
+    State GetState() const { return mTask ? mTask->Status.load() : State::Idle; }
+
+    /**
+     * @return how much of the current load is done, from 0 to 1
+     */
+    float32 GetProgress() const { return mTask ? mTask->Progress.GetFraction() : 0.0f; }
+private:
+    /**
+     * One load, shared by the job building it and the main thread job uploading it so neither
+     * depends on the loader still being around
+     */
+    struct Task
+    {
+        std::string File;
+        uint32 CreaseAngle;
+        bool Optimize;
+        ObjLoadProgress Progress;
+        std::atomic<State> Status;
+        /** Built mesh, empty when the cache was used */
+        MeshData Mesh;
+        /** Mapped cache the mesh is uploaded from without copying it, if it was up to date */
+        MeshCache Cache;
+    };
+
+    ModelLoader(const ModelLoader&) = delete;
+    ModelLoader& operator=(const ModelLoader&) = delete;
+
+    /**
+     * Builds the task's mesh on a worker, then queues its upload
+     */
+    static void Run(const std::shared_ptr<Task>& task, const UploadFunction& upload);
+
+    /**
+     * Hands the task's mesh to upload on the main thread unless the load was cancelled
+     */
+    static void Upload(const std::shared_ptr<Task>& task, const UploadFunction& upload);
+
+    void Join();
+
+    UploadFunction mUpload;
+    Thread::JobHandle mJob;
+    std::shared_ptr<Task> mTask;
+    uint32 mCreaseAngle;
+    bool mOptimize;
+};
+
+}
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <map>
+#include <string>
+
 #include "Application.h"
 #include "Camera.h"
+#include "MeshData.h"
+#include "Scene.h"
 #include "Types.h"
 
+#include "GUI/Button.h"
 #include "GUI/Environment.h"
 #include "SDL2/SdlMouse.h"
 
@@ -17,6 +23,8 @@ class GuiRenderer;
 namespace Core
 {
 
+class ModelLoader;
+
 /**
  * 3D modeler class
  */
@@ -41,43 +49,75 @@ public:
      */
     virtual void OnRender();
 
+    /**
+     * Saves the screenshot if one was asked for
+     */
+    virtual void OnLastFrame();
+
     /**
      * Called when application is closing
      */
     virtual void OnDestroy();
 
+    /**
+     * @return false while a model is loading or waiting to be uploaded
+     */
+    virtual bool IsReady() const;
+
+    /**
+     * Saves the last frame of a SetFrameLimit run as a PNG
+     */
+    void SetScreenshot(const std::string& file) { mScreenshot = file; }
+
+    /**
+     * @return true once the screenshot has been written
+     */
+    bool IsScreenshotSaved() const { return mScreenshotSaved; }
+
     /**
      * Sets camera zoom level
      */
     void SetZoom(float32 zoom);
 
     /**
-     * Loads a .obj model into the program
+     * Starts loading a .obj model in the background, it's added next to the other models once it's
+     * done. A file that was loaded before is added again right away, sharing the mesh already
+     * uploaded. Can be called before Start.
      */
     void LoadObj(const std::string& file);
 
+    /**
+     * Removes every model
+     */
+    void Clear();
+
+    /**
+     * Stops the model that is loading, the current model is kept
+     */
+    void CancelLoad();
+
     /**
      * @return zoom level
      */
     float32 GetZoom() const { return mZoom; }
 
     /**
-     * @return model color
+     * @return color of the model added last
      */
     Math::Vector3f GetColor() const { return mColor; }
 
     /**
-     * Set model color
+     * Set the color of the model added last, and of the ones added after it
      */
     void SetColor(Math::Vector3f color);
 
     /**
-     * @return model scale
+     * @return scale of every model
      */
     Math::Vector3f GetScale() const { return mScale; }
 
     /**
-     * Set the model's scale
+     * Set the scale of every model
      */
     void SetScale(Math::Vector3f scale);
 
@@ -87,17 +127,43 @@ public:
     Camera* GetCamera() { return mCamera; }
 
 private:
+    /**
+     * Shows load progress
+     */
+    void UpdateLoad();
+
+    /**
+     * Uploads a mesh the loader finished and adds a model drawing it, called on the main thread
+     */
+    void UploadMesh(const std::string& file, const MeshView& data);
+
+    /**
+     * Adds a model drawing mesh to the right of the others, the first one is at the origin
+     */
+    void AddModel(Scene::MeshId mesh);
+
     Gui::Environment* mEnv;
     Video::GuiRenderer* mGuiRenderer;
     Video::IShader* mShader;
-    Video::IGeometry* mGeometry;
-    Video::IVertexBuffer* mVbo;
+    /** mShader for copies of the same model, drawn as instances */
+    Video::IShader* mInstancedShader;
+    Scene* mScene;
+    /** Meshes in the scene by the file they were loaded from */
+    std::map<std::string, Scene::MeshId> mMeshes;
+    /** Model added last, the one color changes apply to */
+    Scene::ObjectId mSelected;
+    /** Largest x of the models added so far, the next one goes to the right of it */
+    float32 mRightEdge;
+    ModelLoader* mLoader;
+    Gui::Button* mLoadStatus;
     float32 mAngle;
     SdlMouse* mMouse;
     Camera* mCamera;
     float32 mZoom;
     Math::Vector3f mColor;
     Math::Vector3f mScale;
+    std::string mScreenshot;
+    bool mScreenshotSaved;
 };
 
 }
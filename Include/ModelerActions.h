@@ -28,8 +28,6 @@ public:
     void OnActionPerformed(Gui::Widget* widget)
     {
         std::cout << "Loading file: " << mFile << std::endl;
-        if(mFile == "Assets/dragon-big.obj")
-        	std::cout << "Note, dragon-big.obj is very large and can take up to 30sec to load" << std::endl;
         mModeler->LoadObj(mFile);
     }
 private:
@@ -37,6 +35,42 @@ private:
     std::string mFile;
 };
 
+/**
+ * Action called when the button for cancelling a load is clicked.
+ */
+class CancelLoadAction : public Gui::IAction
+{
+public:
+    CancelLoadAction(Modeler3D* modeler) : mModeler(modeler) {}
+    ~CancelLoadAction() {}
+
+    void OnActionPerformed(Gui::Widget* widget)
+    {
+        std::cout << "Cancelling load" << std::endl;
+        mModeler->CancelLoad();
+    }
+private:
+    Modeler3D* mModeler;
+};
+
+/**
+ * Action called when the button for removing every model is clicked.
+ */
+class ClearAction : public Gui::IAction
+{
+public:
+    ClearAction(Modeler3D* modeler) : mModeler(modeler) {}
+    ~ClearAction() {}
+
+    void OnActionPerformed(Gui::Widget* widget)
+    {
+        std::cout << "Clearing models" << std::endl;
+        mModeler->Clear();
+    }
+private:
+    Modeler3D* mModeler;
+};
+
 /**
  * Action called when the zoom button is clicked.
  */
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "IGraphicsDevice.h"
+#include "Types.h"
+
+#include "OGL/OglState.h"
+
+namespace Video
+{
+
+/**
+ * GL buffer object behind the vertex and index buffers, uploads data the way its BufferHint asks for.
+ *
+ * Static buffers are written straight to the GPU and keep no copy, reading them asks the driver.
+ * Dynamic buffers keep a copy in memory so reads are free. BufferShadow overrides either.
+ * Stream buffers are a ring of regions in one buffer object. Writing from the start begins a new
+ * region, so the GPU can still draw the last one while it is written, and the buffer is orphaned
+ * when the ring wraps around. Draws have to add GetBindOffset() to their offsets into it.
+ */
+class OglBuffer
+{
+public:
+    /**
+     * @param state state of the context the buffer is created in
+     * @param target GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+     * @param size bytes that can be written
+     */
+    OglBuffer(OglState* state, GLenum target, uint64 size, BufferHint hint, BufferShadow shadow = BufferShadow::Default);
+    ~OglBuffer();
+
+    void Release();
+
+    GLuint GetId() const { return mId; }
+    uint64 GetSize() const { return mSize; }
+    BufferHint GetHint() const { return mHint; }
+    bool HasShadow() const { return !mShadow.empty(); }
+
+    /**
+     * @return memory used by every buffer that hasn't been released
+     */
+    static BufferMemoryStats GetMemoryStats() { return sMemory; }
+
+    /**
+     * @return byte offset in the buffer object where the data currently starts
+     */
+    uint64 GetBindOffset() const { return mRegionOffset; }
+
+    void Read(uint64 offset, void* out, uint64 size) const;
+    void Write(uint64 offset, const void* in, uint64 size);
+private:
+    OglBuffer(const OglBuffer&) = delete;
+    OglBuffer& operator=(const OglBuffer&) = delete;
+
+    void Orphan();
+
+    OglState* mState;
+    GLenum mTarget;
+    uint64 mSize;
+    BufferHint mHint;
+    /** Bytes in the buffer object, more than mSize for a ring */
+    uint64 mCapacity;
+    uint64 mRegionOffset;
+    bool mRegionWritten;
+    std::vector<uint8> mShadow;
+    GLuint mId;
+
+    static BufferMemoryStats sMemory;
+};
+
+}
@@ -6,9 +6,11 @@
 
 #include "OGL/OglGeometry.h"
 #include "OGL/OglShader.h"
+#include "OGL/OglState.h"
 #include "OGL/OglTexture2D.h"
+#include "OGL/OglVertexBuffer.h"
 
-namespace Core { class Sdl2Window; }
+namespace Core { class IWindow; }
 
 namespace Video
 {
@@ -16,7 +18,7 @@ namespace Video
 class OglGraphicsDevice : public IGraphicsDevice
 {
 public:
-    OglGraphicsDevice(Core::Sdl2Window* window);
+    OglGraphicsDevice(Core::IWindow* window);
     ~OglGraphicsDevice();
 
     void Init();
@@ -25,14 +27,19 @@ public:
     virtual float32 GetHeight() const ;
     virtual float32 GetAspectRatio() const;
 
-    IVertexBuffer* CreateVertexBuffer(VertexFormat format, uint count, BufferHint hint = BufferHint::Dynamic);
-    IIndexBuffer* CreateIndexBuffer(uint count, BufferHint hint = BufferHint::Dynamic);
+    IVertexBuffer* CreateVertexBuffer(VertexFormat format, uint count, BufferHint hint = BufferHint::Dynamic,
+            BufferShadow shadow = BufferShadow::Default);
+    IIndexBuffer* CreateIndexBuffer(uint count, BufferHint hint = BufferHint::Dynamic, IndexFormat format = IndexFormat::UInt32,
+            BufferShadow shadow = BufferShadow::Default);
+    BufferMemoryStats GetBufferMemory() const;
     IShader* CreateShader(const std::string& vertex, const std::string& fragment);
     IGeometry* CreateGeometry();
     ITexture2D* CreateTexture2D(const std::string& filename);
+    ITexture2D* CreateTexture2D(uint width, uint height);
 
     void SetClearColor(float32 r, float32 g, float32 b, float32 a = 1.0);
     void Clear(bool color = true, bool depth = true);
+    void ReadPixels(std::vector<uint8>& refPixels, uint& refWidth, uint& refHeight);
 
     const IGeometry* GetGeometry() const { return mGeometry; }
     IGeometry* GetGeometry() { return mGeometry; }
@@ -47,13 +54,52 @@ public:
 
     void Draw(Primitive prim, uint start, uint primCount);
     void DrawIndices(Primitive prim, uint start, uint primCount);
+    void DrawInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount);
+    void DrawIndicesInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount);
 
     float32 Ratio = 1.3333;
 private:
-    Core::Sdl2Window* mWindow = nullptr;
+    /**
+     * Attribute of an instanced vertex buffer, set as a constant for each instance when the context
+     * can't draw instances itself
+     */
+    struct InstanceAttribute
+    {
+        GLint Location;
+        /** Where the first instance's value is in mInstanceData */
+        uint Offset;
+        /** Floats from one instance's value to the next */
+        uint Stride;
+        uint Count;
+    };
+
+    /**
+     * Binds the shader, textures and vertex attributes the next draw uses, skipping what is already bound
+     *
+     * @param firstInstance vertex of the instanced vertex buffers to start from
+     * @param instanceCount instances the draw reads, when the context can't draw instances itself
+     *        they are read from the instanced vertex buffers into mInstanceData
+     * @return false if there is no geometry or shader to draw with, or mInstanceData can't be read
+     */
+    bool BindState(uint firstInstance = 0, uint instanceCount = 1);
+
+    /**
+     * Sets the constant attributes of mInstanceAttributes to one instance's values
+     *
+     * @param instance instance of the draw, 0 is the one at firstInstance
+     */
+    void SetInstanceAttributes(uint instance);
+
+    Core::IWindow* mWindow = nullptr;
+    /** Bindings of this device's context */
+    OglState mState;
     OglGeometry* mGeometry = nullptr;
     OglShader* mShader = nullptr;
     std::vector<OglTexture2D*> mTextures;
+    /** Instanced attributes of the last BindState, empty when the context draws instances itself */
+    std::vector<InstanceAttribute> mInstanceAttributes;
+    /** Instanced vertices the last BindState read */
+    std::vector<float32> mInstanceData;
 };
 
 }
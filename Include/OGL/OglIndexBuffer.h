@@ -1,32 +1,39 @@
 #pragma once
 
-#include <vector>
-
 #include <GL/glew.h>
 
 #include "IIndexBuffer.h"
 
+#include "OGL/OglBuffer.h"
+
 namespace Video
 {
 
 class OglIndexBuffer : public IIndexBuffer
 {
 public:
-    OglIndexBuffer(uint length);
+    OglIndexBuffer(OglState* state, uint length, IndexFormat format = IndexFormat::UInt32,
+            BufferHint hint = BufferHint::Dynamic, BufferShadow shadow = BufferShadow::Default);
     ~OglIndexBuffer();
 
     void Release();
 
     uint GetLength() const { return mLength; }
+    IndexFormat GetFormat() const { return mFormat; }
 
     void GetData(uint32* out, uint start, uint count) const;
     void SetData(const uint32* in, uint start, uint count);
 
-    GLuint GetId() const { return mId; }
+    GLuint GetId() const { return mBuffer.GetId(); }
+
+    /**
+     * @return byte offset of the first index in the buffer object
+     */
+    uint64 GetBindOffset() const { return mBuffer.GetBindOffset(); }
 private:
     uint mLength;
-    std::vector<uint32> mIndices;
-    GLuint mId;
+    IndexFormat mFormat;
+    OglBuffer mBuffer;
 };
 
 }
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include <GL/glew.h>
 
 #include "IShader.h"
+#include "VertexFormat.h"
+
+#include "OGL/OglState.h"
 
 namespace Video
 {
@@ -10,7 +17,10 @@ namespace Video
 class OglShader : public IShader
 {
 public:
-    OglShader(const std::string& vs, const std::string& fs);
+    /**
+     * @param state state of the context the program is created in
+     */
+    OglShader(OglState* state, const std::string& vs, const std::string& fs);
     ~OglShader();
 
     void Release();
@@ -20,20 +30,65 @@ public:
     const std::string& GetVertexSource() const { return mVertexSource; }
     const std::string& GetFragmentSource() const { return mFragmentSource; }
 
-    void SetMatrix4f(const std::string& name, const Core::Math::Matrix4f& mat);
-    void SetMatrix3f(const std::string& name, const Core::Math::Matrix3f& mat);
-    void SetVector4f(const std::string& name, const Core::Math::Vector4f& vec);
-    void SetVector3f(const std::string& name, const Core::Math::Vector3f& vec);
-    void SetVector2f(const std::string& name, const Core::Math::Vector2f& vec);
-    void SetFloat32(const std::string& name, float32 f);
-    void SetInt32(const std::string& name, int32 i);
+    /**
+     * @return location of the attribute's input in the vertex shader, -1 if the shader doesn't use it
+     */
+    GLint GetAttributeLocation(Attribute attrib) const { return mAttributeLocations[static_cast<uint>(attrib)]; }
+
+    UniformHandle GetUniform(const std::string& name) const;
+
+    using IShader::SetMatrix4f;
+    using IShader::SetMatrix3f;
+    using IShader::SetVector4f;
+    using IShader::SetVector3f;
+    using IShader::SetVector2f;
+    using IShader::SetFloat32;
+    using IShader::SetInt32;
+
+    void SetMatrix4f(UniformHandle uniform, const Core::Math::Matrix4f& mat);
+    void SetMatrix3f(UniformHandle uniform, const Core::Math::Matrix3f& mat);
+    void SetVector4f(UniformHandle uniform, const Core::Math::Vector4f& vec);
+    void SetVector3f(UniformHandle uniform, const Core::Math::Vector3f& vec);
+    void SetVector2f(UniformHandle uniform, const Core::Math::Vector2f& vec);
+    void SetFloat32(UniformHandle uniform, float32 f);
+    void SetInt32(UniformHandle uniform, int32 i);
+
+    /**
+     * Sends uniforms that changed since the last draw, the program must be current
+     */
+    void ApplyUniforms();
 private:
     GLuint CompileShader(const std::string& source, GLenum type, const std::string& typeName);
     bool LinkProgram(GLuint vertex, GLuint fragment);
+    void FindAttributeLocations();
+    void FindUniforms();
+    void SetUniform(UniformHandle uniform, GLenum type, const void* value);
+
+    /**
+     * Uniform found after linking, its value is staged in mUniformValues
+     */
+    struct Uniform
+    {
+        GLint Location;
+        GLenum Type;
+        /** First of the uniform's values in mUniformValues */
+        uint Offset;
+        /** 32 bit floats or ints in the value */
+        uint Size;
+        bool Dirty;
+    };
 
+    OglState* mState;
     GLuint mId = 0;
     std::string mVertexSource;
     std::string mFragmentSource;
+    /** Looked up once after linking, draws happen too often to ask the driver every time */
+    GLint mAttributeLocations[AttributeCount];
+    std::vector<Uniform> mUniforms;
+    std::unordered_map<std::string, int32> mUniformIndices;
+    std::vector<uint32> mUniformValues;
+    /** Indices of uniforms with values that haven't been sent */
+    std::vector<int32> mDirtyUniforms;
 };
 
 }
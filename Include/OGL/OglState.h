@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <GL/glew.h>
+
+#include "Types.h"
+
+namespace Video
+{
+
+/**
+ * Remembers what is bound in a GL context so binds that wouldn't change anything are skipped.
+ * Every context has its own bindings, so each graphics device owns the state of its context.
+ * Everything in the OGL backend that binds programs or textures or sets up vertex attributes
+ * goes through the device's state, and tells it when one of those is deleted, otherwise the
+ * remembered state would be wrong.
+ */
+class OglState
+{
+public:
+    /** Texture units the graphics device binds */
+    static const uint TextureUnitCount = 16;
+
+    /** Vertex attribute locations the state keeps track of, one bit each in the masks below */
+    static const uint AttributeLocationCount = 32;
+
+    OglState();
+
+    /**
+     * Makes a program current if it isn't already
+     */
+    void UseProgram(GLuint program);
+
+    /**
+     * Call before deleting a program
+     */
+    void ProgramDeleted(GLuint program);
+
+    /**
+     * Binds a 2D texture to a texture unit if it isn't bound there already
+     */
+    void BindTexture(uint unit, GLuint texture);
+
+    /**
+     * Binds a 2D texture to whichever unit is active so it can be changed, without activating another unit
+     */
+    void BindTextureForEdit(GLuint texture);
+
+    /**
+     * Call before deleting a texture, GL unbinds it from every unit
+     */
+    void TextureDeleted(GLuint texture);
+
+    /**
+     * Points a vertex attribute at floats in a buffer, unless it already reads them from there with
+     * the same layout. Draws that keep their geometry and shader set no attribute pointer at all.
+     *
+     * @param offset bytes from the start of the buffer object to the attribute in the first vertex
+     */
+    void SetAttributePointer(GLuint location, GLuint buffer, GLint count, GLsizei stride, uintptr_t offset);
+
+    /**
+     * Call before deleting a buffer, GL stops attributes from reading it
+     */
+    void BufferDeleted(GLuint buffer);
+
+    /**
+     * Enables the vertex attribute arrays whose bit is set and disables the rest
+     *
+     * @param mask bit n is attribute location n
+     */
+    void SetAttributeArrays(uint32 mask);
+
+    /**
+     * Makes the vertex attributes whose bit is set advance once per instance and the rest once per
+     * vertex, only call it when the context has GL 3.3 or ARB_instanced_arrays
+     *
+     * @param mask bit n is attribute location n
+     */
+    void SetAttributeDivisors(uint32 mask);
+private:
+    struct AttributePointer
+    {
+        GLuint Buffer;
+        GLint Count;
+        GLsizei Stride;
+        uintptr_t Offset;
+    };
+
+    OglState(const OglState&) = delete;
+    OglState& operator=(const OglState&) = delete;
+
+    GLuint mProgram;
+    uint mActiveUnit;
+    GLuint mTextures[TextureUnitCount];
+    /** Buffer 0 means the pointer isn't known and is set by the next SetAttributePointer */
+    AttributePointer mAttributePointers[AttributeLocationCount];
+    uint32 mAttributeArrays;
+    uint32 mAttributeDivisors;
+};
+
+}
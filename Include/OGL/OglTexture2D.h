@@ -4,13 +4,18 @@
 
 #include "ITexture2D.h"
 
+#include "OGL/OglState.h"
+
 namespace Video
 {
 
 class OglTexture2D : public ITexture2D
 {
 public:
-    OglTexture2D(uint width, uint height);
+    /**
+     * @param state state of the context the texture is created in
+     */
+    OglTexture2D(OglState* state, uint width, uint height);
     ~OglTexture2D();
 
     void Release();
@@ -23,6 +28,7 @@ public:
 
     GLuint GetId() const { return mId; }
 private:
+    OglState* mState;
     GLuint mId;
     uint mWidth, mHeight;
 };
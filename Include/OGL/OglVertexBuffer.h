@@ -1,18 +1,19 @@
 #pragma once
 
-#include <vector>
-
 #include <GL/glew.h>
 
 #include "IVertexBuffer.h"
 
+#include "OGL/OglBuffer.h"
+
 namespace Video
 {
 
 class OglVertexBuffer : public IVertexBuffer
 {
 public:
-    OglVertexBuffer(VertexFormat format, uint length);
+    OglVertexBuffer(OglState* state, VertexFormat format, uint length, BufferHint hint = BufferHint::Dynamic,
+            BufferShadow shadow = BufferShadow::Default);
     ~OglVertexBuffer();
 
     void Release();
@@ -24,12 +25,16 @@ public:
     void GetData(float32* out, uint start, uint count) const;
     void SetData(const float32* in, uint start, uint count);
 
-    GLuint GetId() const { return mId; }
+    GLuint GetId() const { return mBuffer.GetId(); }
+
+    /**
+     * @return byte offset of the first vertex in the buffer object
+     */
+    uint64 GetBindOffset() const { return mBuffer.GetBindOffset(); }
 private:
     VertexFormat mFormat;
     uint mLength;
-    std::vector<uint8> mData;
-    GLuint mId;
+    OglBuffer mBuffer;
 };
 
 }
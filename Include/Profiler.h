@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+
+#include "Types.h"
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+/**
+ * Records the time from here to the end of the enclosing scope as a zone named name,
+ * which has to be a string literal
+ */
+#define PROFILE_ZONE(name) Core::Profiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+namespace Core
+{
+
+/**
+ * Records how long named zones of code take on each thread, to be exported as a Chrome trace
+ * that chrome://tracing or ui.perfetto.dev show as a timeline.
+ *
+ * Every thread writes to its own event buffer, only the thread itself adds to it so recording
+ * takes no locks. Nothing is recorded until Start is called, a zone then costs two clock reads.
+ */
+namespace Profiler
+{
+
+/**
+ * Scoped zone, see PROFILE_ZONE
+ */
+class Zone
+{
+public:
+    /**
+     * @param name kept as a pointer, so it has to outlive the recording, like a string literal
+     */
+    explicit Zone(const char* name);
+    ~Zone();
+private:
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+    const char* mName;
+    uint64 mStart;
+};
+
+/**
+ * Starts recording zones and counters, on top of what was recorded before
+ */
+void Start();
+
+/**
+ * Stops recording, zones that are open still finish
+ */
+void Stop();
+
+/**
+ * @return true between Start and Stop
+ */
+bool IsRecording();
+
+/**
+ * Records a value that changes over time, like frames per second, shown as a graph
+ *
+ * @param name kept as a pointer like a zone's name
+ */
+void Counter(const char* name, float64 value);
+
+/**
+ * Names the calling thread in the trace, threads are numbered otherwise
+ */
+void SetThreadName(const std::string& name);
+
+/**
+ * @return events recorded on all threads, each thread keeps at most about a million
+ */
+uint64 GetEventCount();
+
+/**
+ * Writes everything recorded so far as Chrome trace JSON, can be called while recording
+ *
+ * @return false if the file can't be written
+ */
+bool Export(const std::string& file);
+
+}
+
+}
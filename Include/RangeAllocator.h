@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+
+#include "Types.h"
+
+namespace Core
+{
+
+/**
+ * Hands out ranges of a fixed number of items, like the vertices of a buffer shared by many meshes.
+ *
+ * Free ranges are kept sorted by where they start, Allocate takes the first one that is big enough
+ * and Free merges a range back with the free ranges on either side of it.
+ */
+class RangeAllocator
+{
+public:
+    /** Returned by Allocate when no free range is big enough */
+    static const uint32 Invalid = 0xFFFFFFFF;
+
+    /**
+     * @param capacity number of items, all of them start out free
+     */
+    RangeAllocator(uint32 capacity = 0);
+
+    /**
+     * @return first item of count consecutive items, Invalid if there isn't room for them
+     */
+    uint32 Allocate(uint32 count);
+
+    /**
+     * Gives back a range Allocate returned
+     */
+    void Free(uint32 start, uint32 count);
+
+    uint32 GetCapacity() const { return mCapacity; }
+
+    /**
+     * @return items not in any allocated range
+     */
+    uint32 GetFreeCount() const { return mFreeCount; }
+
+    /**
+     * @return count of the biggest range Allocate can return right now
+     */
+    uint32 GetLargestFree() const;
+
+    /**
+     * @return true if nothing is allocated
+     */
+    bool IsEmpty() const { return mFreeCount == mCapacity; }
+private:
+    /** First item of each free range to its count */
+    std::map<uint32, uint32> mFree;
+    uint32 mCapacity;
+    uint32 mFreeCount;
+};
+
+}
@@ -36,6 +36,8 @@ public:
     virtual SDL_GLContext GetOglContext() { return mContext; }
 
     virtual void PollEvents();
+    virtual void WaitEvents(float64 timeout);
+    virtual void Wake();
     virtual void SwapBuffers();
 
     float32 GetAspectRatio()
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "IGraphicsDevice.h"
+#include "MeshData.h"
+#include "RangeAllocator.h"
+#include "TransformHierarchy.h"
+#include "Types.h"
+
+#include "Math/ModelerMath.h"
+
+namespace Core
+{
+
+/**
+ * Objects to draw, each a mesh with its own transform, color and shader.
+ *
+ * Meshes are packed into pages, a vertex buffer and an index buffer of PageVertexCount vertices
+ * shared by every mesh with the same vertex format, so drawing hundreds of parts doesn't mean
+ * switching between hundreds of buffers. A mesh too big for a page gets a page of its own.
+ * The same mesh can be drawn by any number of objects.
+ *
+ * Render skips objects outside the view, picks each object's level of detail and sorts what is
+ * left by shader and page, so the shader and geometry only change when they have to. Objects that
+ * share a mesh, level of detail and shader are drawn together as instances, in a single draw,
+ * when the shader has an instanced version, see SetInstancedShader.
+ */
+class Scene
+{
+public:
+    typedef uint32 MeshId;
+    typedef uint32 ObjectId;
+
+    /** Never a valid mesh or object */
+    static const uint32 None = 0xFFFFFFFF;
+
+    /** Vertices in a shared page, as many as 16 bit indices reach */
+    static const uint32 PageVertexCount = 0x10000;
+
+    /** Indices in a shared page */
+    static const uint32 PageIndexCount = 0x60000;
+
+    /** Fewest objects drawn as instances instead of one by one */
+    static const uint32 MinInstanceCount = 2;
+
+    /**
+     * Camera Render draws from
+     */
+    struct RenderView
+    {
+        Math::Matrix4f Projection;
+        Math::Matrix4f View;
+        Math::Vector3f Position;
+        bool Perspective;
+        /**
+         * Pixels one unit covers one unit in front of a perspective camera, or at any distance in
+         * front of an orthographic one
+         */
+        float32 PixelsPerUnit;
+        /** Levels of detail may stray this many pixels from the full detail mesh */
+        float32 LodPixelError;
+    };
+
+    /**
+     * What the last Render did
+     */
+    struct Stats
+    {
+        uint ObjectCount;
+        /** Objects that weren't culled */
+        uint VisibleCount;
+        uint DrawCount;
+        /** Times the shader or geometry was changed between draws */
+        uint StateChanges;
+        /** Objects drawn as instances, part of a single draw with others */
+        uint InstancedCount;
+        uint64 TriangleCount;
+        uint PageCount;
+    };
+
+    Scene(Video::IGraphicsDevice* graphics);
+
+    /**
+     * Releases every page
+     */
+    ~Scene();
+
+    /**
+     * Uploads a mesh into a page, meshes without indices are drawn as a list of triangles. The
+     * arrays are only read during the call.
+     *
+     * @return the mesh, None if it has no vertices
+     */
+    MeshId AddMesh(const MeshView& mesh);
+
+    /**
+     * Removes a mesh and every object that draws it, its page is released once it's empty
+     */
+    void RemoveMesh(MeshId mesh);
+
+    /**
+     * @return true if mesh was added and not removed since
+     */
+    bool IsValidMesh(MeshId mesh) const;
+
+    /**
+     * Finds the box around a mesh's vertices, in the mesh's own units, an empty box at the origin if
+     * mesh isn't valid
+     */
+    void GetMeshBounds(MeshId mesh, Math::Vector3f& refLow, Math::Vector3f& refHigh) const;
+
+    /**
+     * Adds an object at its parent's origin, white
+     *
+     * @param parent node the object moves with, GetRoot by default or if parent isn't valid
+     * @return the object, None if mesh isn't valid
+     */
+    ObjectId Add(MeshId mesh, Video::IShader* shader, TransformHierarchy::NodeId parent = TransformHierarchy::None);
+
+    /**
+     * Removes an object, its mesh stays. Objects added under its node, or under nodes below it, are
+     * removed with it since the node goes with everything below it.
+     */
+    void Remove(ObjectId object);
+
+    /**
+     * Removes every object and mesh
+     */
+    void Clear();
+
+    /**
+     * @return true if object was added and not removed since
+     */
+    bool IsValid(ObjectId object) const;
+
+    /**
+     * Setters ignore objects that aren't valid, getters return black, nullptr or None for them
+     */
+    void SetColor(ObjectId object, const Math::Vector3f& color);
+    Math::Vector3f GetColor(ObjectId object) const
+    {
+        return IsValid(object) ? mObjects[mObjectSlots[object]].Color : Math::Vector3f(0);
+    }
+
+    void SetShader(ObjectId object, Video::IShader* shader);
+    Video::IShader* GetShader(ObjectId object) const { return IsValid(object) ? mObjects[mObjectSlots[object]].Shader : nullptr; }
+
+    /**
+     * Lets objects drawn with shader be batched into instances drawn with instanced. It gets the
+     * Projection and View uniforms, and reads each object's model matrix, normal matrix and color
+     * from the aModel0 to aModel3, aNormalMat0 to aNormalMat2 and aColor attributes, the columns
+     * of the matrices.
+     *
+     * @param instanced nullptr to draw objects with shader one by one again
+     */
+    void SetInstancedShader(Video::IShader* shader, Video::IShader* instanced);
+
+    MeshId GetMesh(ObjectId object) const { return IsValid(object) ? mObjects[mObjectSlots[object]].Mesh : None; }
+
+    /**
+     * @return node holding the object's position, rotation and scale, see GetTransforms,
+     *         TransformHierarchy::None if object isn't valid
+     */
+    TransformHierarchy::NodeId GetNode(ObjectId object) const
+    {
+        return IsValid(object) ? mObjects[mObjectSlots[object]].Node : TransformHierarchy::None;
+    }
+
+    /**
+     * @return node every object is under unless it's added under another one, moving it moves everything
+     */
+    TransformHierarchy::NodeId GetRoot() const { return mRoot; }
+
+    TransformHierarchy& GetTransforms() { return mTransforms; }
+    const TransformHierarchy& GetTransforms() const { return mTransforms; }
+
+    /**
+     * @return number of objects
+     */
+    uint GetCount() const { return mObjects.size(); }
+
+    /**
+     * Draws every object that can be seen. Each shader gets the Projection, View, Model, NormalMat
+     * and Color uniforms, instanced shaders only get Projection and View.
+     */
+    void Render(const RenderView& view);
+
+    const Stats& GetStats() const { return mStats; }
+private:
+    /**
+     * Vertex and index buffers shared by the meshes in them
+     */
+    struct Page
+    {
+        Video::VertexFormat Format;
+        Video::IGeometry* Geometry;
+        /** The page's buffers followed by the instance buffer */
+        Video::IGeometry* InstancedGeometry;
+        Video::IVertexBuffer* Vbo;
+        Video::IIndexBuffer* Ibo;
+        RangeAllocator Vertices;
+        RangeAllocator Indices;
+        /** Holds a single mesh that doesn't fit in a shared page */
+        bool Dedicated;
+    };
+
+    struct MeshInfo
+    {
+        uint32 Page;
+        uint32 VertexStart;
+        uint32 VertexCount;
+        uint32 IndexStart;
+        uint32 IndexCount;
+        /** Ranges of the mesh's own indices, IndexStart is added when drawing */
+        std::vector<MeshLod> Lods;
+        Math::Vector3f Low;
+        Math::Vector3f High;
+        /** Sphere around the vertices, culling tests it */
+        Math::Vector3f Center;
+        float32 Radius;
+        bool Valid;
+    };
+
+    struct Object
+    {
+        ObjectId Id;
+        MeshId Mesh;
+        Video::IShader* Shader;
+        Math::Vector3f Color;
+        TransformHierarchy::NodeId Node;
+    };
+
+    /**
+     * Object that passed culling, sorted so objects sharing state are drawn one after another
+     */
+    struct Draw
+    {
+        Video::IShader* Shader;
+        uint32 Page;
+        uint32 Mesh;
+        uint32 Slot;
+        uint32 Lod;
+    };
+
+    /**
+     * Draws that share a mesh, level of detail and shader, one after another in mDraws
+     */
+    struct Batch
+    {
+        uint32 First;
+        uint32 Count;
+        /** nullptr when the draws are drawn one by one */
+        Video::IShader* Instanced;
+        /** Vertex of the instance buffer holding the first draw's instance */
+        uint32 InstanceStart;
+    };
+
+    /**
+     * @return instanced version of shader, nullptr if there is none
+     */
+    Video::IShader* FindInstancedShader(Video::IShader* shader) const;
+
+    /**
+     * Writes the instances of every batch that has an instanced shader to the instance buffer
+     */
+    void UploadInstances();
+
+    /**
+     * Points a page's instanced geometry at the current instance buffer
+     */
+    void BindInstances(Page& refPage);
+
+    /**
+     * @return page with room for the mesh, a new one if none has room
+     */
+    uint32 FindPage(const Video::VertexFormat& format, uint32 vertexCount, uint32 indexCount);
+
+    /**
+     * Frees the id of the object at a place in mObjects, its node has to be removed already
+     */
+    void RemoveSlot(uint32 slot);
+    void ReleasePage(uint32 page);
+
+    Video::IGraphicsDevice* mGraphics;
+    TransformHierarchy mTransforms;
+    TransformHierarchy::NodeId mRoot;
+
+    std::vector<Page> mPages;
+    std::vector<MeshInfo> mMeshes;
+    std::vector<MeshId> mFreeMeshes;
+
+    /** Objects in no particular order, removing one moves the last into its place */
+    std::vector<Object> mObjects;
+    /** Place in mObjects of each object id, None for ids that are free */
+    std::vector<uint32> mObjectSlots;
+    std::vector<ObjectId> mFreeObjects;
+
+    /** Shaders and their instanced versions */
+    std::vector<std::pair<Video::IShader*, Video::IShader*>> mInstancedShaders;
+    /** Model matrix, normal matrix and color of every instance drawn this frame */
+    Video::IVertexBuffer* mInstances;
+
+    /** Kept between frames so Render doesn't allocate */
+    std::vector<Draw> mDraws;
+    std::vector<Batch> mBatches;
+    std::vector<float32> mInstanceData;
+    Stats mStats;
+};
+
+}
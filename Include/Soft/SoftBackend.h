@@ -0,0 +1,30 @@
+#pragma once
+
+#include "IBackend.h"
+#include "Soft/SoftGraphicsDevice.h"
+#include "Soft/SoftWindow.h"
+
+namespace Core
+{
+
+/**
+ * Backend that draws offscreen on the CPU, for machines with neither a display nor OpenGL
+ */
+class SoftBackend : public IBackend
+{
+public:
+    SoftBackend(uint width = 800, uint height = 600);
+    ~SoftBackend();
+
+    void Init();
+    void Update(float64 dt) {}
+    void Destroy();
+
+    IWindow* GetWindow() { return &mWindow; }
+    Video::IGraphicsDevice* GetGraphicsDevice() { return &mGraphics; }
+private:
+    SoftWindow mWindow;
+    Video::SoftGraphicsDevice mGraphics;
+};
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "IGraphicsDevice.h"
+#include "Types.h"
+
+namespace Video
+{
+
+/**
+ * Memory behind the software vertex and index buffers. The rasterizer reads it in place,
+ * so there is only ever one copy whatever BufferHint and BufferShadow ask for.
+ */
+class SoftBuffer
+{
+public:
+    /**
+     * @param size bytes that can be written
+     */
+    SoftBuffer(uint64 size);
+    ~SoftBuffer();
+
+    void Release();
+
+    uint64 GetSize() const { return mData.size(); }
+
+    const uint8* GetData() const { return mData.data(); }
+
+    void Read(uint64 offset, void* out, uint64 size) const;
+    void Write(uint64 offset, const void* in, uint64 size);
+
+    /**
+     * @return memory used by every buffer that hasn't been released, counted as buffer object bytes
+     */
+    static BufferMemoryStats GetMemoryStats() { return sMemory; }
+private:
+    SoftBuffer(const SoftBuffer&) = delete;
+    SoftBuffer& operator=(const SoftBuffer&) = delete;
+
+    std::vector<uint8> mData;
+    bool mReleased;
+
+    static BufferMemoryStats sMemory;
+};
+
+}
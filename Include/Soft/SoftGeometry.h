@@ -0,0 +1,54 @@
+#pragma once
+
+#include "IGeometry.h"
+
+#include "Soft/SoftIndexBuffer.h"
+#include "Soft/SoftVertexBuffer.h"
+
+#include <vector>
+
+namespace Video
+{
+
+class SoftGeometry : public IGeometry
+{
+public:
+    SoftGeometry() {}
+    ~SoftGeometry() { Release(); }
+
+    void Release() { mVboList.clear(); mIbo = NULL; }
+
+    uint GetVertexBufferCount() const { return mVboList.size(); }
+    const IVertexBuffer* GetVertexBuffer(uint index) const { return mVboList[index]; }
+    IVertexBuffer* GetVertexBuffer(uint index) { return mVboList[index]; }
+
+    const IIndexBuffer* GetIndexBuffer() const { return mIbo; }
+    IIndexBuffer* GetIndexBuffer() { return mIbo; }
+
+    void SetVertexBuffers(IVertexBuffer** vbos, uint count)
+    {
+        mVboList.clear();
+        for (uint i = 0; i < count; i++)
+        {
+            SoftVertexBuffer* vbo = dynamic_cast<SoftVertexBuffer*>(vbos[i]);
+            if (vbo)
+            {
+                mVboList.push_back(vbo);
+            }
+        }
+    }
+    void SetVertexBuffer(IVertexBuffer* vbo)
+    {
+        SetVertexBuffers(&vbo, 1);
+    }
+
+    void SetIndexBuffer(IIndexBuffer* ibo)
+    {
+        mIbo = dynamic_cast<SoftIndexBuffer*>(ibo);
+    }
+private:
+    std::vector<SoftVertexBuffer*> mVboList;
+    SoftIndexBuffer* mIbo = NULL;
+};
+
+}
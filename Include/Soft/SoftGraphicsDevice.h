@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vector>
+
+#include "IGraphicsDevice.h"
+
+#include "Soft/SoftGeometry.h"
+#include "Soft/SoftRasterizer.h"
+#include "Soft/SoftShader.h"
+#include "Soft/SoftTexture2D.h"
+
+namespace Core { class IWindow; }
+
+namespace Video
+{
+
+/**
+ * Graphics device that draws on the CPU, for machines without OpenGL.
+ * Vertices are run through the shader's SoftProgram on the rasterizer's threads, then
+ * SoftRasterizer draws them into a framebuffer the size of the window.
+ */
+class SoftGraphicsDevice : public IGraphicsDevice
+{
+public:
+    SoftGraphicsDevice(Core::IWindow* window);
+    ~SoftGraphicsDevice();
+
+    void Init();
+
+    virtual float32 GetWidth() const;
+    virtual float32 GetHeight() const;
+    virtual float32 GetAspectRatio() const;
+
+    /**
+     * @return threads draws are split across
+     */
+    uint GetThreadCount() const { return mRasterizer.GetThreadCount(); }
+
+    IVertexBuffer* CreateVertexBuffer(VertexFormat format, uint count, BufferHint hint = BufferHint::Dynamic,
+            BufferShadow shadow = BufferShadow::Default);
+    IIndexBuffer* CreateIndexBuffer(uint count, BufferHint hint = BufferHint::Dynamic, IndexFormat format = IndexFormat::UInt32,
+            BufferShadow shadow = BufferShadow::Default);
+    BufferMemoryStats GetBufferMemory() const;
+    IShader* CreateShader(const std::string& vertex, const std::string& fragment);
+    IGeometry* CreateGeometry();
+    ITexture2D* CreateTexture2D(const std::string& filename);
+    ITexture2D* CreateTexture2D(uint width, uint height);
+
+    void SetClearColor(float32 r, float32 g, float32 b, float32 a = 1.0);
+    void Clear(bool color = true, bool depth = true);
+    void ReadPixels(std::vector<uint8>& refPixels, uint& refWidth, uint& refHeight);
+
+    const IGeometry* GetGeometry() const { return mGeometry; }
+    IGeometry* GetGeometry() { return mGeometry; }
+    const IShader* GetShader() const { return mShader; }
+    IShader* GetShader() { return mShader; }
+    const ITexture2D* GetTexture(uint index) const { return mTextures[index]; }
+    ITexture2D* GetTexture(uint index) { return mTextures[index]; }
+
+    void SetGeometry(IGeometry* geom);
+    void SetShader(IShader* shader);
+    void SetTexture(uint index, ITexture2D* tex);
+
+    void Draw(Primitive prim, uint start, uint primCount);
+    void DrawIndices(Primitive prim, uint start, uint primCount);
+    void DrawInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount);
+    void DrawIndicesInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount);
+private:
+    /**
+     * Where one attribute is read from, the first vertex buffer that has it
+     */
+    struct AttributeSource
+    {
+        const float32* Data;
+        /** Floats from one vertex to the next */
+        uint Stride;
+        uint Count;
+        /** Read once per instance instead of once per vertex */
+        bool Instanced;
+    };
+
+    /**
+     * Reads an attribute of a vertex, or of the instance if it's in an instanced vertex buffer
+     */
+    static void FetchAttribute(const AttributeSource& source, uint vertex, uint instance, float32* refValue);
+
+    /**
+     * Resizes the framebuffer to the window's size if it changed
+     */
+    void UpdateSize();
+
+    /**
+     * Runs the vertex stage on vertices [first, first + count) and draws the triangles, once for
+     * every instance
+     *
+     * @param indices 3 per triangle, relative to first, nullptr draws the vertices in order
+     */
+    void DrawVertices(uint first, uint count, const uint32* indices, uint triangleCount, uint instanceStart,
+            uint instanceCount);
+
+    /**
+     * @param refInstanceCount receives the number of vertices every instanced vertex buffer has
+     * @return number of vertices every other vertex buffer has
+     */
+    uint FindAttributes(AttributeSource* refSources, uint& refInstanceCount) const;
+
+    Core::IWindow* mWindow = nullptr;
+    SoftGeometry* mGeometry = nullptr;
+    SoftShader* mShader = nullptr;
+    std::vector<SoftTexture2D*> mTextures;
+    float32 mClearColor[4];
+    SoftRasterizer mRasterizer;
+    /** Kept between draws so their memory is reused */
+    std::vector<SoftVertex> mVertices;
+    std::vector<uint32> mIndices;
+};
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "IIndexBuffer.h"
+
+#include "Soft/SoftBuffer.h"
+
+namespace Video
+{
+
+class SoftIndexBuffer : public IIndexBuffer
+{
+public:
+    SoftIndexBuffer(uint length, IndexFormat format = IndexFormat::UInt32);
+    ~SoftIndexBuffer();
+
+    void Release();
+
+    uint GetLength() const { return mLength; }
+    IndexFormat GetFormat() const { return mFormat; }
+
+    void GetData(uint32* out, uint start, uint count) const;
+    void SetData(const uint32* in, uint start, uint count);
+
+    /**
+     * @return index at position i, whichever format the buffer uses
+     */
+    uint32 GetIndex(uint i) const
+    {
+        const uint8* data = mBuffer.GetData();
+        return mFormat == IndexFormat::UInt16 ? reinterpret_cast<const uint16*>(data)[i] : reinterpret_cast<const uint32*>(data)[i];
+    }
+private:
+    uint mLength;
+    IndexFormat mFormat;
+    SoftBuffer mBuffer;
+};
+
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "ThreadUtil.h"
+#include "Types.h"
+
+namespace Video
+{
+
+/** Most floats a vertex can pass on to be interpolated across its triangles */
+static const uint SoftMaxVaryings = 8;
+
+/**
+ * Vertex out of the vertex stage
+ */
+struct SoftVertex
+{
+    /** Clip space x, y, z, w */
+    float32 Position[4];
+    float32 Varyings[SoftMaxVaryings];
+};
+
+/**
+ * Colors the pixels of a draw
+ */
+class SoftPixelShader
+{
+public:
+    virtual ~SoftPixelShader() {}
+
+    /**
+     * @param varyings interpolated with perspective correction
+     * @param refColor receives RGBA from 0 to 1, blended over the pixel by its alpha
+     */
+    virtual void Shade(const float32* varyings, float32* refColor) const = 0;
+};
+
+/**
+ * Draws triangles into a color and depth buffer on the CPU.
+ *
+ * Each draw is done in passes on the job system's threads. Triangles are clipped, set up and binned
+ * into the screen tiles their bounds touch, then every tile is rasterized on its own so no two
+ * threads write the same pixel, in the order the triangles were drawn. Coverage is tested four
+ * pixels at a time with integer edge functions, in SSE2 where the compiler has it, on vertices
+ * snapped to 1/16 of a pixel so the top-left rule draws pixels on shared edges exactly once.
+ *
+ * The depth test and blending match what OglGraphicsDevice sets up: GL_LEQUAL, and
+ * GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA.
+ */
+class SoftRasterizer
+{
+public:
+    SoftRasterizer();
+
+    /**
+     * Reallocates the color and depth buffers, their contents are lost
+     */
+    void Resize(uint width, uint height);
+
+    uint GetWidth() const { return mWidth; }
+    uint GetHeight() const { return mHeight; }
+
+    /**
+     * @return threads draws are split across, the calling thread included
+     */
+    uint GetThreadCount() const { return Core::Thread::GetWorkerCount() + 1; }
+
+    /**
+     * @param color RGBA from 0 to 1 to fill the color buffer with, nullptr keeps it
+     * @param depth true to reset the depth buffer to the far plane
+     */
+    void Clear(const float32* color, bool depth);
+
+    /**
+     * @param refPixels receives RGBA pixels, top row first
+     */
+    void ReadPixels(std::vector<uint8>& refPixels) const;
+
+    /**
+     * Calls task(i) for every i below count on the job system, the calling thread helps,
+     * returns once every call is done
+     */
+    void Run(uint count, const std::function<void(uint)>& task);
+
+    /**
+     * Draws a list of triangles, returns once they are in the color and depth buffers
+     *
+     * @param indices 3 per triangle into vertices, nullptr draws the vertices in order
+     * @param varyingCount floats of each vertex's Varyings that are used
+     */
+    void DrawTriangles(const SoftVertex* vertices, const uint32* indices, uint triangleCount, uint varyingCount,
+            const SoftPixelShader& shader);
+private:
+    SoftRasterizer(const SoftRasterizer&) = delete;
+    SoftRasterizer& operator=(const SoftRasterizer&) = delete;
+
+    /**
+     * Triangle set up for rasterizing
+     */
+    struct Triangle
+    {
+        /** Edge functions A * x + B * y + C of 1/16 pixel positions, above 0 inside, top-left rule included in C */
+        int32 A[3], B[3];
+        int64 C[3];
+        /** Barycentrics of vertices 1 and 2 and the depth, X * x + Y * y + Z at pixel positions */
+        float32 Planes[3][3];
+        const SoftVertex* Vertices[3];
+        float32 InvW[3];
+        /** Pixels the triangle can cover, inside the screen */
+        int32 MinX, MinY, MaxX, MaxY;
+    };
+
+    /**
+     * Triangles set up by one task, clipping adds its new vertices here
+     */
+    struct Chunk
+    {
+        std::vector<Triangle> Triangles;
+        std::deque<SoftVertex> Clipped;
+    };
+
+    void SetupChunk(uint chunk, const SoftVertex* vertices, const uint32* indices, uint begin, uint end,
+            uint varyingCount);
+    void ClipTriangle(const SoftVertex* a, const SoftVertex* b, const SoftVertex* c, uint varyingCount, uint chunk);
+    void SetupTriangle(const SoftVertex* a, const SoftVertex* b, const SoftVertex* c, uint chunk);
+    void RasterizeTile(uint tile, const SoftPixelShader& shader, uint varyingCount);
+    void RasterizeTriangle(const Triangle& triangle, int32 tileX, int32 tileY, const SoftPixelShader& shader,
+            uint varyingCount);
+
+    uint mWidth, mHeight;
+    /** Pixels per row of the buffers, rounded up so four pixels can always be read at once */
+    uint mStride;
+    uint mTilesX, mTilesY;
+    /** Clip space x and y are clipped to this many times w, so snapped positions fit in 32 bit edge functions */
+    float32 mGuardX, mGuardY;
+    std::vector<uint8> mColor;
+    std::vector<float32> mDepth;
+
+    std::vector<Chunk> mChunks;
+    /** Triangles of each chunk in each tile, chunk * tile count + tile */
+    std::vector<std::vector<uint32>> mBins;
+    uint mChunkCount;
+
+};
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IShader.h"
+
+namespace Video
+{
+
+/**
+ * Shaders the software device knows how to run, GLSL itself can't run on the CPU
+ */
+enum class SoftProgram
+{
+    /** Modeler3D's model shader, transformed by Projection, View and Model and lit with LightDirection */
+    Lit,
+    /** Positions already in clip space, vertex color times Texture if the shader samples one */
+    Screen
+};
+
+/**
+ * Shader for the software device. Uniforms are found by reading the declarations in the
+ * GLSL source, defaults like "uniform vec3 LightDirection = vec3(...)" included, and the
+ * program that runs is picked from them: a shader with a NormalMat uniform is Lit,
+ * anything else is Screen. A shader that declares an aModel0 attribute is an instanced Lit
+ * shader, it reads its model matrix, normal matrix and color from the aModel, aNormalMat
+ * and aColor attributes instead of uniforms.
+ */
+class SoftShader : public IShader
+{
+public:
+    SoftShader(const std::string& vs, const std::string& fs);
+    ~SoftShader();
+
+    void Release();
+
+    const std::string& GetVertexSource() const { return mVertexSource; }
+    const std::string& GetFragmentSource() const { return mFragmentSource; }
+
+    SoftProgram GetProgram() const { return mProgram; }
+
+    /**
+     * @return true if the model matrix, normal matrix and color are attributes
+     */
+    bool IsInstanced() const { return mInstanced; }
+
+    UniformHandle GetUniform(const std::string& name) const;
+
+    using IShader::SetMatrix4f;
+    using IShader::SetMatrix3f;
+    using IShader::SetVector4f;
+    using IShader::SetVector3f;
+    using IShader::SetVector2f;
+    using IShader::SetFloat32;
+    using IShader::SetInt32;
+
+    void SetMatrix4f(UniformHandle uniform, const Core::Math::Matrix4f& mat);
+    void SetMatrix3f(UniformHandle uniform, const Core::Math::Matrix3f& mat);
+    void SetVector4f(UniformHandle uniform, const Core::Math::Vector4f& vec);
+    void SetVector3f(UniformHandle uniform, const Core::Math::Vector3f& vec);
+    void SetVector2f(UniformHandle uniform, const Core::Math::Vector2f& vec);
+    void SetFloat32(UniformHandle uniform, float32 f);
+    void SetInt32(UniformHandle uniform, int32 i);
+
+    /**
+     * Reads a uniform back for the draw, uniforms the shader doesn't declare read as identity or zero
+     */
+    Core::Math::Matrix4f GetMatrix4f(const std::string& name) const;
+    Core::Math::Matrix3f GetMatrix3f(const std::string& name) const;
+    Core::Math::Vector3f GetVector3f(const std::string& name) const;
+    int32 GetInt32(const std::string& name) const;
+
+    /**
+     * @return true if the shader declares the uniform
+     */
+    bool HasUniform(const std::string& name) const { return GetUniform(name).IsValid(); }
+private:
+    void FindUniforms(const std::string& source);
+    void SetUniform(UniformHandle uniform, uint size, const float32* value);
+    const float32* GetValue(const std::string& name, uint size) const;
+
+    struct Uniform
+    {
+        /** First of the uniform's values in mUniformValues */
+        uint Offset;
+        /** Floats in the value, ints are stored as floats */
+        uint Size;
+    };
+
+    std::string mVertexSource;
+    std::string mFragmentSource;
+    SoftProgram mProgram;
+    bool mInstanced;
+    std::vector<Uniform> mUniforms;
+    std::unordered_map<std::string, int32> mUniformIndices;
+    std::vector<float32> mUniformValues;
+};
+
+}
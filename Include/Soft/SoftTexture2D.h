@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "ITexture2D.h"
+
+namespace Video
+{
+
+class SoftTexture2D : public ITexture2D
+{
+public:
+    SoftTexture2D(uint width, uint height);
+    ~SoftTexture2D();
+
+    void Release();
+
+    uint GetWidth() const { return mWidth; }
+    uint GetHeight() const { return mHeight; }
+
+    void GetData(uint8* out, uint x, uint y, uint w, uint h) const;
+    void SetData(const uint8* in, uint x, uint y, uint w, uint h);
+
+    /**
+     * Filters the four nearest texels like GL_LINEAR with GL_CLAMP_TO_EDGE, row 0 is at v = 0
+     *
+     * @param refColor receives RGBA from 0 to 1
+     */
+    void Sample(float32 u, float32 v, float32* refColor) const;
+private:
+    uint mWidth, mHeight;
+    std::vector<uint8> mPixels;
+};
+
+}
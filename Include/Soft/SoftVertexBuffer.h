@@ -0,0 +1,35 @@
+#pragma once
+
+#include "IVertexBuffer.h"
+
+#include "Soft/SoftBuffer.h"
+
+namespace Video
+{
+
+class SoftVertexBuffer : public IVertexBuffer
+{
+public:
+    SoftVertexBuffer(VertexFormat format, uint length);
+    ~SoftVertexBuffer();
+
+    void Release();
+
+    const VertexFormat& GetFormat() const { return mFormat; }
+
+    uint GetLength() const { return mLength; }
+
+    void GetData(float32* out, uint start, uint count) const;
+    void SetData(const float32* in, uint start, uint count);
+
+    /**
+     * @return the vertices, read in place by the rasterizer
+     */
+    const float32* GetVertices() const { return reinterpret_cast<const float32*>(mBuffer.GetData()); }
+private:
+    VertexFormat mFormat;
+    uint mLength;
+    SoftBuffer mBuffer;
+};
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+
+#include "SDL2/SdlMouse.h"
+#include "IWindow.h"
+#include "Types.h"
+
+namespace Gui
+{
+
+class Environment;
+
+}
+
+namespace Core
+{
+
+/**
+ * Window with nothing on screen for the software device, which draws into memory.
+ * What was drawn is read back through the graphics device.
+ */
+class SoftWindow : public IWindow
+{
+public:
+    SoftWindow(const std::string& title, uint width, uint height);
+    virtual ~SoftWindow();
+
+    virtual bool IsVisible() const { return mVisible; }
+    virtual void SetVisible(bool visible) { mVisible = visible; }
+
+    virtual const std::string& GetTitle() const { return mTitle; }
+    virtual void SetTitle(const std::string& title) { mTitle = title; }
+
+    virtual uint GetWidth() const { return mWidth; }
+    virtual uint GetHeight() const { return mHeight; }
+    virtual void SetSize(uint width, uint height);
+
+    /**
+     * There are no input events without a display
+     */
+    virtual void PollEvents() {}
+
+    /**
+     * Nothing can arrive without a display, returns right away
+     */
+    virtual void WaitEvents(float64 timeout) {}
+    virtual void Wake() {}
+
+    /**
+     * Draws are finished when they return, there is nothing to wait for
+     */
+    virtual void SwapBuffers() {}
+
+    float32 GetAspectRatio() { return (float32) mWidth / mHeight; }
+
+    virtual Gui::Environment* GetEnvironment() { return mEnv; }
+    virtual SdlMouse* GetMouse() { return mMouse; }
+private:
+    SoftWindow(const SoftWindow&) = delete;
+    SoftWindow& operator=(const SoftWindow&) = delete;
+
+    std::string mTitle;
+    uint mWidth, mHeight;
+    bool mVisible;
+    SdlMouse* mMouse;
+    Gui::Environment* mEnv;
+};
+
+}
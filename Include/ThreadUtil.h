@@ -1,5 +1,9 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include "Types.h"
 
 namespace Core
@@ -8,11 +12,81 @@ namespace Core
 namespace Thread
 {
 
+/**
+ * Task handed to the job system, only the functions below look inside it
+ */
+struct Job;
+
+/**
+ * Keeps a job alive to wait on it or make other jobs depend on it
+ */
+typedef std::shared_ptr<Job> JobHandle;
+
 /**
  * Sleep the current thread by [millis] milliseconds
  */
 void Sleep(uint64 millis);
 
+/**
+ * Queues a task on the job system's worker threads.
+ *
+ * Workers are started the first time a job is queued, one per core besides the main thread and at
+ * least one. Each worker keeps its own queue: jobs queued from a worker go to the back of its queue
+ * and it runs its newest job first, idle workers steal the oldest jobs from the others. Jobs queued
+ * from any other thread go to a shared queue every worker takes from.
+ *
+ * @param dependencies jobs that have to finish before the task starts, the task is queued by
+ *        whichever of them finishes last
+ * @return handle to wait on or to pass as a dependency of later jobs
+ */
+JobHandle Run(const std::function<void()>& task);
+JobHandle Run(const std::function<void()>& task, const std::vector<JobHandle>& dependencies);
+
+/**
+ * Queues a task that has to run on the main thread, like anything that touches the graphics device.
+ * It runs the next time the main thread calls RunMainThreadJobs, after its dependencies finish.
+ */
+JobHandle RunOnMainThread(const std::function<void()>& task);
+JobHandle RunOnMainThread(const std::function<void()>& task, const std::vector<JobHandle>& dependencies);
+
+/**
+ * Runs the main thread jobs that are ready, called once per loop by Application
+ */
+void RunMainThreadJobs();
+
+/**
+ * Sets a function that is called whenever a main thread job is queued, so a main loop that is
+ * blocked waiting for events wakes up to run it. Called on the thread that queued the job.
+ */
+void SetMainThreadWakeUp(const std::function<void()>& wakeUp);
+
+/**
+ * Returns once a job is done. If nothing has started the job yet the calling thread runs it, any
+ * other job is left to the workers so waiting never picks up unrelated work. A job waiting on a job
+ * that still has dependencies blocks its worker until they are done.
+ * Main thread jobs only run in RunMainThreadJobs, so the main thread can't wait on them.
+ */
+void Wait(const JobHandle& job);
+
+/**
+ * @return true if the job's task has returned, true for an empty handle
+ */
+bool IsDone(const JobHandle& job);
+
+/**
+ * @return threads the job system runs jobs on, not counting the threads that wait on them
+ */
+uint GetWorkerCount();
+
+/**
+ * Splits [0, count) into ranges and calls body(begin, end) for each of them on the job system,
+ * returning once every range is done. There are a few ranges per thread so faster threads take
+ * more of them, the calling thread runs ranges too. Safe to call from inside a job.
+ *
+ * @param minRange smallest range worth a job, small counts are split into fewer ranges
+ */
+void ParallelFor(uint64 count, uint64 minRange, const std::function<void(uint64, uint64)>& body);
+
 }
 
 }
@@ -9,15 +9,31 @@ namespace Time
 {
 
 /**
- * @return current time in milliseconds
+ * @return nanoseconds since the program started, from a steady clock that never jumps when
+ *         the system time is set
+ */
+uint64 Nanos();
+
+/**
+ * @return milliseconds since the program started, from the same clock as Nanos
  */
 uint64 Millis();
 
 /**
- * @return current time in seconds
+ * @return seconds since the program started, from the same clock as Nanos
  */
 float64 Seconds();
 
+/**
+ * @return nanoseconds converted to seconds
+ */
+inline float64 ToSeconds(uint64 nanos) { return nanos / 1e9; }
+
+/**
+ * @return seconds converted to nanoseconds, negative seconds are 0
+ */
+inline uint64 ToNanos(float64 seconds) { return seconds > 0 ? (uint64)(seconds * 1e9 + 0.5) : 0; }
+
 }
 
 }
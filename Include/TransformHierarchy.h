@@ -0,0 +1,134 @@
+#pragma once
+
+#include <vector>
+
+#include "Math/ModelerMath.h"
+
+#include "Types.h"
+
+namespace Core
+{
+
+/**
+ * Positions, rotations and scales of a tree of nodes and the world matrices they add up to, kept in
+ * flat arrays instead of a Math::Transform per node pointing at its parent.
+ *
+ * Nodes are stored in breadth first order, every level of the tree in one run of the arrays after
+ * the levels above it. Update then carries changes down the tree in a single pass over the nodes,
+ * and recomputes the world matrices of each level in parallel, since the parents they need are all
+ * in earlier levels. Adding, removing or moving a node only marks the order stale, it is rebuilt by
+ * the next Update.
+ *
+ * A world matrix is parent world * translation * rotation * scale, applied to column vectors.
+ */
+class TransformHierarchy
+{
+public:
+    /**
+     * Handle to a node, stays the same while the node exists and is reused after it is removed
+     */
+    typedef uint32 NodeId;
+
+    /** Parent of a root node, never a valid node */
+    static const NodeId None = 0xFFFFFFFF;
+
+    TransformHierarchy();
+
+    /**
+     * Adds a node at the origin, unrotated and unscaled
+     *
+     * @param parent node the new one moves with, None for a root
+     * @return the new node, its world matrix is computed by the next Update
+     */
+    NodeId Add(NodeId parent = None);
+
+    /**
+     * Removes a node and every node below it
+     */
+    void Remove(NodeId node);
+
+    /**
+     * @return true if node was added and not removed since
+     */
+    bool IsValid(NodeId node) const;
+
+    /**
+     * Moves a node under a new parent, keeping its local position, rotation and scale
+     *
+     * @param parent None to make node a root
+     * @return false if node isn't valid, or parent is node itself or below it
+     */
+    bool SetParent(NodeId node, NodeId parent);
+
+    /**
+     * @return parent of node, None for a root or a node that isn't valid
+     */
+    NodeId GetParent(NodeId node) const;
+
+    /**
+     * Setters ignore nodes that aren't valid, the getters returning references need a valid node
+     */
+    void SetPosition(NodeId node, const Math::Vector3f& position);
+    void SetRotation(NodeId node, const Math::Quaternionf& rotation);
+    void SetScale(NodeId node, const Math::Vector3f& scale);
+
+    const Math::Vector3f& GetPosition(NodeId node) const { return mPositions[mSlots[node]]; }
+    const Math::Quaternionf& GetRotation(NodeId node) const { return mRotations[mSlots[node]]; }
+    const Math::Vector3f& GetScale(NodeId node) const { return mScales[mSlots[node]]; }
+
+    /**
+     * @return translation * rotation * scale of node, identity if node isn't valid
+     */
+    Math::Matrix4f GetLocalMatrix(NodeId node) const;
+
+    /**
+     * @return world matrix of node as of the last Update
+     */
+    const Math::Matrix4f& GetWorldMatrix(NodeId node) const { return mWorlds[mSlots[node]]; }
+
+    /**
+     * Recomputes the world matrices of every node that changed or is below one that did
+     */
+    void Update();
+
+    /**
+     * @return number of nodes
+     */
+    uint GetCount() const { return mIds.size() - mRemovedCount; }
+
+    /**
+     * @return levels of the tree as of the last Update, 1 for nodes that are all roots
+     */
+    uint GetLevelCount() const { return mLevelStarts.empty() ? 0 : mLevelStarts.size() - 1; }
+private:
+    /** Marks a slot with no node */
+    static const uint32 NoSlot = 0xFFFFFFFF;
+
+    void MakeDirty(uint32 slot);
+    void Sort();
+
+    // everything below is indexed by slot, the node's place in breadth first order
+    std::vector<NodeId> mIds;
+    /** Slot of each node's parent, NoSlot for roots and removed nodes */
+    std::vector<uint32> mParents;
+    std::vector<Math::Vector3f> mPositions;
+    std::vector<Math::Quaternionf> mRotations;
+    std::vector<Math::Vector3f> mScales;
+    std::vector<Math::Matrix4f> mWorlds;
+    /** Nonzero where the local transform changed since the last Update, bytes so ranges can be written in parallel */
+    std::vector<uint8> mDirty;
+
+    /** Slot of each node id, NoSlot for ids that are free */
+    std::vector<uint32> mSlots;
+    std::vector<NodeId> mFreeIds;
+
+    /** First slot of each level, followed by the slot count */
+    std::vector<uint32> mLevelStarts;
+    /** Slots whose node was removed, dropped by the next Sort */
+    uint mRemovedCount;
+    /** True when the slots aren't in breadth first order */
+    bool mUnsorted;
+    bool mAnyDirty;
+};
+
+}
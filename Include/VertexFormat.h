@@ -19,9 +19,21 @@ enum class Attribute
     TexCoord0,
     TexCoord1,
     TexCoord2,
-    TexCoord3
+    TexCoord3,
+    /** Columns of a model matrix, per instance */
+    Model0,
+    Model1,
+    Model2,
+    Model3,
+    /** Columns of a normal matrix, per instance */
+    NormalMat0,
+    NormalMat1,
+    NormalMat2
 };
 
+/** Number of values in Attribute */
+static const uint AttributeCount = 14;
+
 /**
  * Piece of a vertex format
  *
@@ -51,7 +63,7 @@ public:
     static const VertexFormat Position3Normal3Color4;
     static const VertexFormat Position3Normal3TexCoord02Color4;
 
-    VertexFormat() : mElems(), mBytes(0) {}
+    VertexFormat() : mElems(), mBytes(0), mInstanced(false) {}
 
     uint GetSizeInBytes() const { return mBytes; }
     uint GetSizeInFloats() const { return mBytes / 4; }
@@ -59,6 +71,11 @@ public:
     const VertexElement& GetElement(uint index) const { return mElems[index]; }
     const VertexElement& operator[](uint index) const { return GetElement(index); }
 
+    /**
+     * @return true if buffers of this format hold one vertex per instance, see SetInstanced
+     */
+    bool IsInstanced() const { return mInstanced; }
+
     /**
      * @return byte offset of an element
      */
@@ -93,9 +110,23 @@ public:
     {
         return AddElement(VertexElement(attrib, count));
     }
+
+    /**
+     * Makes buffers of this format advance to their next vertex once per instance instead of once
+     * per vertex, for data like a model matrix that DrawInstanced and DrawIndicesInstanced change
+     * between the copies they draw
+     *
+     * @return self, for easy chaining
+     */
+    VertexFormat& SetInstanced(bool instanced)
+    {
+        mInstanced = instanced;
+        return *this;
+    }
 private:
     std::vector<VertexElement> mElems;
     uint mBytes;
+    bool mInstanced;
 };
 
 }
@@ -1,7 +1,9 @@
 #include "Application.h"
 
+#include <algorithm>
 #include <iostream>
 
+#include "Profiler.h"
 #include "ThreadUtil.h"
 #include "TimeUtil.h"
 
@@ -10,10 +12,20 @@ using namespace std;
 namespace Core
 {
 
+/** Seconds each update steps the application forward */
+static const float64 UpdateStep = 1.0 / 60.0;
+
+/** Shortest time between frames in seconds */
+static const float64 FrameInterval = 1.0 / 60.0;
+
+/** Most updates run before a frame, time past them is dropped */
+static const uint64 MaxUpdatesPerFrame = 5;
+
 Application::Application(IBackend* backend)
     : Backend(backend),
       Window(backend->GetWindow()),
-      Graphics(backend->GetGraphicsDevice())
+      Graphics(backend->GetGraphicsDevice()),
+      mMainThread(std::this_thread::get_id())
 {
 }
 
@@ -36,59 +48,196 @@ void Application::Stop()
     mRunning = false;
 }
 
+void Application::Invalidate()
+{
+    mDirty = true;
+
+    //the main thread only calls this from its own loop, which isn't waiting
+    if (std::this_thread::get_id() != mMainThread) Window->Wake();
+}
+
+void Application::Invalidate(float64 delay)
+{
+    float64 time = Time::Seconds() + delay;
+    if (mInvalidateTime < 0 || time < mInvalidateTime) mInvalidateTime = time;
+}
+
+void Application::WaitForInvalidate()
+{
+    float64 timeout = -1;
+    if (mInvalidateTime >= 0) timeout = std::max(0.0, mInvalidateTime - Time::Seconds());
+
+    if (timeout != 0)
+    {
+        PROFILE_ZONE("WaitEvents");
+        Window->WaitEvents(timeout);
+    }
+
+    //whatever woke the loop, input, a wake up or the timeout, needs a new frame
+    if (mInvalidateTime >= 0 && mInvalidateTime <= Time::Seconds()) mInvalidateTime = -1;
+    mDirty = true;
+}
+
 void Application::UpdateLoop()
 {
+    Thread::SetMainThreadWakeUp([this] { Invalidate(); });
+    Profiler::SetThreadName("Main");
+
     Backend->Init();
     Window->SetVisible(true);
     OnInit();
 
-    uint32 ups = 0;
-    float64 updates = Time::Seconds();
-    float64 skipUpdates = 1.0 / 60.0;
+    if (mFrameLimit > 0)
+    {
+        LimitedLoop();
+        OnLastFrame();
+        Thread::SetMainThreadWakeUp(nullptr);
+        OnDestroy();
+        Backend->Destroy();
+        return;
+    }
 
+    const uint64 step = Time::ToNanos(UpdateStep);
+    const uint64 frameInterval = Time::ToNanos(FrameInterval);
+
+    uint32 ups = 0;
     uint32 fps = 0;
-    float64 frames = Time::Seconds();
-    float64 skipFrames = 1.0 / 60.0;
+    uint64 statsStart = Time::Nanos();
 
-    float64 time = Time::Seconds();
+    uint64 previous = Time::Nanos();
+    uint64 lastFrame = previous;
+    uint64 nextFrame = previous;
+    // time that hasn't been updated yet, one step so the first frame comes after an update
+    uint64 lag = step;
 
     while (mRunning)
     {
-        while (updates < Time::Seconds())
+        if (mRenderOnDemand && !mDirty)
         {
-            updates += skipUpdates;
+            WaitForInvalidate();
+
+            // nothing ran while waiting, skip that time but update once for whatever woke the loop
+            previous = Time::Nanos();
+            lag = std::max(lag, step);
+        }
+
+        uint64 now = Time::Nanos();
+        lag += now - previous;
+        previous = now;
+
+        // after a slow frame the loop catches up a few updates at most and lets the rest go,
+        // so updates can't take longer and longer to catch up
+        lag = std::min(lag, step * MaxUpdatesPerFrame);
+
+        while (lag >= step)
+        {
+            PROFILE_ZONE("Update");
+
+            lag -= step;
             ups++;
             Window->PollEvents();
-            // TODO actual dt
-            Backend->Update(skipUpdates);
-            OnUpdate(skipUpdates);
+            Thread::RunMainThreadJobs();
+            Backend->Update(UpdateStep);
+            OnUpdate(UpdateStep);
         }
 
-        if (frames < Time::Seconds())
+        now = Time::Nanos();
+        if (nextFrame <= now && (!mRenderOnDemand || mDirty))
         {
-            frames += skipFrames;
+            // a slow frame starts the interval over instead of being followed by frames back to back
+            nextFrame += frameInterval;
+            if (nextFrame < now) nextFrame = now + frameInterval;
+
+            mInterpolation = std::min(1.0, (float64)(lag + now - previous) / step);
+            mFrameTime = Time::ToSeconds(now - lastFrame);
+            lastFrame = now;
             fps++;
-            OnRender();
+            mDirty = false;
+
+            PROFILE_ZONE("Frame");
+            {
+                PROFILE_ZONE("Render");
+                OnRender();
+            }
+            PROFILE_ZONE("SwapBuffers");
             Window->SwapBuffers();
         }
 
-        if (Time::Seconds() - time >= 1.0)
+        now = Time::Nanos();
+        if (now - statsStart >= Time::ToNanos(1.0))
         {
 //            cout << "Frames: " << fps << ", ";
 //            cout << "Updates: " << ups << endl;
             mFps = fps;
             mUps = ups;
             fps = ups = 0;
-            time = Time::Seconds();
+
+            Profiler::Counter("Frames per second", mFps);
+            Profiler::Counter("Updates per second", mUps);
+            statsStart = now;
         }
 
         mRunning &= Window->IsVisible();
 
-        Thread::Sleep(std::max(0.0, (updates - Time::Seconds()) * 1000));
+        // sleep until the next update or frame is due, rounded up to whole milliseconds since waits
+        // under one rounded down to nothing and the loop spun until they were over
+        uint64 wake = std::min(previous + step - lag, nextFrame);
+        if (wake > now)
+        {
+            PROFILE_ZONE("Sleep");
+            Thread::Sleep((wake - now + 999999) / 1000000);
+        }
     }
 
+    Thread::SetMainThreadWakeUp(nullptr);
     OnDestroy();
     Backend->Destroy();
 }
 
+void Application::LimitedLoop()
+{
+    // every update steps the same time so runs can be compared
+    const float64 dt = 1.0 / 60.0;
+
+    uint32 frames = 0;
+    float64 renderTime = 0;
+
+    while (mRunning && frames < mFrameLimit)
+    {
+        {
+            PROFILE_ZONE("Update");
+            Window->PollEvents();
+            Thread::RunMainThreadJobs();
+            Backend->Update(dt);
+            OnUpdate(dt);
+        }
+
+        if (!IsReady())
+        {
+            Thread::Sleep(10);
+            continue;
+        }
+
+        uint64 start = Time::Nanos();
+        {
+            PROFILE_ZONE("Frame");
+            {
+                PROFILE_ZONE("Render");
+                OnRender();
+            }
+            PROFILE_ZONE("SwapBuffers");
+            Window->SwapBuffers();
+        }
+        renderTime += Time::ToSeconds(Time::Nanos() - start);
+        frames++;
+
+        mRunning &= Window->IsVisible();
+    }
+
+    mFps = frames / std::max(renderTime, 1e-9);
+
+    cout << "Rendered " << frames << " frames in " << renderTime * 1000 << " ms, "
+         << renderTime * 1000 / std::max<uint32>(frames, 1) << " ms per frame" << endl;
+}
+
 }
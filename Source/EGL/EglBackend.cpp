@@ -0,0 +1,25 @@
+#include "EGL/EglBackend.h"
+
+namespace Core
+{
+
+EglBackend::EglBackend(uint width, uint height)
+    : mWindow("Modeler3D", width, height),
+      mGraphics(&mWindow)
+{
+}
+
+EglBackend::~EglBackend()
+{
+}
+
+void EglBackend::Init()
+{
+    mGraphics.Init();
+}
+
+void EglBackend::Destroy()
+{
+}
+
+}
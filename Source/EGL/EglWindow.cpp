@@ -0,0 +1,179 @@
+#include "EGL/EglWindow.h"
+
+#include <iostream>
+#include <string>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glew.h>
+
+#include "GUI/AllWidgets.h"
+#include "SDL2/SdlMouse.h"
+
+using namespace std;
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace Core
+{
+
+/**
+ * Prefers Mesa's surfaceless platform, which needs neither a display server nor a GPU
+ */
+static EGLDisplay GetDisplay()
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if (getPlatformDisplay)
+    {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display != EGL_NO_DISPLAY) return display;
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+EglWindow::EglWindow(const string& title, uint width, uint height)
+    : mTitle(title),
+      mWidth(width),
+      mHeight(height),
+      mVisible(false),
+      mDisplay(EGL_NO_DISPLAY),
+      mContext(EGL_NO_CONTEXT),
+      mFramebuffer(0),
+      mColorBuffer(0),
+      mDepthBuffer(0),
+      mMouse(new SdlMouse()),
+      mEnv(new Gui::Environment(width, height))
+{
+    if (!CreateContext())
+    {
+        cout << "Could not create a headless OpenGL context" << endl;
+        return;
+    }
+
+    glewExperimental = GL_TRUE;
+    glewInit();
+
+    const char* version = (const char*)glGetString(GL_VERSION);
+    cout << version << endl;
+
+    version = (const char*)glGetString(GL_RENDERER);
+    cout << version << endl;
+
+    CreateFramebuffer();
+}
+
+EglWindow::~EglWindow()
+{
+    if (mContext != EGL_NO_CONTEXT)
+    {
+        ReleaseFramebuffer();
+        eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(mDisplay, mContext);
+    }
+
+    if (mDisplay != EGL_NO_DISPLAY) eglTerminate(mDisplay);
+
+    delete mEnv;
+    delete mMouse;
+}
+
+bool EglWindow::CreateContext()
+{
+    mDisplay = GetDisplay();
+    if (mDisplay == EGL_NO_DISPLAY) return false;
+
+    EGLint major, minor;
+    if (!eglInitialize(mDisplay, &major, &minor)) return false;
+
+    // window configs, the default, don't exist without a display
+    const EGLint configAttribs[] =
+    {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(mDisplay, configAttribs, &config, 1, &configCount) || configCount == 0) return false;
+
+    // the same compatibility profile the SDL2 window asks for
+    if (!eglBindAPI(EGL_OPENGL_API)) return false;
+
+    mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, NULL);
+    if (mContext == EGL_NO_CONTEXT) return false;
+
+    if (!eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, mContext))
+    {
+        eglDestroyContext(mDisplay, mContext);
+        mContext = EGL_NO_CONTEXT;
+        return false;
+    }
+
+    return true;
+}
+
+void EglWindow::CreateFramebuffer()
+{
+    glGenRenderbuffers(1, &mColorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, mColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, mWidth, mHeight);
+
+    glGenRenderbuffers(1, &mDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, mDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mWidth, mHeight);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &mFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthBuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        cout << "Headless framebuffer is incomplete" << endl;
+    }
+
+    glViewport(0, 0, mWidth, mHeight);
+}
+
+void EglWindow::ReleaseFramebuffer()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &mFramebuffer);
+    glDeleteRenderbuffers(1, &mColorBuffer);
+    glDeleteRenderbuffers(1, &mDepthBuffer);
+    mFramebuffer = mColorBuffer = mDepthBuffer = 0;
+}
+
+void EglWindow::SetSize(uint width, uint height)
+{
+    if (width == mWidth && height == mHeight) return;
+
+    mWidth = width;
+    mHeight = height;
+
+    if (mContext != EGL_NO_CONTEXT)
+    {
+        ReleaseFramebuffer();
+        CreateFramebuffer();
+    }
+}
+
+void EglWindow::SwapBuffers()
+{
+    glFinish();
+}
+
+}
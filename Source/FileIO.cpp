@@ -1,5 +1,11 @@
 #include "FileIO.h"
 #include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "ThreadUtil.h"
 #include "Types.h"
 
 #include <boost/filesystem.hpp>
@@ -463,3 +469,637 @@ void FileIO::LoadObj2( boost::filesystem::path p, std::vector< std::vector< doub
 		}
 }
 
+
+
+/**
+ * Powers of ten that are exactly representable as a double
+ */
+static const double ExactPowersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static inline bool IsBlank( char c )
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool IsDigit( char c )
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline const char* SkipBlanks( const char* p, const char* end )
+{
+	while( p < end && IsBlank( *p ) )
+		p++;
+	return p;
+}
+
+/**
+ * @return pointer to the first character of the next line
+ */
+static inline const char* SkipLine( const char* p, const char* end )
+{
+	const char* newline = static_cast< const char* >( memchr( p, '\n', end - p ) );
+	return newline ? newline + 1 : end;
+}
+
+/**
+ * Parses a decimal floating point number in place
+ *
+ * @param p - first character of the number
+ *        end - end of the buffer
+ *        value - where the parsed number is stored
+ * @return pointer past the number, or p if there was no number
+ */
+static const char* ParseDouble( const char* p, const char* end, double &value )
+{
+	const char* start = p;
+	bool negative = false;
+
+	if( p < end && ( *p == '-' || *p == '+' ) )
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	//only the first 19 significant digits fit in the mantissa, the rest just move the exponent
+	uint64 mantissa = 0;
+	int32 significant = 0;
+	int32 exponent = 0;
+	bool anyDigits = false;
+
+	while( p < end && IsDigit( *p ) )
+	{
+		if( significant < 19 )
+		{
+			mantissa = mantissa * 10 + ( *p - '0' );
+			if( mantissa != 0 )
+				significant++;
+		}
+		else
+		{
+			exponent++;
+		}
+		anyDigits = true;
+		p++;
+	}
+
+	if( p < end && *p == '.' )
+	{
+		p++;
+		while( p < end && IsDigit( *p ) )
+		{
+			if( significant < 19 )
+			{
+				mantissa = mantissa * 10 + ( *p - '0' );
+				if( mantissa != 0 )
+					significant++;
+				exponent--;
+			}
+			anyDigits = true;
+			p++;
+		}
+	}
+
+	if( !anyDigits )
+		return start;
+
+	if( p < end && ( *p == 'e' || *p == 'E' ) )
+	{
+		const char* e = p + 1;
+		bool negativeExponent = false;
+
+		if( e < end && ( *e == '-' || *e == '+' ) )
+		{
+			negativeExponent = *e == '-';
+			e++;
+		}
+
+		if( e < end && IsDigit( *e ) )
+		{
+			int32 written = 0;
+			while( e < end && IsDigit( *e ) )
+			{
+				if( written < 10000 )
+					written = written * 10 + ( *e - '0' );
+				e++;
+			}
+			exponent += negativeExponent ? -written : written;
+			p = e;
+		}
+	}
+
+	double result = static_cast< double >( mantissa );
+
+	if( result != 0.0 )
+	{
+		if( exponent < 0 && exponent >= -22 )
+			result /= ExactPowersOfTen[ -exponent ];
+		else if( exponent > 0 && exponent <= 22 )
+			result *= ExactPowersOfTen[ exponent ];
+		else if( exponent != 0 )
+			result *= pow( 10.0, exponent );
+	}
+
+	value = negative ? -result : result;
+	return p;
+}
+
+/**
+ * Parses a decimal integer in place
+ *
+ * @param p - first character of the number
+ *        end - end of the buffer
+ *        value - where the parsed number is stored
+ * @return pointer past the number, or p if there was no number
+ */
+static const char* ParseInt( const char* p, const char* end, int &value )
+{
+	const char* start = p;
+	bool negative = false;
+
+	if( p < end && ( *p == '-' || *p == '+' ) )
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	if( p >= end || !IsDigit( *p ) )
+		return start;
+
+	int64 result = 0;
+	while( p < end && IsDigit( *p ) )
+	{
+		result = result * 10 + ( *p - '0' );
+		p++;
+	}
+
+	value = static_cast< int >( negative ? -result : result );
+	return p;
+}
+
+/**
+ * Parses up to [count] floating point values from the rest of a line, missing values are left as 0
+ *
+ * @return pointer past the last parsed value
+ */
+static const char* ParseDoubles( const char* p, const char* end, double* values, uint count )
+{
+	for( uint i = 0; i < count; i++ )
+	{
+		values[ i ] = 0.0;
+		p = SkipBlanks( p, end );
+		p = ParseDouble( p, end, values[ i ] );
+	}
+	return p;
+}
+
+/**
+ * Parses a single v/vt/vn group of a face element. Missing texture or normal indices are stored
+ * as 0, negative (relative) indices are resolved against the number of elements read so far.
+ *
+ * @param p - first character of the group
+ *        end - end of the buffer
+ *        counts - number of vertices, texture coordinates, and normals read so far
+ *        corner - where the three indices are stored
+ * @return pointer past the group, or p if there was no group
+ */
+static const char* ParseFaceCorner( const char* p, const char* end, const size_t counts[ 3 ], int corner[ 3 ] )
+{
+	const char* start = p;
+
+	corner[ 0 ] = corner[ 1 ] = corner[ 2 ] = 0;
+
+	p = ParseInt( p, end, corner[ 0 ] );
+	if( p == start )
+		return start;
+
+	for( uint i = 1; i < 3 && p < end && *p == '/'; i++ )
+	{
+		p++;
+		p = ParseInt( p, end, corner[ i ] );
+	}
+
+	for( uint i = 0; i < 3; i++ )
+	{
+		if( corner[ i ] < 0 )
+			corner[ i ] = static_cast< int >( counts[ i ] ) + corner[ i ] + 1;
+	}
+
+	return p;
+}
+
+/**
+ * Kinds of .obj lines the loader understands
+ */
+enum class ObjLine
+{
+	GeometricVertex,
+	TextureCoordinate,
+	NormalVertex,
+	FaceElement,
+	Other
+};
+
+/**
+ * Works out what kind of line starts at p
+ *
+ * @param p - first non blank character of the line
+ *        end - end of the buffer
+ *        refData - set to the first character after the keyword
+ */
+static ObjLine ClassifyLine( const char* p, const char* end, const char* &refData )
+{
+	if( end - p > 2 )
+	{
+		if( p[ 0 ] == 'v' && IsBlank( p[ 1 ] ) )
+		{
+			refData = p + 2;
+			return ObjLine::GeometricVertex;
+		}
+		if( p[ 0 ] == 'v' && p[ 1 ] == 't' && IsBlank( p[ 2 ] ) )
+		{
+			refData = p + 3;
+			return ObjLine::TextureCoordinate;
+		}
+		if( p[ 0 ] == 'v' && p[ 1 ] == 'n' && IsBlank( p[ 2 ] ) )
+		{
+			refData = p + 3;
+			return ObjLine::NormalVertex;
+		}
+		if( p[ 0 ] == 'f' && IsBlank( p[ 1 ] ) )
+		{
+			refData = p + 2;
+			return ObjLine::FaceElement;
+		}
+	}
+	return ObjLine::Other;
+}
+
+/**
+ * Reports how far a chunk has got every ProgressInterval bytes and checks for cancellation
+ */
+class ChunkProgress
+{
+public:
+	static const uint64 ProgressInterval = 1 << 18;
+
+	ChunkProgress( ObjLoadProgress* progress, const char* start ) : mProgress( progress ), mReported( start ) {}
+
+	/**
+	 * @return false if the load was cancelled
+	 */
+	bool Update( const char* ptr )
+	{
+		if( !mProgress || static_cast< uint64 >( ptr - mReported ) < ProgressInterval )
+			return true;
+
+		Finish( ptr );
+		return !mProgress->Cancelled;
+	}
+
+	void Finish( const char* ptr )
+	{
+		if( mProgress )
+			mProgress->Processed += ptr - mReported;
+		mReported = ptr;
+	}
+private:
+	ObjLoadProgress* mProgress;
+	const char* mReported;
+};
+
+/**
+ * Number of v, vt, and vn lines and triangles in part of an .obj file
+ */
+struct ObjCounts
+{
+	size_t Elements[ 4 ];
+
+	ObjCounts( ) { Elements[ 0 ] = Elements[ 1 ] = Elements[ 2 ] = Elements[ 3 ] = 0; }
+};
+
+/**
+ * Cheap first pass over [ptr, end) that counts elements without parsing any numbers except face
+ * indices, so the parse can write straight into arrays of the right size.
+ * The range must start at the beginning of a line.
+ */
+static void ScanObjChunk( const char* ptr, const char* end, ObjCounts &refCounts, ObjLoadProgress* progress )
+{
+	PROFILE_ZONE( "ScanObjChunk" );
+
+	const size_t noCounts[ 3 ] = { 0, 0, 0 };
+	ChunkProgress chunkProgress( progress, ptr );
+
+	while( ptr < end )
+	{
+		if( !chunkProgress.Update( ptr ) )
+			return;
+
+		const char* data;
+		ptr = SkipBlanks( ptr, end );
+
+		switch( ClassifyLine( ptr, end, data ) )
+		{
+		case ObjLine::GeometricVertex: refCounts.Elements[ 0 ]++; break;
+		case ObjLine::TextureCoordinate: refCounts.Elements[ 1 ]++; break;
+		case ObjLine::NormalVertex: refCounts.Elements[ 2 ]++; break;
+		case ObjLine::FaceElement:
+		{
+			//must stop exactly where ParseObjChunk stops, so use the same corner parser
+			size_t corners = 0;
+			int corner[ 3 ];
+			while( true )
+			{
+				data = SkipBlanks( data, end );
+				const char* next = ParseFaceCorner( data, end, noCounts, corner );
+				if( next == data )
+					break;
+				corners++;
+				data = next;
+			}
+			if( corners > 2 )
+				refCounts.Elements[ 3 ] += corners - 2;
+			break;
+		}
+		default: break;
+		}
+
+		ptr = SkipLine( ptr, end );
+	}
+
+	chunkProgress.Finish( end );
+}
+
+/**
+ * Where a chunk writes its elements. Each pointer points at the first element of the chunk.
+ */
+template< typename Real >
+struct ObjOutput
+{
+	Real* GeometricVertices;
+	Real* TextureCoordinates;
+	Real* NormalVertices;
+	uint32* FaceElements;
+};
+
+/**
+ * Parses every line in [ptr, end) straight into the output arrays. The range must start at the
+ * beginning of a line and the output must have room for what ScanObjChunk counted.
+ *
+ * @param ptr - start of the chunk
+ *        end - end of the chunk
+ *        offsets - number of v, vt, and vn in the file before this chunk, for relative indices
+ *        out - where to write elements
+ *        progress - optional, updated as the chunk is parsed
+ */
+template< typename Real >
+static void ParseObjChunk( const char* ptr, const char* end, const size_t offsets[ 4 ], ObjOutput< Real > out, ObjLoadProgress* progress )
+{
+	PROFILE_ZONE( "ParseObjChunk" );
+
+	size_t counts[ 3 ] = { offsets[ 0 ], offsets[ 1 ], offsets[ 2 ] };
+	double values[ 3 ];
+	ChunkProgress chunkProgress( progress, ptr );
+
+	while( ptr < end )
+	{
+		if( !chunkProgress.Update( ptr ) )
+			return;
+
+		const char* data;
+		ptr = SkipBlanks( ptr, end );
+
+		switch( ClassifyLine( ptr, end, data ) )
+		{
+		case ObjLine::GeometricVertex:
+			ParseDoubles( data, end, values, 3 );
+			for( uint i = 0; i < 3; i++ )
+				*out.GeometricVertices++ = static_cast< Real >( values[ i ] );
+			counts[ 0 ]++;
+			break;
+		case ObjLine::TextureCoordinate:
+			ParseDoubles( data, end, values, 2 );
+			for( uint i = 0; i < 2; i++ )
+				*out.TextureCoordinates++ = static_cast< Real >( values[ i ] );
+			counts[ 1 ]++;
+			break;
+		case ObjLine::NormalVertex:
+			ParseDoubles( data, end, values, 3 );
+			for( uint i = 0; i < 3; i++ )
+				*out.NormalVertices++ = static_cast< Real >( values[ i ] );
+			counts[ 2 ]++;
+			break;
+		case ObjLine::FaceElement:
+		{
+			//triangle fan around the first corner, same as LoadObj2
+			int first[ 3 ], previous[ 3 ], corner[ 3 ];
+			size_t corners = 0;
+			while( true )
+			{
+				data = SkipBlanks( data, end );
+				const char* next = ParseFaceCorner( data, end, counts, corner );
+				if( next == data )
+					break;
+
+				if( corners == 0 )
+				{
+					std::copy( corner, corner + 3, first );
+				}
+				else if( corners > 1 )
+				{
+					out.FaceElements = std::copy( first, first + 3, out.FaceElements );
+					out.FaceElements = std::copy( previous, previous + 3, out.FaceElements );
+					out.FaceElements = std::copy( corner, corner + 3, out.FaceElements );
+				}
+				std::copy( corner, corner + 3, previous );
+
+				corners++;
+				data = next;
+			}
+			break;
+		}
+		default: break;
+		}
+
+		ptr = SkipLine( ptr, end );
+	}
+
+	chunkProgress.Finish( end );
+}
+
+/**
+ * Runs work( chunk ) for every chunk on the job system, the calling thread helps
+ */
+static void RunOnChunks( uint chunkCount, const std::function< void( uint ) > &work )
+{
+	Core::Thread::ParallelFor( chunkCount, 1, [ & ]( uint64 begin, uint64 end )
+	{
+		for( uint64 i = begin; i < end; i++ )
+			work( i );
+	} );
+}
+
+/**
+ * Maps an .obj file and parses it into flat arrays in two passes over newline aligned chunks:
+ * a counting pass to size the arrays, then a parse that writes each chunk straight into its slice.
+ *
+ * @param p - path of .obj file
+ *        refGeometricVertices - x, y, z per vertex
+ *        refTextureCoordinates - u, v per texture coordinate
+ *        refNormalVertices - x, y, z per normal
+ *        refFaceElements - v/vt/vn for each corner of each triangle
+ *        threadCount - number of threads to parse with, 0 uses one per core
+ *        progress - optional, counts every byte once per pass
+ * @return false if the file could not be opened or the load was cancelled
+ */
+template< typename Real >
+static bool LoadObjFlat( boost::filesystem::path p, std::vector< Real > &refGeometricVertices, std::vector< Real > &refTextureCoordinates,
+		std::vector< Real > &refNormalVertices, std::vector< uint32 > &refFaceElements, uint threadCount, ObjLoadProgress* progress )
+{
+	PROFILE_ZONE( "LoadObjFlat" );
+
+	//chunks smaller than this aren't worth a thread
+	const uint64 minChunkSize = 1 << 20;
+
+	Core::MappedFile file;
+
+	if( !file.Open( p.string( ) ) )
+		return false;
+
+	const char* data = file.GetData( );
+	const uint64 size = file.GetSize( );
+
+	if( progress )
+		progress->Total = size * 2;
+
+	if( threadCount == 0 )
+		threadCount = Core::Thread::GetWorkerCount( ) + 1;
+
+	uint chunkCount = static_cast< uint >( std::max< uint64 >( 1, std::min< uint64 >( threadCount, size / minChunkSize ) ) );
+
+	//split at the first newline after each even division of the file
+	std::vector< const char* > bounds( chunkCount + 1, data + size );
+	bounds[ 0 ] = data;
+	for( uint i = 1; i < chunkCount; i++ )
+	{
+		const char* split = data + size * i / chunkCount;
+		bounds[ i ] = std::max( bounds[ i - 1 ], SkipLine( split, data + size ) );
+	}
+
+	std::vector< ObjCounts > counts( chunkCount );
+	RunOnChunks( chunkCount, [ & ]( uint i ) { ScanObjChunk( bounds[ i ], bounds[ i + 1 ], counts[ i ], progress ); } );
+
+	if( progress && progress->Cancelled )
+		return false;
+
+	//offsets of each chunk in the final arrays, relative indices resolve against these too
+	std::vector< ObjCounts > offsets( chunkCount + 1 );
+	for( uint i = 0; i < chunkCount; i++ )
+	{
+		for( uint k = 0; k < 4; k++ )
+			offsets[ i + 1 ].Elements[ k ] = offsets[ i ].Elements[ k ] + counts[ i ].Elements[ k ];
+	}
+
+	const ObjCounts &total = offsets[ chunkCount ];
+	refGeometricVertices.resize( total.Elements[ 0 ] * 3 );
+	refTextureCoordinates.resize( total.Elements[ 1 ] * 2 );
+	refNormalVertices.resize( total.Elements[ 2 ] * 3 );
+	refFaceElements.resize( total.Elements[ 3 ] * 9 );
+
+	RunOnChunks( chunkCount, [ & ]( uint i )
+	{
+		const size_t* offset = offsets[ i ].Elements;
+
+		ObjOutput< Real > out;
+		out.GeometricVertices = refGeometricVertices.data( ) + offset[ 0 ] * 3;
+		out.TextureCoordinates = refTextureCoordinates.data( ) + offset[ 1 ] * 2;
+		out.NormalVertices = refNormalVertices.data( ) + offset[ 2 ] * 3;
+		out.FaceElements = refFaceElements.data( ) + offset[ 3 ] * 9;
+
+		ParseObjChunk( bounds[ i ], bounds[ i + 1 ], offset, out, progress );
+	} );
+
+	return !( progress && progress->Cancelled );
+}
+
+/**
+ * Loads a .obj file by mapping it into memory and parsing the bytes in place, without building a
+ * string per line. Fills the same data as LoadObj2, polygons are split into triangle fans.
+ *
+ * @param p - path of .obj file
+		  refGeometricVertices
+		  refTextureCoordinates
+		  refNormalVertices
+		  refFaceElements
+ * @return false if the file could not be opened
+ */
+bool FileIO::LoadObjMapped( boost::filesystem::path p, std::vector< std::vector< double > > &refGeometricVertices,
+		std::vector< std::vector< double > > &refTextureCoordinates, std::vector< std::vector<double > > &refNormalVertices,
+		std::vector< std::vector< std::vector< int > > > &refFaceElements )
+{
+	return LoadObjParallel( p, refGeometricVertices, refTextureCoordinates, refNormalVertices, refFaceElements, 1 );
+}
+
+/**
+ * Loads a .obj file like LoadObjMapped, but splits the file at line boundaries into chunks that are
+ * parsed on worker threads and then stitched back together in file order.
+ *
+ * @param p - path of .obj file
+		  refGeometricVertices
+		  refTextureCoordinates
+		  refNormalVertices
+		  refFaceElements
+		  threadCount - number of threads to parse with, 0 uses one per core
+ * @return false if the file could not be opened
+ */
+bool FileIO::LoadObjParallel( boost::filesystem::path p, std::vector< std::vector< double > > &refGeometricVertices,
+		std::vector< std::vector< double > > &refTextureCoordinates, std::vector< std::vector<double > > &refNormalVertices,
+		std::vector< std::vector< std::vector< int > > > &refFaceElements, uint threadCount )
+{
+	std::vector< double > geometricVertices, textureCoordinates, normalVertices;
+	std::vector< uint32 > faceElements;
+
+	if( !LoadObjFlat( p, geometricVertices, textureCoordinates, normalVertices, faceElements, threadCount, nullptr ) )
+		return false;
+
+	refGeometricVertices.reserve( refGeometricVertices.size( ) + geometricVertices.size( ) / 3 );
+	refTextureCoordinates.reserve( refTextureCoordinates.size( ) + textureCoordinates.size( ) / 2 );
+	refNormalVertices.reserve( refNormalVertices.size( ) + normalVertices.size( ) / 3 );
+	refFaceElements.reserve( refFaceElements.size( ) + faceElements.size( ) / 9 );
+
+	for( size_t i = 0; i < geometricVertices.size( ); i += 3 )
+		refGeometricVertices.push_back( std::vector< double >( &geometricVertices[ i ], &geometricVertices[ i ] + 3 ) );
+
+	for( size_t i = 0; i < textureCoordinates.size( ); i += 2 )
+		refTextureCoordinates.push_back( std::vector< double >( &textureCoordinates[ i ], &textureCoordinates[ i ] + 2 ) );
+
+	for( size_t i = 0; i < normalVertices.size( ); i += 3 )
+		refNormalVertices.push_back( std::vector< double >( &normalVertices[ i ], &normalVertices[ i ] + 3 ) );
+
+	for( size_t i = 0; i < faceElements.size( ); i += 9 )
+	{
+		std::vector< std::vector< int > > face( 3 );
+		for( uint j = 0; j < 3; j++ )
+			face[ j ].assign( &faceElements[ i + j * 3 ], &faceElements[ i + j * 3 ] + 3 );
+		refFaceElements.push_back( face );
+	}
+
+	return true;
+}
+
+/**
+ * Loads a .obj file into flat arrays, see ObjMesh. Capacity is taken from a counting pass so every
+ * array is allocated exactly once, and newline aligned chunks are parsed on worker threads.
+ *
+ * @param p - path of .obj file
+ *        refMesh - where the mesh is stored, any previous contents are replaced
+ *        threadCount - number of threads to parse with, 0 uses one per core
+ *        progress - optional, lets another thread watch and cancel the load
+ * @return false if the file could not be opened or the load was cancelled
+ */
+bool FileIO::LoadObjMesh( boost::filesystem::path p, ObjMesh &refMesh, uint threadCount, ObjLoadProgress* progress )
+{
+	return LoadObjFlat( p, refMesh.GeometricVertices, refMesh.TextureCoordinates, refMesh.NormalVertices,
+			refMesh.FaceElements, threadCount, progress );
+}
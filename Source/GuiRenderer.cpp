@@ -1,7 +1,14 @@
 #include "GuiRenderer.h"
 
+#include <algorithm>
+#include <iostream>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+#include "lodepng.h"
+
+#include "Profiler.h"
 
 using namespace std;
 using namespace Core::Math;
@@ -18,6 +25,15 @@ static const VertexFormat Format = VertexFormat()
         .AddElement(Attribute::Color, 4)
         .AddElement(Attribute::TexCoord0, 2);
 
+/** Rectangles that fit in the vertex buffer, 4 vertices each keeps 16 bit indices */
+static const uint BatchRects = 4096;
+
+/** Empty pixels between images in the atlas so filtering doesn't blend neighbours */
+static const uint AtlasPadding = 4;
+
+/** Files of each GuiRenderer::Image, None has no file */
+static const char* const ImageFiles[] = { nullptr, "Assets/button.png", "Assets/font_new.png" };
+
 struct CharPosition
 {
     int32 X, Y;
@@ -119,37 +135,49 @@ static const string FragmentSource = ""
         "varying vec4 vColor; \n"
         "varying vec2 vTexCoord0; \n"
         "uniform sampler2D Texture; "
-        "uniform int HasTexture; "
         "void main() { \n"
-        "   if (HasTexture == 1) { \n"
-        "       gl_FragColor = vColor * texture2D(Texture, vTexCoord0); \n"
-        "   } \n"
-        "   else { \n"
-        "       gl_FragColor = vColor; \n"
-        "   } \n"
+        "   gl_FragColor = vColor * texture2D(Texture, vTexCoord0); \n"
         "} \n";
 
 GuiRenderer::GuiRenderer(IGraphicsDevice* gd)
     : mGraphics(gd),
       mShader(nullptr),
+      mTextureUniform(),
       mGeometry(nullptr),
+      mIndices(nullptr),
       mVertices(nullptr),
-      mTexture(nullptr),
-      mFontTex(nullptr),
+      mAtlas(nullptr),
+      mImages(),
+      mRegion(),
+      mBatch(),
+      mBatchTexture(nullptr),
       mColor(0),
       mTranslate(0)
 {
-    mVertices = mGraphics->CreateVertexBuffer(Format, 4, BufferHint::Stream);
-    mIndices = mGraphics->CreateIndexBuffer(6, BufferHint::Static);
+    mVertices = mGraphics->CreateVertexBuffer(Format, BatchRects * 4, BufferHint::Stream);
+    mIndices = mGraphics->CreateIndexBuffer(BatchRects * 6, BufferHint::Static, IndexFormat::UInt16);
     mGeometry = mGraphics->CreateGeometry();
     mShader = mGraphics->CreateShader(VertexSource, FragmentSource);
-    mFontTex = mGraphics->CreateTexture2D("Assets/font_new.png");
+    mTextureUniform = mShader->GetUniform("Texture");
 
     mGeometry->SetVertexBuffer(mVertices);
     mGeometry->SetIndexBuffer(mIndices);
 
-    uint inds[] = {0, 1, 3, 0, 3, 2};
-    mIndices->SetData(inds, 0, 6);
+    vector<uint32> inds(BatchRects * 6);
+    for (uint i = 0; i < BatchRects; i++)
+    {
+        const uint32 quad[] = { 0, 1, 3, 0, 3, 2 };
+        for (uint j = 0; j < 6; j++)
+        {
+            inds[i * 6 + j] = i * 4 + quad[j];
+        }
+    }
+    mIndices->SetData(&inds[0], 0, inds.size());
+
+    mBatch.reserve(BatchRects * 4 * Format.GetSizeInFloats());
+
+    BuildAtlas();
+    SetImage(Image::None);
 }
 
 GuiRenderer::~GuiRenderer()
@@ -164,6 +192,58 @@ void GuiRenderer::Release()
     mVertices->Release();
     mIndices->Release();
     mShader->Release();
+    if (mAtlas) mAtlas->Release();
+}
+
+/**
+ * Stacks the GUI images into one texture, with a white block for drawing without an image
+ */
+void GuiRenderer::BuildAtlas()
+{
+    const uint imageCount = sizeof(ImageFiles) / sizeof(ImageFiles[0]);
+
+    vector<vector<uint8>> images(imageCount);
+    vector<uint> widths(imageCount, 0), heights(imageCount, 0);
+
+    uint width = AtlasPadding, height = AtlasPadding;
+    for (uint i = 1; i < imageCount; i++)
+    {
+        if (lodepng::decode(images[i], widths[i], heights[i], ImageFiles[i], LCT_RGBA))
+        {
+            cout << "Error reading image: " << ImageFiles[i] << endl;
+            widths[i] = heights[i] = 0;
+        }
+
+        width = max(width, widths[i]);
+        height += AtlasPadding + heights[i];
+    }
+
+    vector<uint8> pixels(width * height * 4, 0);
+    fill(pixels.begin(), pixels.begin() + width * AtlasPadding * 4, 255);
+
+    mAtlas = mGraphics->CreateTexture2D(width, height);
+    mImages.assign(imageCount, TextureRegion());
+
+    // every texture coordinate lands in the middle of the white block
+    mImages[0] = { mAtlas, 0.5f * AtlasPadding / width, 0.5f * AtlasPadding / height, 0, 0 };
+
+    uint y = AtlasPadding;
+    for (uint i = 1; i < imageCount; i++)
+    {
+        y += AtlasPadding;
+
+        // images are stored top row first, textures bottom row first
+        for (uint row = 0; row < heights[i]; row++)
+        {
+            const uint8* from = &images[i][row * widths[i] * 4];
+            copy(from, from + widths[i] * 4, &pixels[((y + heights[i] - row - 1) * width) * 4]);
+        }
+
+        mImages[i] = { mAtlas, 0, (float32)y / height, (float32)widths[i] / width, (float32)heights[i] / height };
+        y += heights[i];
+    }
+
+    mAtlas->SetData(&pixels[0], 0, 0, width, height);
 }
 
 /**
@@ -186,8 +266,8 @@ void GuiRenderer::DrawText(const std::string& str, float32 size, float32 x, floa
     float32 posX = x - xWeight * totalWidth;
     float32 posY = y - yWeight * size;
 
-    ITexture2D* tmp = mTexture;
-    SetTexture(mFontTex);
+    TextureRegion previous = mRegion;
+    SetImage(Image::Font);
 
     //draws text character by character
     for (uint i = 0; i < str.size(); i++)
@@ -198,7 +278,7 @@ void GuiRenderer::DrawText(const std::string& str, float32 size, float32 x, floa
         posX += charWidth * scale;
     }
 
-    SetTexture(tmp);
+    mRegion = previous;
 }
 
 /**
@@ -228,8 +308,13 @@ void GuiRenderer::SetColor(float32 r, float32 g, float32 b, float32 a)
  */
 void GuiRenderer::FillRect(float32 x, float32 y, float32 w, float32 h, float32 u, float32 v, float32 uWidth, float32 vHeight)
 {
-    const uint size = 8;
-    float32 verts[size * 4];
+    const uint stride = Format.GetSizeInFloats();
+
+    if (mRegion.Texture != mBatchTexture || mBatch.size() == BatchRects * 4 * stride)
+    {
+        Flush();
+        mBatchTexture = mRegion.Texture;
+    }
 
     float32 width = mGraphics->GetWidth();
     float32 height = mGraphics->GetHeight();
@@ -239,36 +324,64 @@ void GuiRenderer::FillRect(float32 x, float32 y, float32 w, float32 h, float32 u
     w = w * 2.0 / width;
     h = h * 2.0 / height;
 
-    uint index = 0;
+    u = mRegion.U + u * mRegion.Width;
+    v = mRegion.V + v * mRegion.Height;
+    uWidth *= mRegion.Width;
+    vHeight *= mRegion.Height;
+
+    uint index = mBatch.size();
+    mBatch.resize(index + stride * 4);
+
     for (int j = 0; j < 2; j++)
     {
         for (int i = 0; i < 2; i++)
         {
-            verts[index++] = x + i * w;
-            verts[index++] = y + j * h;
-            verts[index++] = mColor.R;
-            verts[index++] = mColor.G;
-            verts[index++] = mColor.B;
-            verts[index++] = mColor.A;
-            verts[index++] = u + i * uWidth;
-            verts[index++] = v + j * vHeight;
+            mBatch[index++] = x + i * w;
+            mBatch[index++] = y + j * h;
+            mBatch[index++] = mColor.R;
+            mBatch[index++] = mColor.G;
+            mBatch[index++] = mColor.B;
+            mBatch[index++] = mColor.A;
+            mBatch[index++] = u + i * uWidth;
+            mBatch[index++] = v + j * vHeight;
         }
     }
+}
+
+void GuiRenderer::Flush()
+{
+    PROFILE_ZONE("GuiRenderer::Flush");
 
-    mVertices->SetData(verts, 0, 4);
+    uint vertexCount = mBatch.size() / Format.GetSizeInFloats();
+    if (vertexCount == 0) return;
 
-    mShader->SetInt32("HasTexture", mTexture != nullptr);
-    mShader->SetInt32("Texture", 0);
-    mGraphics->SetTexture(0, mTexture);
+    mVertices->SetData(&mBatch[0], 0, vertexCount);
+
+    mShader->SetInt32(mTextureUniform, 0);
+    mGraphics->SetTexture(0, mBatchTexture);
 
     mGraphics->SetShader(mShader);
     mGraphics->SetGeometry(mGeometry);
-    mGraphics->DrawIndices(Primitive::TriangleList, 0, 2);
+    mGraphics->DrawIndices(Primitive::TriangleList, 0, vertexCount / 2);
+
+    mBatch.clear();
+}
+
+void GuiRenderer::SetImage(Image image)
+{
+    mRegion = mImages[static_cast<uint>(image)];
 }
 
 void GuiRenderer::SetTexture(ITexture2D* texture)
 {
-    mTexture = texture;
+    if (texture)
+    {
+        mRegion = { texture, 0, 0, 1, 1 };
+    }
+    else
+    {
+        SetImage(Image::None);
+    }
 }
 
 }
@@ -0,0 +1,118 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else // UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Types.h"
+
+namespace Core
+{
+
+MappedFile::MappedFile()
+    : mOpen(false),
+      mData(nullptr),
+      mSize(0),
+#ifdef _WIN32
+      mFile(INVALID_HANDLE_VALUE),
+      mMapping(nullptr)
+#else // UNIX
+      mFd(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filename)
+{
+    Close();
+
+#ifdef _WIN32
+    mFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (mFile == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mFile, &size))
+    {
+        Close();
+        return false;
+    }
+    mSize = size.QuadPart;
+
+    if (mSize > 0)
+    {
+        mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mMapping == nullptr)
+        {
+            Close();
+            return false;
+        }
+
+        mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+        if (mData == nullptr)
+        {
+            Close();
+            return false;
+        }
+    }
+#else // UNIX
+    mFd = open(filename.c_str(), O_RDONLY);
+    if (mFd < 0) return false;
+
+    struct stat info;
+    if (fstat(mFd, &info) != 0)
+    {
+        Close();
+        return false;
+    }
+    mSize = info.st_size;
+
+    if (mSize > 0)
+    {
+        void* data = mmap(NULL, mSize, PROT_READ, MAP_PRIVATE, mFd, 0);
+        if (data == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+
+        // we only ever walk the file front to back
+        madvise(data, mSize, MADV_SEQUENTIAL);
+        mData = static_cast<const char*>(data);
+    }
+#endif
+
+    mOpen = true;
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (mData) UnmapViewOfFile(mData);
+    if (mMapping) CloseHandle(mMapping);
+    if (mFile != INVALID_HANDLE_VALUE) CloseHandle(mFile);
+    mMapping = nullptr;
+    mFile = INVALID_HANDLE_VALUE;
+#else // UNIX
+    if (mData) munmap(const_cast<char*>(mData), mSize);
+    if (mFd >= 0) close(mFd);
+    mFd = -1;
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
+
+}
@@ -0,0 +1,329 @@
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "Types.h"
+
+using namespace std;
+
+namespace Core
+{
+
+static const char Magic[8] = { 'M', '3', 'D', 'C', 'A', 'C', 'H', 'E' };
+
+/** Data arrays start on this boundary so they can be used in place */
+static const uint64 DataAlignment = 64;
+
+/** Bytes written between checks for a cancel */
+static const uint64 WriteChunkSize = 4 * 1024 * 1024;
+
+/** Most vertex elements a cached format can have */
+static const uint32 MaxElements = 8;
+
+/**
+ * Layout of the start of a cache file, followed by the vertex and index arrays
+ */
+struct MeshCache::Header
+{
+    char Magic[8];
+    uint32 Version;
+    uint32 BuildKey;
+
+    uint64 SourceSize;
+    int64 SourceTime;
+    uint64 SourceHash;
+
+    uint32 ElementCount;
+    uint32 Elements[MaxElements][2];
+
+    uint64 VertexCount;
+    uint64 VertexOffset;
+    uint64 IndexCount;
+    uint64 IndexOffset;
+    uint64 LodCount;
+    uint64 LodOffset;
+    uint64 FileSize;
+};
+
+static uint64 AlignUp(uint64 value)
+{
+    return (value + DataAlignment - 1) / DataAlignment * DataAlignment;
+}
+
+/**
+ * @return true if count items of itemSize bytes starting at offset end before fileSize, without
+ *         overflowing on the huge values a corrupt header can hold
+ */
+static bool FitsInFile(uint64 offset, uint64 count, uint64 itemSize, uint64 fileSize)
+{
+    if (offset > fileSize || offset % sizeof(uint32) != 0) return false;
+    return count <= (fileSize - offset) / itemSize;
+}
+
+static void HashBytes(uint64& hash, const char* data, uint64 size)
+{
+    // FNV-1a
+    for (uint64 i = 0; i < size; i++)
+    {
+        hash ^= static_cast<uint8>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+}
+
+/**
+ * Hashes the start, the end and evenly spaced blocks in between, so checking a cache
+ * doesn't have to read a multi gigabyte model
+ */
+static uint64 HashSource(const MappedFile& file)
+{
+    const uint64 edgeSize = 64 * 1024;
+    const uint64 blockSize = 4 * 1024;
+    const uint64 blockCount = 64;
+
+    const char* data = file.GetData();
+    uint64 size = file.GetSize();
+    uint64 hash = 14695981039346656037ULL;
+
+    if (size <= edgeSize * 2 + blockSize * blockCount)
+    {
+        HashBytes(hash, data, size);
+        return hash;
+    }
+
+    HashBytes(hash, data, edgeSize);
+    for (uint64 i = 1; i <= blockCount; i++)
+    {
+        HashBytes(hash, data + size / (blockCount + 1) * i, blockSize);
+    }
+    HashBytes(hash, data + size - edgeSize, edgeSize);
+    return hash;
+}
+
+/**
+ * Reads the size, modification time and hash of a model file
+ */
+static bool GetSourceKey(const string& source, uint64& size, int64& time, uint64& hash)
+{
+    boost::system::error_code error;
+    time = boost::filesystem::last_write_time(source, error);
+    if (error) return false;
+
+    MappedFile file;
+    if (!file.Open(source)) return false;
+
+    size = file.GetSize();
+    hash = HashSource(file);
+    return true;
+}
+
+MeshCache::MeshCache()
+    : mFile(),
+      mHeader(nullptr),
+      mFormat()
+{
+}
+
+MeshCache::~MeshCache()
+{
+    Close();
+}
+
+string MeshCache::GetCachePath(const string& source)
+{
+    return source + ".m3dcache";
+}
+
+bool MeshCache::Open(const string& source, uint32 buildKey)
+{
+    Close();
+
+    uint64 size, hash;
+    int64 time;
+    if (!GetSourceKey(source, size, time, hash)) return false;
+
+    if (!mFile.Open(GetCachePath(source))) return false;
+
+    const Header* header = reinterpret_cast<const Header*>(mFile.GetData());
+    bool valid = mFile.GetSize() >= sizeof(Header)
+            && memcmp(header->Magic, Magic, sizeof(Magic)) == 0
+            && header->Version == Version
+            && header->BuildKey == buildKey
+            && header->SourceSize == size
+            && header->SourceTime == time
+            && header->SourceHash == hash
+            && header->ElementCount <= MaxElements
+            && header->FileSize == mFile.GetSize();
+
+    Video::VertexFormat format;
+    for (uint32 i = 0; valid && i < header->ElementCount; i++)
+    {
+        valid = header->Elements[i][0] < Video::AttributeCount && header->Elements[i][1] >= 1 && header->Elements[i][1] <= 4;
+        if (valid) format.AddElement(static_cast<Video::Attribute>(header->Elements[i][0]), header->Elements[i][1]);
+    }
+
+    // a truncated or corrupt cache must not point the arrays past the end of the mapping
+    valid = valid && format.GetSizeInBytes() > 0
+            && header->VertexCount <= 0xFFFFFFFF
+            && header->IndexCount <= 0xFFFFFFFF
+            && FitsInFile(header->VertexOffset, header->VertexCount, format.GetSizeInBytes(), header->FileSize)
+            && FitsInFile(header->IndexOffset, header->IndexCount, sizeof(uint32), header->FileSize)
+            && FitsInFile(header->LodOffset, header->LodCount, sizeof(MeshLod), header->FileSize);
+
+    const MeshLod* lods = valid ? reinterpret_cast<const MeshLod*>(mFile.GetData() + header->LodOffset) : nullptr;
+    for (uint64 i = 0; valid && i < header->LodCount; i++)
+    {
+        valid = lods[i].IndexStart <= header->IndexCount && lods[i].IndexCount <= header->IndexCount - lods[i].IndexStart;
+    }
+
+    // every index has to name a cached vertex or drawing reads past the vertex buffer
+    const uint32* indices = valid ? reinterpret_cast<const uint32*>(mFile.GetData() + header->IndexOffset) : nullptr;
+    for (uint64 i = 0; valid && i < header->IndexCount; i++)
+    {
+        valid = indices[i] < header->VertexCount;
+    }
+
+    if (!valid)
+    {
+        mFile.Close();
+        return false;
+    }
+
+    mHeader = header;
+    mFormat = format;
+    return true;
+}
+
+void MeshCache::Close()
+{
+    mHeader = nullptr;
+    mFile.Close();
+}
+
+uint64 MeshCache::GetVertexCount() const
+{
+    return mHeader ? mHeader->VertexCount : 0;
+}
+
+const float32* MeshCache::GetVertices() const
+{
+    return mHeader ? reinterpret_cast<const float32*>(mFile.GetData() + mHeader->VertexOffset) : nullptr;
+}
+
+uint64 MeshCache::GetIndexCount() const
+{
+    return mHeader ? mHeader->IndexCount : 0;
+}
+
+const uint32* MeshCache::GetIndices() const
+{
+    return mHeader ? reinterpret_cast<const uint32*>(mFile.GetData() + mHeader->IndexOffset) : nullptr;
+}
+
+uint64 MeshCache::GetLodCount() const
+{
+    return mHeader ? mHeader->LodCount : 0;
+}
+
+const MeshLod* MeshCache::GetLods() const
+{
+    return mHeader ? reinterpret_cast<const MeshLod*>(mFile.GetData() + mHeader->LodOffset) : nullptr;
+}
+
+MeshView MeshCache::GetMesh() const
+{
+    MeshView mesh;
+    mesh.Format = GetFormat();
+    mesh.Vertices = GetVertices();
+    mesh.VertexCount = GetVertexCount();
+    mesh.Indices = GetIndices();
+    mesh.IndexCount = GetIndexCount();
+    mesh.Lods = GetLods();
+    mesh.LodCount = GetLodCount();
+    return mesh;
+}
+
+bool MeshCache::Write(const string& source, uint32 buildKey, const MeshData& mesh, const atomic<bool>* cancelled)
+{
+    const Video::VertexFormat& format = mesh.Format;
+
+    if (format.GetElementCount() > MaxElements) return false;
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.Magic, Magic, sizeof(Magic));
+    header.Version = Version;
+    header.BuildKey = buildKey;
+
+    if (!GetSourceKey(source, header.SourceSize, header.SourceTime, header.SourceHash)) return false;
+
+    header.ElementCount = format.GetElementCount();
+    for (uint32 i = 0; i < header.ElementCount; i++)
+    {
+        header.Elements[i][0] = static_cast<uint32>(format[i].Attrib);
+        header.Elements[i][1] = format[i].Count;
+    }
+
+    uint64 vertexBytes = (uint64)mesh.VertexCount * format.GetSizeInBytes();
+    uint64 indexBytes = mesh.Indices.size() * sizeof(uint32);
+    uint64 lodBytes = mesh.Lods.size() * sizeof(MeshLod);
+
+    header.VertexCount = mesh.VertexCount;
+    header.VertexOffset = AlignUp(sizeof(Header));
+    header.IndexCount = mesh.Indices.size();
+    header.IndexOffset = AlignUp(header.VertexOffset + vertexBytes);
+    header.LodCount = mesh.Lods.size();
+    header.LodOffset = AlignUp(header.IndexOffset + indexBytes);
+    header.FileSize = header.LodOffset + lodBytes;
+
+    // write to a temporary file first so a reader never maps half a cache
+    string path = GetCachePath(source);
+    string tempPath = path + ".tmp";
+    {
+        boost::filesystem::ofstream out(tempPath, ios::out | ios::binary | ios::trunc);
+        if (!out) return false;
+
+        const char padding[DataAlignment] = {};
+
+        // big arrays are written a chunk at a time so a cancel doesn't wait for all of them
+        auto write = [&](const void* data, uint64 size)
+        {
+            const char* bytes = reinterpret_cast<const char*>(data);
+            for (uint64 done = 0; done < size && out && !(cancelled && *cancelled); done += WriteChunkSize)
+            {
+                out.write(bytes + done, min(WriteChunkSize, size - done));
+            }
+        };
+
+        write(&header, sizeof(header));
+        write(padding, header.VertexOffset - sizeof(header));
+        write(mesh.Vertices.data(), vertexBytes);
+        write(padding, header.IndexOffset - header.VertexOffset - vertexBytes);
+        write(mesh.Indices.data(), indexBytes);
+        write(padding, header.LodOffset - header.IndexOffset - indexBytes);
+        write(mesh.Lods.data(), lodBytes);
+
+        if (!out || (cancelled && *cancelled))
+        {
+            out.close();
+            boost::filesystem::remove(tempPath);
+            return false;
+        }
+    }
+
+    boost::system::error_code error;
+    boost::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        boost::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,369 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Math/ModelerMath.h"
+
+#include "Types.h"
+
+using namespace std;
+using namespace Core::Math;
+
+namespace Core
+{
+
+namespace MeshOptimizer
+{
+
+static const uint32 Unused = 0xFFFFFFFF;
+
+/** Size of the LRU cache Forsyth's scoring models */
+static const uint ForsythCacheSize = 32;
+
+/** Valences past this all score the same */
+static const uint ForsythMaxValence = 64;
+
+/** Clusters smaller than this aren't worth sorting on their own */
+static const uint MinClusterSize = 16;
+
+/** Cache simulated when splitting clusters */
+static const uint ClusterCacheSize = 16;
+
+/**
+ * FIFO cache that remembers when each vertex was last loaded
+ */
+class CacheSimulator
+{
+public:
+    CacheSimulator(uint vertexCount, uint cacheSize) : mStamps(vertexCount, 0), mTime(cacheSize + 1), mSize(cacheSize) {}
+
+    /**
+     * Forgets everything in the cache
+     */
+    void Flush() { mTime += mSize + 1; }
+
+    /**
+     * @return number of the triangle's vertices that had to be loaded
+     */
+    uint Triangle(const uint32* triangle)
+    {
+        uint misses = 0;
+        for (uint k = 0; k < 3; k++)
+        {
+            uint32 v = triangle[k];
+            if (mTime - mStamps[v] > mSize)
+            {
+                mStamps[v] = mTime++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+private:
+    vector<uint64> mStamps;
+    uint64 mTime;
+    uint64 mSize;
+};
+
+VertexCacheStats AnalyzeVertexCache(const uint32* indices, uint indexCount, uint vertexCount, uint cacheSize)
+{
+    VertexCacheStats stats = { 0, 0 };
+    const uint triangleCount = indexCount / 3;
+    if (triangleCount == 0) return stats;
+
+    CacheSimulator cache(vertexCount, cacheSize);
+    vector<bool> used(vertexCount, false);
+
+    uint64 misses = 0;
+    uint64 unique = 0;
+    for (uint i = 0; i < triangleCount * 3; i += 3)
+    {
+        misses += cache.Triangle(indices + i);
+
+        for (uint k = 0; k < 3; k++)
+        {
+            if (!used[indices[i + k]])
+            {
+                used[indices[i + k]] = true;
+                unique++;
+            }
+        }
+    }
+
+    stats.Acmr = (float32)misses / triangleCount;
+    stats.Atvr = (float32)misses / unique;
+    return stats;
+}
+
+void OptimizeVertexCache(uint32* indices, uint indexCount, uint vertexCount)
+{
+    const uint triangleCount = indexCount / 3;
+    if (triangleCount == 0) return;
+
+    // the most recent triangle's vertices score a little lower so strips don't run back on themselves
+    float32 cacheScores[ForsythCacheSize];
+    for (uint i = 0; i < ForsythCacheSize; i++)
+    {
+        cacheScores[i] = i < 3 ? 0.75f : pow(1.0f - (i - 3) / (float32)(ForsythCacheSize - 3), 1.5f);
+    }
+
+    // vertices with few triangles left get a boost so they are finished off instead of left behind
+    float32 valenceScores[ForsythMaxValence];
+    for (uint i = 0; i < ForsythMaxValence; i++)
+    {
+        valenceScores[i] = i == 0 ? 0 : 2.0f * pow((float32)i, -0.5f);
+    }
+
+    auto vertexScore = [&](int32 cachePosition, uint32 valence) -> float32
+    {
+        if (valence == 0) return -1;
+        float32 score = cachePosition >= 0 ? cacheScores[cachePosition] : 0;
+        return score + valenceScores[min(valence, ForsythMaxValence - 1)];
+    };
+
+    // triangles around each vertex, the ones not yet emitted are kept at the front
+    vector<uint32> remaining(vertexCount, 0);
+    for (uint i = 0; i < triangleCount * 3; i++) remaining[indices[i]]++;
+
+    vector<uint32> start(vertexCount + 1, 0);
+    for (uint v = 0; v < vertexCount; v++) start[v + 1] = start[v] + remaining[v];
+
+    vector<uint32> adjacency(triangleCount * 3);
+    {
+        vector<uint32> cursor(start.begin(), start.end() - 1);
+        for (uint i = 0; i < triangleCount * 3; i++) adjacency[cursor[indices[i]]++] = i / 3;
+    }
+
+    vector<int32> cachePositions(vertexCount, -1);
+    vector<float32> vertexScores(vertexCount);
+    for (uint v = 0; v < vertexCount; v++) vertexScores[v] = vertexScore(-1, remaining[v]);
+
+    vector<float32> triangleScores(triangleCount);
+    int64 best = -1;
+    float32 bestScore = -1;
+    for (uint t = 0; t < triangleCount; t++)
+    {
+        const uint32* triangle = indices + t * 3;
+        triangleScores[t] = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+        if (triangleScores[t] > bestScore)
+        {
+            best = t;
+            bestScore = triangleScores[t];
+        }
+    }
+
+    vector<bool> emitted(triangleCount, false);
+    vector<uint32> output(triangleCount * 3);
+    uint32 cache[ForsythCacheSize + 3];
+    uint32 newCache[ForsythCacheSize + 3];
+    uint cacheCount = 0;
+    uint cursor = 0;
+
+    for (uint out = 0; out < triangleCount; out++)
+    {
+        // nothing in the cache touches a triangle that's left, start again somewhere else
+        if (best < 0)
+        {
+            while (emitted[cursor]) cursor++;
+            best = cursor;
+        }
+
+        const uint32 t = best;
+        const uint32* triangle = indices + t * 3;
+        emitted[t] = true;
+        copy(triangle, triangle + 3, &output[out * 3]);
+
+        uint newCount = 0;
+        for (uint k = 0; k < 3; k++)
+        {
+            uint32 v = triangle[k];
+            if (find(newCache, newCache + newCount, v) != newCache + newCount) continue;
+            newCache[newCount++] = v;
+
+            uint32* list = &adjacency[start[v]];
+            for (uint32 j = 0; j < remaining[v]; j++)
+            {
+                if (list[j] == t)
+                {
+                    swap(list[j], list[remaining[v] - 1]);
+                    remaining[v]--;
+                    break;
+                }
+            }
+        }
+
+        for (uint c = 0; c < cacheCount; c++)
+        {
+            if (find(newCache, newCache + newCount, cache[c]) == newCache + newCount) newCache[newCount++] = cache[c];
+        }
+
+        // anything pushed past the end of the cache is evicted
+        for (uint i = 0; i < newCount; i++)
+        {
+            uint32 v = newCache[i];
+            cachePositions[v] = i < ForsythCacheSize ? (int32)i : -1;
+            vertexScores[v] = vertexScore(cachePositions[v], remaining[v]);
+        }
+
+        cacheCount = min(newCount, ForsythCacheSize);
+        copy(newCache, newCache + cacheCount, cache);
+
+        // only triangles touching the cache changed score, the best next one is among them
+        best = -1;
+        bestScore = -1;
+        for (uint i = 0; i < newCount; i++)
+        {
+            uint32 v = newCache[i];
+            for (uint32 j = 0; j < remaining[v]; j++)
+            {
+                uint32 other = adjacency[start[v] + j];
+                const uint32* otherTriangle = indices + other * 3;
+                float32 score = vertexScores[otherTriangle[0]] + vertexScores[otherTriangle[1]] + vertexScores[otherTriangle[2]];
+                triangleScores[other] = score;
+
+                if (score > bestScore)
+                {
+                    best = other;
+                    bestScore = score;
+                }
+            }
+        }
+    }
+
+    copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeOverdraw(uint32* indices, uint indexCount, const float32* vertices, uint vertexCount, uint stride,
+        float32 threshold)
+{
+    const uint triangleCount = indexCount / 3;
+    if (triangleCount < MinClusterSize * 2) return;
+
+    CacheSimulator cache(vertexCount, ClusterCacheSize);
+
+    // hard boundaries where the cache order already starts over, every vertex of the triangle missing
+    vector<uint> hard;
+    for (uint t = 0; t < triangleCount; t++)
+    {
+        if (cache.Triangle(indices + t * 3) == 3) hard.push_back(t);
+    }
+    hard.push_back(triangleCount);
+
+    // soft boundaries inside those, as soon as a fresh cluster's ACMR is close enough to the whole run's
+    vector<uint> clusters;
+    for (uint h = 0; h + 1 < hard.size(); h++)
+    {
+        uint begin = hard[h], end = hard[h + 1];
+
+        cache.Flush();
+        uint64 runMisses = 0;
+        for (uint t = begin; t < end; t++) runMisses += cache.Triangle(indices + t * 3);
+        float32 runAcmr = (float32)runMisses / (end - begin);
+
+        uint clusterStart = begin;
+        while (clusterStart < end)
+        {
+            clusters.push_back(clusterStart);
+
+            cache.Flush();
+            uint64 misses = 0;
+            uint t = clusterStart;
+            while (t < end)
+            {
+                misses += cache.Triangle(indices + t * 3);
+                t++;
+
+                uint size = t - clusterStart;
+                if (size >= MinClusterSize && misses <= threshold * runAcmr * size) break;
+            }
+            clusterStart = t;
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // area weighted centroid and normal of the mesh and of each cluster
+    auto position = [&](uint32 v) -> Vector3f
+    {
+        const float32* p = vertices + (uint64)v * stride;
+        return Vector3f(p[0], p[1], p[2]);
+    };
+
+    const uint clusterCount = clusters.size() - 1;
+    vector<Vector3f> centroids(clusterCount, Vector3f(0));
+    vector<Vector3f> normals(clusterCount, Vector3f(0));
+    vector<float32> areas(clusterCount, 0);
+    Vector3f meshCentroid(0);
+    float32 meshArea = 0;
+
+    for (uint c = 0; c < clusterCount; c++)
+    {
+        for (uint t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            const uint32* triangle = indices + t * 3;
+            Vector3f p0 = position(triangle[0]), p1 = position(triangle[1]), p2 = position(triangle[2]);
+            Vector3f normal = Cross(p1 - p0, p2 - p0);
+            float32 area = Length(normal);
+
+            centroids[c] += (p0 + p1 + p2) * (area / 3);
+            normals[c] += normal;
+            areas[c] += area;
+        }
+
+        meshCentroid += centroids[c];
+        meshArea += areas[c];
+    }
+
+    if (meshArea > 0) meshCentroid /= meshArea;
+
+    // clusters facing away from the middle of the model are in front from most views, draw them first
+    vector<float32> sortKeys(clusterCount, 0);
+    for (uint c = 0; c < clusterCount; c++)
+    {
+        if (areas[c] <= 0) continue;
+
+        Vector3f centroid = centroids[c] / areas[c];
+        float32 length = Length(normals[c]);
+        if (length > 0) sortKeys[c] = Dot(centroid - meshCentroid, normals[c] / length);
+    }
+
+    vector<uint> order(clusterCount);
+    for (uint c = 0; c < clusterCount; c++) order[c] = c;
+    stable_sort(order.begin(), order.end(), [&](uint a, uint b) { return sortKeys[a] > sortKeys[b]; });
+
+    vector<uint32> output;
+    output.reserve(triangleCount * 3);
+    for (uint c : order)
+    {
+        output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+    }
+
+    copy(output.begin(), output.end(), indices);
+}
+
+uint OptimizeVertexFetch(float32* vertices, uint vertexCount, uint stride, uint32* indices, uint indexCount)
+{
+    vector<uint32> remap(vertexCount, Unused);
+    uint32 next = 0;
+
+    for (uint i = 0; i < indexCount; i++)
+    {
+        uint32& index = remap[indices[i]];
+        if (index == Unused) index = next++;
+        indices[i] = index;
+    }
+
+    vector<float32> original(vertices, vertices + (uint64)vertexCount * stride);
+    for (uint v = 0; v < vertexCount; v++)
+    {
+        if (remap[v] == Unused) continue;
+        copy(&original[(uint64)v * stride], &original[(uint64)v * stride] + stride, vertices + (uint64)remap[v] * stride);
+    }
+
+    return next;
+}
+
+}
+
+}
@@ -0,0 +1,438 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "MeshUtil.h"
+#include "Types.h"
+
+using namespace std;
+using namespace Core::Math;
+
+namespace Core
+{
+
+/** Passes over the triangles before giving up on reaching the target */
+static const uint MaxIterations = 100;
+
+/** How fast the collapse threshold grows with each pass, higher is faster but rougher */
+static const float64 Aggressiveness = 7.0;
+
+/** Collapses that would turn a triangle further than this (cosine) are rejected */
+static const float32 MinNormalDot = 0.2f;
+
+MeshSimplifier::Quadric::Quadric()
+{
+    fill(M, M + 10, 0.0);
+}
+
+MeshSimplifier::Quadric::Quadric(float64 a, float64 b, float64 c, float64 d)
+{
+    M[0] = a * a; M[1] = a * b; M[2] = a * c; M[3] = a * d;
+    M[4] = b * b; M[5] = b * c; M[6] = b * d;
+    M[7] = c * c; M[8] = c * d;
+    M[9] = d * d;
+}
+
+float64 MeshSimplifier::Quadric::Det(uint a11, uint a12, uint a13, uint a21, uint a22, uint a23, uint a31, uint a32, uint a33) const
+{
+    return M[a11] * M[a22] * M[a33] + M[a13] * M[a21] * M[a32] + M[a12] * M[a23] * M[a31]
+         - M[a13] * M[a22] * M[a31] - M[a11] * M[a23] * M[a32] - M[a12] * M[a21] * M[a33];
+}
+
+float64 MeshSimplifier::Quadric::Error(const Vector3f& p) const
+{
+    float64 x = p.X, y = p.Y, z = p.Z;
+    return M[0] * x * x + 2 * M[1] * x * y + 2 * M[2] * x * z + 2 * M[3] * x
+         + M[4] * y * y + 2 * M[5] * y * z + 2 * M[6] * y
+         + M[7] * z * z + 2 * M[8] * z
+         + M[9];
+}
+
+MeshSimplifier::Quadric& MeshSimplifier::Quadric::operator+=(const Quadric& q)
+{
+    for (uint i = 0; i < 10; i++) M[i] += q.M[i];
+    return *this;
+}
+
+MeshSimplifier::MeshSimplifier(const float32* positions, uint vertexCount, const uint32* indices, uint indexCount)
+    : mVertices(vertexCount),
+      mTriangles(),
+      mRefs(),
+      mDeletedTriangles(0),
+      mMaxError(0),
+      mCenter(0),
+      mScale(1)
+{
+    const Vector3f* points = reinterpret_cast<const Vector3f*>(positions);
+
+    Vector3f low, high;
+    if (MeshUtil::ComputeBounds(MeshUtil::Interleaved(positions, vertexCount), low, high))
+    {
+        Vector3f size = high - low;
+        mCenter = (low + high) * 0.5f;
+        mScale = max(size.X, max(size.Y, size.Z));
+        if (mScale <= 0) mScale = 1;
+    }
+
+    for (uint i = 0; i < vertexCount; i++)
+    {
+        mVertices[i].Position = (points[i] - mCenter) / mScale;
+        mVertices[i].Border = false;
+    }
+
+    mTriangles.reserve(indexCount / 3);
+    for (uint i = 0; i + 2 < indexCount; i += 3)
+    {
+        // collapsed triangles would only get in the way
+        if (indices[i] == indices[i + 1] || indices[i + 1] == indices[i + 2] || indices[i] == indices[i + 2]) continue;
+
+        Triangle t;
+        copy(indices + i, indices + i + 3, t.V);
+        t.Deleted = false;
+        t.Dirty = false;
+
+        const Vector3f& p0 = mVertices[t.V[0]].Position;
+        Vector3f normal = Cross(mVertices[t.V[1]].Position - p0, mVertices[t.V[2]].Position - p0);
+        float32 length = Length(normal);
+        t.Normal = length > 0 ? normal / length : Vector3f(0);
+
+        if (length > 0)
+        {
+            Quadric plane(t.Normal.X, t.Normal.Y, t.Normal.Z, -Dot(t.Normal, p0));
+            for (uint j = 0; j < 3; j++) mVertices[t.V[j]].Q += plane;
+        }
+
+        mTriangles.push_back(t);
+    }
+
+    BuildRefs();
+    FindBorders();
+
+    for (Triangle& t : mTriangles)
+    {
+        UpdateErrors(t);
+    }
+}
+
+uint MeshSimplifier::Simplify(uint targetTriangles)
+{
+    vector<bool> deleted0, deleted1;
+
+    for (uint iteration = 0; iteration < MaxIterations && GetTriangleCount() > targetTriangles; iteration++)
+    {
+        // refs pile up as triangles change, start over from the live triangles now and then
+        if (iteration % 5 == 0)
+        {
+            Compact();
+            BuildRefs();
+        }
+
+        for (Triangle& t : mTriangles)
+        {
+            t.Dirty = false;
+        }
+
+        // every edge cheaper than this is collapsed in this pass
+        const float64 threshold = 1e-9 * pow(iteration + 3.0, Aggressiveness);
+
+        for (uint i = 0; i < mTriangles.size() && GetTriangleCount() > targetTriangles; i++)
+        {
+            Triangle& t = mTriangles[i];
+            if (t.Deleted || t.Dirty || t.Error[3] > threshold) continue;
+
+            for (uint j = 0; j < 3; j++)
+            {
+                if (t.Error[j] > threshold) continue;
+
+                uint32 i0 = t.V[j];
+                uint32 i1 = t.V[(j + 1) % 3];
+                Vertex& v0 = mVertices[i0];
+                Vertex& v1 = mVertices[i1];
+
+                // keep borders where they are
+                if (v0.Border != v1.Border) continue;
+
+                Vector3f position;
+                float64 error = EdgeError(i0, i1, position);
+
+                deleted0.assign(v0.RefCount, false);
+                deleted1.assign(v1.RefCount, false);
+                if (Flips(position, i0, i1, deleted0)) continue;
+                if (Flips(position, i1, i0, deleted1)) continue;
+
+                v0.Position = position;
+                v0.Q += v1.Q;
+
+                uint32 refStart = mRefs.size();
+                UpdateTriangles(i0, v0, deleted0);
+                UpdateTriangles(i0, v1, deleted1);
+                uint32 refCount = mRefs.size() - refStart;
+
+                // reuse v0's old refs when the new ones fit
+                if (refCount <= v0.RefCount)
+                {
+                    copy(mRefs.begin() + refStart, mRefs.end(), mRefs.begin() + v0.RefStart);
+                    mRefs.resize(refStart);
+                }
+                else
+                {
+                    v0.RefStart = refStart;
+                }
+                v0.RefCount = refCount;
+
+                mMaxError = max(mMaxError, error);
+                break;
+            }
+        }
+    }
+
+    return GetTriangleCount();
+}
+
+float32 MeshSimplifier::GetError() const
+{
+    return static_cast<float32>(sqrt(max(0.0, mMaxError))) * mScale;
+}
+
+void MeshSimplifier::GetMesh(vector<float32>& refPositions, vector<uint32>& refIndices) const
+{
+    const uint32 unused = 0xFFFFFFFF;
+    vector<uint32> remap(mVertices.size(), unused);
+
+    refPositions.clear();
+    refIndices.clear();
+    refIndices.reserve(GetTriangleCount() * 3);
+
+    for (const Triangle& t : mTriangles)
+    {
+        if (t.Deleted) continue;
+
+        for (uint j = 0; j < 3; j++)
+        {
+            uint32& index = remap[t.V[j]];
+            if (index == unused)
+            {
+                index = refPositions.size() / 3;
+
+                Vector3f position = mVertices[t.V[j]].Position * mScale + mCenter;
+                refPositions.push_back(position.X);
+                refPositions.push_back(position.Y);
+                refPositions.push_back(position.Z);
+            }
+            refIndices.push_back(index);
+        }
+    }
+}
+
+float64 MeshSimplifier::EdgeError(uint32 i0, uint32 i1, Vector3f& refPosition) const
+{
+    const Vertex& v0 = mVertices[i0];
+    const Vertex& v1 = mVertices[i1];
+
+    Quadric q = v0.Q;
+    q += v1.Q;
+
+    // the point with the least error, unless the quadric can't be solved or the edge is on a border
+    float64 det = q.Det(0, 1, 2, 1, 4, 5, 2, 5, 7);
+    if (abs(det) > 1e-15 && !(v0.Border && v1.Border))
+    {
+        refPosition.X = static_cast<float32>(-1 / det * q.Det(1, 2, 3, 4, 5, 6, 5, 7, 8));
+        refPosition.Y = static_cast<float32>( 1 / det * q.Det(0, 2, 3, 1, 5, 6, 2, 7, 8));
+        refPosition.Z = static_cast<float32>(-1 / det * q.Det(0, 1, 3, 1, 4, 6, 2, 5, 8));
+        return q.Error(refPosition);
+    }
+
+    const Vector3f candidates[3] = { v0.Position, v1.Position, (v0.Position + v1.Position) * 0.5f };
+    float64 best = q.Error(candidates[0]);
+    refPosition = candidates[0];
+
+    for (uint i = 1; i < 3; i++)
+    {
+        float64 error = q.Error(candidates[i]);
+        if (error < best)
+        {
+            best = error;
+            refPosition = candidates[i];
+        }
+    }
+    return best;
+}
+
+void MeshSimplifier::UpdateErrors(Triangle& refTriangle) const
+{
+    Vector3f position;
+    for (uint j = 0; j < 3; j++)
+    {
+        refTriangle.Error[j] = static_cast<float32>(EdgeError(refTriangle.V[j], refTriangle.V[(j + 1) % 3], position));
+    }
+    refTriangle.Error[3] = min(refTriangle.Error[0], min(refTriangle.Error[1], refTriangle.Error[2]));
+}
+
+bool MeshSimplifier::Flips(const Vector3f& position, uint32 i0, uint32 i1, vector<bool>& refDeleted) const
+{
+    const Vertex& vertex = mVertices[i0];
+
+    for (uint32 k = 0; k < vertex.RefCount; k++)
+    {
+        const Ref& ref = mRefs[vertex.RefStart + k];
+        const Triangle& t = mTriangles[ref.Face];
+        if (t.Deleted) continue;
+
+        uint32 id1 = t.V[(ref.Corner + 1) % 3];
+        uint32 id2 = t.V[(ref.Corner + 2) % 3];
+
+        // triangles on the edge disappear with the collapse
+        if (id1 == i1 || id2 == i1)
+        {
+            refDeleted[k] = true;
+            continue;
+        }
+
+        Vector3f d1 = mVertices[id1].Position - position;
+        Vector3f d2 = mVertices[id2].Position - position;
+        float32 length1 = Length(d1), length2 = Length(d2);
+        if (length1 == 0 || length2 == 0) return true;
+
+        d1 /= length1;
+        d2 /= length2;
+        if (abs(Dot(d1, d2)) > 0.999f) return true;
+
+        Vector3f normal = Normalize(Cross(d1, d2));
+        if (Dot(normal, t.Normal) < MinNormalDot) return true;
+    }
+
+    return false;
+}
+
+void MeshSimplifier::UpdateTriangles(uint32 i0, const Vertex& vertex, const vector<bool>& deleted)
+{
+    for (uint32 k = 0; k < vertex.RefCount; k++)
+    {
+        // copied, pushing below can move the array
+        Ref ref = mRefs[vertex.RefStart + k];
+        Triangle& t = mTriangles[ref.Face];
+        if (t.Deleted) continue;
+
+        if (deleted[k])
+        {
+            t.Deleted = true;
+            mDeletedTriangles++;
+            continue;
+        }
+
+        t.V[ref.Corner] = i0;
+        t.Dirty = true;
+
+        const Vector3f& p0 = mVertices[t.V[0]].Position;
+        Vector3f normal = Cross(mVertices[t.V[1]].Position - p0, mVertices[t.V[2]].Position - p0);
+        float32 length = Length(normal);
+        if (length > 0) t.Normal = normal / length;
+
+        UpdateErrors(t);
+        mRefs.push_back(ref);
+    }
+}
+
+void MeshSimplifier::Compact()
+{
+    mTriangles.erase(remove_if(mTriangles.begin(), mTriangles.end(), [](const Triangle& t) { return t.Deleted; }), mTriangles.end());
+    mDeletedTriangles = 0;
+}
+
+void MeshSimplifier::BuildRefs()
+{
+    for (Vertex& v : mVertices)
+    {
+        v.RefStart = 0;
+        v.RefCount = 0;
+    }
+
+    for (const Triangle& t : mTriangles)
+    {
+        for (uint j = 0; j < 3; j++) mVertices[t.V[j]].RefCount++;
+    }
+
+    uint32 start = 0;
+    for (Vertex& v : mVertices)
+    {
+        v.RefStart = start;
+        start += v.RefCount;
+        v.RefCount = 0;
+    }
+
+    mRefs.resize(mTriangles.size() * 3);
+    for (uint32 i = 0; i < mTriangles.size(); i++)
+    {
+        for (uint j = 0; j < 3; j++)
+        {
+            Vertex& v = mVertices[mTriangles[i].V[j]];
+            Ref& ref = mRefs[v.RefStart + v.RefCount++];
+            ref.Face = i;
+            ref.Corner = j;
+        }
+    }
+}
+
+void MeshSimplifier::FindBorders()
+{
+    // an edge used by only one triangle is on a border
+    vector<uint32> neighbors, counts, faces;
+
+    for (uint32 i = 0; i < mVertices.size(); i++)
+    {
+        const Vertex& vertex = mVertices[i];
+        neighbors.clear();
+        counts.clear();
+        faces.clear();
+
+        for (uint32 k = 0; k < vertex.RefCount; k++)
+        {
+            uint32 face = mRefs[vertex.RefStart + k].Face;
+            const Triangle& t = mTriangles[face];
+
+            for (uint j = 0; j < 3; j++)
+            {
+                uint32 id = t.V[j];
+                if (id == i) continue;
+
+                auto found = find(neighbors.begin(), neighbors.end(), id);
+                if (found == neighbors.end())
+                {
+                    neighbors.push_back(id);
+                    counts.push_back(1);
+                    faces.push_back(face);
+                }
+                else
+                {
+                    counts[found - neighbors.begin()]++;
+                }
+            }
+        }
+
+        for (uint j = 0; j < neighbors.size(); j++)
+        {
+            if (counts[j] != 1) continue;
+
+            mVertices[i].Border = true;
+            mVertices[neighbors[j]].Border = true;
+
+            // seen from both ends, only add the plane once
+            if (neighbors[j] < i) continue;
+
+            // a plane through the edge, upright on its triangle, holds the border in place
+            // as strongly as a face plane holds the surface
+            const Vector3f& p0 = mVertices[i].Position;
+            Vector3f normal = Cross(mVertices[neighbors[j]].Position - p0, mTriangles[faces[j]].Normal);
+            float32 length = Length(normal);
+            if (length == 0) continue;
+
+            normal /= length;
+            Quadric plane(normal.X, normal.Y, normal.Z, -Dot(normal, p0));
+            mVertices[i].Q += plane;
+            mVertices[neighbors[j]].Q += plane;
+        }
+    }
+}
+
+}
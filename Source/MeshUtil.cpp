@@ -0,0 +1,503 @@
+#include "MeshUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <string.h>
+
+#include "Math/ModelerMath.h"
+
+#include "ThreadUtil.h"
+#include "Types.h"
+
+namespace Core
+{
+
+namespace MeshUtil
+{
+
+/** Marks an empty slot in the weld table */
+static const uint32 EmptySlot = 0xFFFFFFFF;
+
+/** Fewest faces or vertices worth giving their own thread */
+static const uint64 MinRange = 1 << 16;
+
+/** Most vertices one position can be split into by GenerateNormals */
+static const uint MaxGroups = 255;
+
+/**
+ * @return bits of a float with -0 folded into 0
+ */
+static inline uint32 FloatBits(float32 value)
+{
+    uint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits << 1) == 0 ? 0 : bits;
+}
+
+static uint64 HashVertex(const float32* vertex, uint floats)
+{
+    // FNV-1a over 32 bit words, then mixed so nearby vertices spread across the table
+    uint64 hash = 14695981039346656037ULL;
+    for (uint i = 0; i < floats; i++)
+    {
+        hash ^= FloatBits(vertex[i]);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 29;
+    return hash;
+}
+
+static bool SameVertex(const float32* a, const float32* b, uint floats)
+{
+    for (uint i = 0; i < floats; i++)
+    {
+        if (FloatBits(a[i]) != FloatBits(b[i])) return false;
+    }
+    return true;
+}
+
+void WeldVertices(const float32* vertices, uint vertexCount, uint floatsPerVertex,
+        std::vector<float32>& refUnique, std::vector<uint32>& refIndices)
+{
+    refUnique.clear();
+    refIndices.resize(vertexCount);
+
+    // open addressing table of indices into refUnique, kept at most half full
+    uint64 tableSize = 16;
+    while (tableSize < (uint64)vertexCount * 2) tableSize *= 2;
+    const uint64 mask = tableSize - 1;
+    std::vector<uint32> table(tableSize, EmptySlot);
+
+    uint32 uniqueCount = 0;
+    refUnique.reserve((uint64)vertexCount * floatsPerVertex / 2);
+
+    for (uint i = 0; i < vertexCount; i++)
+    {
+        const float32* vertex = vertices + (uint64)i * floatsPerVertex;
+        uint64 slot = HashVertex(vertex, floatsPerVertex) & mask;
+
+        while (true)
+        {
+            uint32 index = table[slot];
+
+            if (index == EmptySlot)
+            {
+                table[slot] = uniqueCount;
+                refUnique.insert(refUnique.end(), vertex, vertex + floatsPerVertex);
+                refIndices[i] = uniqueCount++;
+                break;
+            }
+
+            if (SameVertex(&refUnique[(uint64)index * floatsPerVertex], vertex, floatsPerVertex))
+            {
+                refIndices[i] = index;
+                break;
+            }
+
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    refUnique.shrink_to_fit();
+}
+
+void GenerateNormals(const float32* positions, uint vertexCount, const uint32* indices, uint indexCount,
+        float32 creaseAngle, std::vector<float32>& refVertices, std::vector<uint32>& refIndices)
+{
+    using namespace Math;
+
+    const Vector3f* points = reinterpret_cast<const Vector3f*>(positions);
+    const uint faceCount = indexCount / 3;
+    const uint cornerCount = faceCount * 3;
+    const float32 cosCrease = std::cos(creaseAngle);
+
+    // unit face normals and the angle of each face at each of its corners
+    std::vector<Vector3f> faceNormals(faceCount);
+    std::vector<float32> cornerAngles(cornerCount);
+
+    Thread::ParallelFor(faceCount, MinRange, [&](uint64 begin, uint64 end)
+    {
+        for (uint64 f = begin; f < end; f++)
+        {
+            const uint32* face = indices + f * 3;
+            const Vector3f p[3] = { points[face[0]], points[face[1]], points[face[2]] };
+
+            Vector3f normal = Cross(p[1] - p[0], p[2] - p[0]);
+            float32 length = Length(normal);
+            faceNormals[f] = length > 0 ? normal / length : Vector3f(0);
+
+            for (uint k = 0; k < 3; k++)
+            {
+                Vector3f a = p[(k + 1) % 3] - p[k];
+                Vector3f b = p[(k + 2) % 3] - p[k];
+                float32 lengths = Length(a) * Length(b);
+                float32 cosAngle = lengths > 0 ? Dot(a, b) / lengths : 1;
+                cornerAngles[f * 3 + k] = std::acos(std::max(-1.0f, std::min(1.0f, cosAngle)));
+            }
+        }
+    });
+
+    // corners around each vertex, so the passes below gather instead of scattering into shared sums
+    std::vector<uint32> cornerStart(vertexCount + 1, 0);
+    for (uint i = 0; i < cornerCount; i++) cornerStart[indices[i] + 1]++;
+    for (uint v = 0; v < vertexCount; v++) cornerStart[v + 1] += cornerStart[v];
+
+    std::vector<uint32> corners(cornerCount);
+    {
+        std::vector<uint32> cursor(cornerStart.begin(), cornerStart.end() - 1);
+        for (uint i = 0; i < cornerCount; i++) corners[cursor[indices[i]]++] = i;
+    }
+
+    // group the corners of each vertex by face normal, each group becomes one output vertex
+    std::vector<uint8> cornerGroups(cornerCount, 0);
+    std::vector<uint32> vertexStart(vertexCount + 1, 0);
+
+    Thread::ParallelFor(vertexCount, MinRange, [&](uint64 begin, uint64 end)
+    {
+        std::vector<Vector3f> seeds;
+
+        for (uint64 v = begin; v < end; v++)
+        {
+            seeds.clear();
+
+            for (uint32 j = cornerStart[v]; j < cornerStart[v + 1]; j++)
+            {
+                uint32 corner = corners[j];
+                const Vector3f& normal = faceNormals[corner / 3];
+
+                // degenerate faces have no normal, they join whatever group comes first
+                if (LengthSq(normal) == 0) continue;
+
+                uint g = 0;
+                while (g < seeds.size() && Dot(seeds[g], normal) < cosCrease) g++;
+
+                if (g == seeds.size())
+                {
+                    if (g < MaxGroups) seeds.push_back(normal);
+                    else g = 0;
+                }
+                cornerGroups[corner] = g;
+            }
+
+            bool used = cornerStart[v + 1] > cornerStart[v];
+            vertexStart[v + 1] = used ? std::max<uint32>(1, seeds.size()) : 0;
+        }
+    });
+
+    for (uint v = 0; v < vertexCount; v++) vertexStart[v + 1] += vertexStart[v];
+
+    refVertices.resize((uint64)vertexStart[vertexCount] * 6);
+    refIndices.resize(cornerCount);
+
+    Thread::ParallelFor(vertexCount, MinRange, [&](uint64 begin, uint64 end)
+    {
+        std::vector<Vector3f> sums;
+
+        for (uint64 v = begin; v < end; v++)
+        {
+            uint32 first = vertexStart[v];
+            sums.assign(vertexStart[v + 1] - first, Vector3f(0));
+
+            for (uint32 j = cornerStart[v]; j < cornerStart[v + 1]; j++)
+            {
+                uint32 corner = corners[j];
+                sums[cornerGroups[corner]] += faceNormals[corner / 3] * cornerAngles[corner];
+                refIndices[corner] = first + cornerGroups[corner];
+            }
+
+            for (uint g = 0; g < sums.size(); g++)
+            {
+                float32 length = Length(sums[g]);
+                Vector3f normal = length > 0 ? sums[g] / length : Vector3f(0);
+
+                float32* out = &refVertices[(uint64)(first + g) * 6];
+                for (uint k = 0; k < 3; k++)
+                {
+                    out[k] = points[v][k];
+                    out[k + 3] = normal[k];
+                }
+            }
+        }
+    });
+}
+
+/**
+ * Transforms vectors [begin, end) by m, adding its translation to points
+ */
+static void TransformRange(const Math::Matrix4f& m, bool points, const ConstVector3Span& in, const Vector3Span& out,
+        uint64 begin, uint64 end)
+{
+    const Math::Vector4f* c = m.mMatrix;
+    const float32 w = points ? 1.0f : 0.0f;
+    uint64 i = begin;
+
+#ifdef CORE_MATH_SIMD
+    using namespace Math::Simd;
+
+    if (in.Stride == 1 && out.Stride == 1)
+    {
+        // one vector per lane, summed in the same order as m * v
+        Float4 r[4][3];
+        for (uint j = 0; j < 4; j++)
+        {
+            r[j][0] = Splat(c[j].X * (j == 3 ? w : 1.0f));
+            r[j][1] = Splat(c[j].Y * (j == 3 ? w : 1.0f));
+            r[j][2] = Splat(c[j].Z * (j == 3 ? w : 1.0f));
+        }
+
+        for (; i + 4 <= end; i += 4)
+        {
+            Float4 x = Load(in.X + i);
+            Float4 y = Load(in.Y + i);
+            Float4 z = Load(in.Z + i);
+            for (uint k = 0; k < 3; k++)
+            {
+                Float4 sum = Add(Add(Add(Mul(r[0][k], x), Mul(r[1][k], y)), Mul(r[2][k], z)), r[3][k]);
+                Store((k == 0 ? out.X : k == 1 ? out.Y : out.Z) + i, sum);
+            }
+        }
+    }
+    else
+    {
+        // one vector per step, the columns scaled by its x, y and z
+        const Float4 c0 = Load(&c[0].X);
+        const Float4 c1 = Load(&c[1].X);
+        const Float4 c2 = Load(&c[2].X);
+        const Float4 c3 = Mul(Load(&c[3].X), Splat(w));
+
+        for (; i < end; i++)
+        {
+            Float4 sum = Mul(c0, Splat(in.X[i * in.Stride]));
+            sum = Add(sum, Mul(c1, Splat(in.Y[i * in.Stride])));
+            sum = Add(sum, Mul(c2, Splat(in.Z[i * in.Stride])));
+            sum = Add(sum, c3);
+
+            // a full store could run past the last vector
+            float32 result[4];
+            Store(result, sum);
+            out.X[i * out.Stride] = result[0];
+            out.Y[i * out.Stride] = result[1];
+            out.Z[i * out.Stride] = result[2];
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        const float32 x = in.X[i * in.Stride];
+        const float32 y = in.Y[i * in.Stride];
+        const float32 z = in.Z[i * in.Stride];
+        out.X[i * out.Stride] = c[0].X * x + c[1].X * y + c[2].X * z + c[3].X * w;
+        out.Y[i * out.Stride] = c[0].Y * x + c[1].Y * y + c[2].Y * z + c[3].Y * w;
+        out.Z[i * out.Stride] = c[0].Z * x + c[1].Z * y + c[2].Z * z + c[3].Z * w;
+    }
+}
+
+void TransformPoints(const Math::Matrix4f& m, const ConstVector3Span& in, const Vector3Span& out)
+{
+    Thread::ParallelFor(in.Count, MinRange, [&](uint64 begin, uint64 end)
+    {
+        TransformRange(m, true, in, out, begin, end);
+    });
+}
+
+void TransformDirections(const Math::Matrix4f& m, const ConstVector3Span& in, const Vector3Span& out)
+{
+    Thread::ParallelFor(in.Count, MinRange, [&](uint64 begin, uint64 end)
+    {
+        TransformRange(m, false, in, out, begin, end);
+    });
+}
+
+void TransformDirections(const Math::Quaternionf& q, const ConstVector3Span& in, const Vector3Span& out)
+{
+    TransformDirections(Math::Quaternionf::ToRotation(q), in, out);
+}
+
+void NormalizeArray(const Vector3Span& vectors)
+{
+    Thread::ParallelFor(vectors.Count, MinRange, [&](uint64 begin, uint64 end)
+    {
+        float32* X = vectors.X;
+        float32* Y = vectors.Y;
+        float32* Z = vectors.Z;
+        const uint stride = vectors.Stride;
+        uint64 i = begin;
+
+#ifdef CORE_MATH_SIMD
+        using namespace Math::Simd;
+
+        if (stride == 1)
+        {
+            const Float4 zero = Splat(0);
+            for (; i + 4 <= end; i += 4)
+            {
+                Float4 x = Load(X + i);
+                Float4 y = Load(Y + i);
+                Float4 z = Load(Z + i);
+                Float4 lengthSq = Add(Add(Mul(x, x), Mul(y, y)), Mul(z, z));
+
+                // zero vectors divide to NaN, the mask turns them back into zero
+                Float4 length = Sqrt(lengthSq);
+                Float4 nonZero = Greater(lengthSq, zero);
+                Store(X + i, And(Div(x, length), nonZero));
+                Store(Y + i, And(Div(y, length), nonZero));
+                Store(Z + i, And(Div(z, length), nonZero));
+            }
+        }
+#endif
+
+        for (; i < end; i++)
+        {
+            Math::Vector3f v = Math::Normalize(Math::Vector3f(X[i * stride], Y[i * stride], Z[i * stride]));
+            X[i * stride] = v.X;
+            Y[i * stride] = v.Y;
+            Z[i * stride] = v.Z;
+        }
+    });
+}
+
+void CrossArray(const ConstVector3Span& a, const ConstVector3Span& b, const Vector3Span& out)
+{
+    Thread::ParallelFor(a.Count, MinRange, [&](uint64 begin, uint64 end)
+    {
+        uint64 i = begin;
+
+#ifdef CORE_MATH_SIMD
+        using namespace Math::Simd;
+
+        if (a.Stride == 1 && b.Stride == 1 && out.Stride == 1)
+        {
+            for (; i + 4 <= end; i += 4)
+            {
+                Float4 ax = Load(a.X + i), ay = Load(a.Y + i), az = Load(a.Z + i);
+                Float4 bx = Load(b.X + i), by = Load(b.Y + i), bz = Load(b.Z + i);
+                Store(out.X + i, Sub(Mul(ay, bz), Mul(az, by)));
+                Store(out.Y + i, Sub(Mul(az, bx), Mul(ax, bz)));
+                Store(out.Z + i, Sub(Mul(ax, by), Mul(ay, bx)));
+            }
+        }
+#endif
+
+        for (; i < end; i++)
+        {
+            const float32 ax = a.X[i * a.Stride], ay = a.Y[i * a.Stride], az = a.Z[i * a.Stride];
+            const float32 bx = b.X[i * b.Stride], by = b.Y[i * b.Stride], bz = b.Z[i * b.Stride];
+            out.X[i * out.Stride] = ay * bz - az * by;
+            out.Y[i * out.Stride] = az * bx - ax * bz;
+            out.Z[i * out.Stride] = ax * by - ay * bx;
+        }
+    });
+}
+
+void DotArray(const ConstVector3Span& a, const ConstVector3Span& b, float32* out)
+{
+    Thread::ParallelFor(a.Count, MinRange, [&](uint64 begin, uint64 end)
+    {
+        uint64 i = begin;
+
+#ifdef CORE_MATH_SIMD
+        using namespace Math::Simd;
+
+        if (a.Stride == 1 && b.Stride == 1)
+        {
+            for (; i + 4 <= end; i += 4)
+            {
+                Float4 dot = Mul(Load(a.X + i), Load(b.X + i));
+                dot = Add(dot, Mul(Load(a.Y + i), Load(b.Y + i)));
+                dot = Add(dot, Mul(Load(a.Z + i), Load(b.Z + i)));
+                Store(out + i, dot);
+            }
+        }
+#endif
+
+        for (; i < end; i++)
+        {
+            out[i] = a.X[i * a.Stride] * b.X[i * b.Stride] + a.Y[i * a.Stride] * b.Y[i * b.Stride] +
+                    a.Z[i * a.Stride] * b.Z[i * b.Stride];
+        }
+    });
+}
+
+bool ComputeBounds(const ConstVector3Span& vectors, Math::Vector3f& refLow, Math::Vector3f& refHigh)
+{
+    if (vectors.Count == 0) return false;
+
+    const float32* X = vectors.X;
+    const float32* Y = vectors.Y;
+    const float32* Z = vectors.Z;
+    const uint stride = vectors.Stride;
+
+    Math::Vector3f low(X[0], Y[0], Z[0]);
+    Math::Vector3f high = low;
+    std::mutex boundsMutex;
+
+    Thread::ParallelFor(vectors.Count, MinRange, [&](uint64 begin, uint64 end)
+    {
+        Math::Vector3f rangeLow(X[begin * stride], Y[begin * stride], Z[begin * stride]);
+        Math::Vector3f rangeHigh = rangeLow;
+        uint64 i = begin;
+
+#ifdef CORE_MATH_SIMD
+        using namespace Math::Simd;
+
+        if (stride == 1 && end - begin >= 4)
+        {
+            Float4 lowX = Load(X + i), lowY = Load(Y + i), lowZ = Load(Z + i);
+            Float4 highX = lowX, highY = lowY, highZ = lowZ;
+            for (i += 4; i + 4 <= end; i += 4)
+            {
+                Float4 x = Load(X + i), y = Load(Y + i), z = Load(Z + i);
+                lowX = Min(lowX, x);
+                lowY = Min(lowY, y);
+                lowZ = Min(lowZ, z);
+                highX = Max(highX, x);
+                highY = Max(highY, y);
+                highZ = Max(highZ, z);
+            }
+
+            float32 lanes[6][4];
+            Store(lanes[0], lowX);
+            Store(lanes[1], lowY);
+            Store(lanes[2], lowZ);
+            Store(lanes[3], highX);
+            Store(lanes[4], highY);
+            Store(lanes[5], highZ);
+            for (uint j = 0; j < 4; j++)
+            {
+                for (uint k = 0; k < 3; k++)
+                {
+                    rangeLow[k] = std::min(rangeLow[k], lanes[k][j]);
+                    rangeHigh[k] = std::max(rangeHigh[k], lanes[k + 3][j]);
+                }
+            }
+        }
+#endif
+
+        for (; i < end; i++)
+        {
+            const Math::Vector3f v(X[i * stride], Y[i * stride], Z[i * stride]);
+            for (uint k = 0; k < 3; k++)
+            {
+                rangeLow[k] = std::min(rangeLow[k], v[k]);
+                rangeHigh[k] = std::max(rangeHigh[k], v[k]);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(boundsMutex);
+        for (uint k = 0; k < 3; k++)
+        {
+            low[k] = std::min(low[k], rangeLow[k]);
+            high[k] = std::max(high[k], rangeHigh[k]);
+        }
+    });
+
+    refLow = low;
+    refHigh = high;
+    return true;
+}
+
+}
+
+}
@@ -0,0 +1,386 @@
+#include "ModelLoader.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <boost/filesystem.hpp>
+
+#include "Math/ModelerMath.h"
+
+#include "FileIO.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshUtil.h"
+#include "Profiler.h"
+
+using namespace std;
+using namespace Core::Math;
+
+namespace Core
+{
+
+static const Video::VertexFormat MeshFormat = Video::VertexFormat()
+        .AddElement(Video::Attribute::Position, 3)
+        .AddElement(Video::Attribute::Normal, 3);
+
+/**
+ * Identifies how BuildMesh builds vertices, change it whenever that changes so old caches are rebuilt.
+ * The crease angle is added to the low 8 bits and OptimizedBuild when meshes are reordered for drawing.
+ */
+static const uint32 MeshBuildKey = 5 << 8;
+
+static const uint32 OptimizedBuild = 1 << 16;
+
+/** Triangles built between checks for a cancel */
+static const uint CancelInterval = 4096;
+
+/** Levels of detail stop before going under this many triangles */
+static const uint MinLodTriangles = 1024;
+
+/** Each level of detail keeps about one in this many triangles of the level before */
+static const uint LodReduction = 4;
+
+/** Most levels of detail below full detail */
+static const uint MaxLods = 6;
+
+/**
+ * @return true if every corner of every triangle has a position and a normal from the file
+ */
+static bool HasFileNormals(const ObjMesh& mesh)
+{
+    if (mesh.GetNormalCount() == 0) return false;
+
+    for (uint i = 0; i < mesh.FaceElements.size(); i += 3)
+    {
+        if (mesh.FaceElements[i] - 1 >= mesh.GetVertexCount()) return false;
+        if (mesh.FaceElements[i + 2] - 1 >= mesh.GetNormalCount()) return false;
+    }
+    return true;
+}
+
+/**
+ * Uses the normals stored in the file, corners with the same position and normal share a vertex
+ *
+ * @return false if the load was cancelled
+ */
+static bool BuildWithFileNormals(const ObjMesh& mesh, ObjLoadProgress& progress, MeshData& refMesh)
+{
+    const uint cornerCount = mesh.GetTriangleCount() * 3;
+    const float32* positions = mesh.GeometricVertices.data();
+    const float32* normals = mesh.NormalVertices.data();
+
+    vector<float32> corners((uint64)cornerCount * 6);
+    for (uint i = 0; i < cornerCount; i++)
+    {
+        if (i % (CancelInterval * 3) == 0 && progress.Cancelled) return false;
+
+        const uint32* corner = &mesh.FaceElements[i * 3];
+        copy(positions + (corner[0] - 1) * 3, positions + corner[0] * 3, &corners[i * 6]);
+        copy(normals + (corner[2] - 1) * 3, normals + corner[2] * 3, &corners[i * 6 + 3]);
+    }
+
+    if (progress.Cancelled) return false;
+
+    MeshUtil::WeldVertices(corners.data(), cornerCount, 6, refMesh.Vertices, refMesh.Indices);
+    return true;
+}
+
+/**
+ * Generates smooth normals, split where faces meet at more than creaseAngle
+ *
+ * @return false if the load was cancelled
+ */
+static bool BuildWithGeneratedNormals(const ObjMesh& mesh, float32 creaseAngle, ObjLoadProgress& progress,
+        MeshData& refMesh)
+{
+    //the file's position indices already tell which corners share a vertex
+    vector<uint32> indices;
+    indices.reserve(mesh.GetTriangleCount() * 3);
+
+    for (uint i = 0; i < mesh.GetTriangleCount(); i++)
+    {
+        if (i % CancelInterval == 0 && progress.Cancelled) return false;
+
+        const uint32* face = &mesh.FaceElements[i * 9];
+        uint32 a = face[0] - 1, b = face[3] - 1, c = face[6] - 1;
+
+        //skip triangles that point at positions the file doesn't have
+        if (a >= mesh.GetVertexCount() || b >= mesh.GetVertexCount() || c >= mesh.GetVertexCount()) continue;
+
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+
+    if (progress.Cancelled) return false;
+
+    MeshUtil::GenerateNormals(mesh.GeometricVertices.data(), mesh.GetVertexCount(), indices.data(), indices.size(),
+            creaseAngle, refMesh.Vertices, refMesh.Indices);
+    return true;
+}
+
+/**
+ * Adds simplified levels of detail after the full detail mesh, all sharing its vertex and index arrays
+ *
+ * @return false if the load was cancelled
+ */
+static bool BuildLods(float32 creaseAngle, ObjLoadProgress& progress, MeshData& refMesh)
+{
+    PROFILE_ZONE("BuildLods");
+
+    const uint stride = refMesh.Format.GetSizeInFloats();
+
+    MeshLod full = { 0, (uint32)refMesh.Indices.size(), 0.0f };
+    refMesh.Lods.assign(1, full);
+
+    uint triangles = refMesh.Indices.size() / 3;
+    if (triangles / LodReduction < MinLodTriangles) return true;
+
+    //simplify the surface, not the seams where normals are split
+    vector<float32> positions(refMesh.VertexCount * 3);
+    for (uint i = 0; i < refMesh.VertexCount; i++)
+    {
+        copy(&refMesh.Vertices[i * stride], &refMesh.Vertices[i * stride] + 3, &positions[i * 3]);
+    }
+
+    vector<float32> uniquePositions;
+    vector<uint32> remap;
+    MeshUtil::WeldVertices(positions.data(), refMesh.VertexCount, 3, uniquePositions, remap);
+
+    vector<uint32> surface(refMesh.Indices.size());
+    for (uint i = 0; i < surface.size(); i++)
+    {
+        surface[i] = remap[refMesh.Indices[i]];
+    }
+
+    MeshSimplifier simplifier(uniquePositions.data(), uniquePositions.size() / 3, surface.data(), surface.size());
+
+    vector<float32> lodPositions, lodVertices;
+    vector<uint32> lodSurface, lodIndices;
+
+    for (uint i = 0; i < MaxLods && triangles / LodReduction >= MinLodTriangles; i++)
+    {
+        if (progress.Cancelled) return false;
+
+        uint left = simplifier.Simplify(triangles / LodReduction);
+        if (left > triangles * 3 / 4) break;
+
+        simplifier.GetMesh(lodPositions, lodSurface);
+        MeshUtil::GenerateNormals(lodPositions.data(), lodPositions.size() / 3, lodSurface.data(), lodSurface.size(),
+                creaseAngle, lodVertices, lodIndices);
+
+        MeshLod lod = { (uint32)refMesh.Indices.size(), (uint32)lodIndices.size(), simplifier.GetError() };
+        refMesh.Lods.push_back(lod);
+
+        uint32 base = refMesh.VertexCount;
+        refMesh.Vertices.insert(refMesh.Vertices.end(), lodVertices.begin(), lodVertices.end());
+        for (uint32 index : lodIndices)
+        {
+            refMesh.Indices.push_back(base + index);
+        }
+        refMesh.VertexCount += lodVertices.size() / stride;
+
+        triangles = left;
+    }
+
+    return true;
+}
+
+/**
+ * Reorders each level of detail's triangles for the vertex cache and overdraw, then the vertices
+ * into the order they are first drawn in. The full detail mesh's cache miss ratios before and after
+ * go to the profiler.
+ *
+ * @return false if the load was cancelled
+ */
+static bool OptimizeMesh(ObjLoadProgress& progress, MeshData& refMesh)
+{
+    PROFILE_ZONE("OptimizeMesh");
+
+    const uint stride = refMesh.Format.GetSizeInFloats();
+    const MeshLod& full = refMesh.Lods[0];
+
+    MeshOptimizer::VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(&refMesh.Indices[full.IndexStart],
+            full.IndexCount, refMesh.VertexCount);
+
+    Profiler::Counter("Vertex cache ACMR", before.Acmr);
+    Profiler::Counter("Vertex cache ATVR", before.Atvr);
+
+    for (const MeshLod& lod : refMesh.Lods)
+    {
+        if (progress.Cancelled) return false;
+
+        uint32* indices = &refMesh.Indices[lod.IndexStart];
+        MeshOptimizer::OptimizeVertexCache(indices, lod.IndexCount, refMesh.VertexCount);
+        MeshOptimizer::OptimizeOverdraw(indices, lod.IndexCount, refMesh.Vertices.data(), refMesh.VertexCount, stride);
+    }
+
+    if (progress.Cancelled) return false;
+
+    refMesh.VertexCount = MeshOptimizer::OptimizeVertexFetch(refMesh.Vertices.data(), refMesh.VertexCount, stride,
+            refMesh.Indices.data(), refMesh.Indices.size());
+    refMesh.Vertices.resize((uint64)refMesh.VertexCount * stride);
+
+    MeshOptimizer::VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(&refMesh.Indices[full.IndexStart],
+            full.IndexCount, refMesh.VertexCount);
+
+    Profiler::Counter("Vertex cache ACMR", after.Acmr);
+    Profiler::Counter("Vertex cache ATVR", after.Atvr);
+    return true;
+}
+
+/**
+ * Parses a .obj file and builds an indexed triangle list from it, using the file's normals if
+ * it has them for every corner and generating them otherwise, followed by its levels of detail
+ *
+ * @param creaseAngle in degrees, faces meeting at a sharper angle don't share generated normals
+ * @param optimize reorders the mesh for drawing once it is built
+ * @return false if the file can't be read or the load was cancelled
+ */
+static bool BuildMesh(const string& file, uint32 creaseAngle, bool optimize, ObjLoadProgress& progress,
+        MeshData& refMesh)
+{
+    PROFILE_ZONE("BuildMesh");
+
+    FileIO objFile;
+    ObjMesh mesh;
+
+    if (!objFile.LoadObjMesh(boost::filesystem::path(file), mesh, 0, &progress)) return false;
+
+    for (float32& value : mesh.GeometricVertices)
+    {
+        value *= 1.5f;
+    }
+
+    if (progress.Cancelled) return false;
+
+    const float32 crease = ToRadians((float32)creaseAngle);
+
+    bool built;
+    if (HasFileNormals(mesh))
+    {
+        built = BuildWithFileNormals(mesh, progress, refMesh);
+    }
+    else
+    {
+        if (mesh.GetNormalCount() > 0)
+        {
+            cout << "Not every face of " << file << " has usable normals, generating normals for the whole model" << endl;
+        }
+        built = BuildWithGeneratedNormals(mesh, crease, progress, refMesh);
+    }
+    if (!built) return false;
+
+    refMesh.Format = MeshFormat;
+    refMesh.VertexCount = refMesh.Vertices.size() / MeshFormat.GetSizeInFloats();
+
+    mesh = ObjMesh();
+    if (!BuildLods(crease, progress, refMesh) || progress.Cancelled) return false;
+
+    if (optimize && !OptimizeMesh(progress, refMesh)) return false;
+    return !progress.Cancelled;
+}
+
+ModelLoader::ModelLoader(const UploadFunction& upload)
+    : mUpload(upload),
+      mJob(),
+      mTask(),
+      mCreaseAngle(60),
+      mOptimize(true)
+{
+}
+
+ModelLoader::~ModelLoader()
+{
+    Cancel();
+    Join();
+}
+
+void ModelLoader::Load(const string& file)
+{
+    Cancel();
+
+    mTask = make_shared<Task>();
+    mTask->File = file;
+    mTask->CreaseAngle = mCreaseAngle;
+    mTask->Optimize = mOptimize;
+    mTask->Status = State::Loading;
+
+    shared_ptr<Task> task = mTask;
+    UploadFunction upload = mUpload;
+    mJob = Thread::Run([task, upload] { Run(task, upload); }, { mJob });
+}
+
+void ModelLoader::Cancel()
+{
+    if (mTask) mTask->Progress.Cancelled = true;
+}
+
+void ModelLoader::SetCreaseAngle(uint32 degrees)
+{
+    mCreaseAngle = min<uint32>(degrees, 180);
+}
+
+void ModelLoader::Run(const shared_ptr<Task>& task, const UploadFunction& upload)
+{
+    PROFILE_ZONE("ModelLoader::Run");
+
+    const uint32 buildKey = MeshBuildKey | task->CreaseAngle | (task->Optimize ? OptimizedBuild : 0);
+    if (task->Progress.Cancelled)
+    {
+        task->Status = State::Cancelled;
+        return;
+    }
+
+    //a cached mesh stays mapped until it's uploaded
+    if (task->Cache.Open(task->File, buildKey))
+    {
+        cout << "Using mesh cache: " << MeshCache::GetCachePath(task->File) << endl;
+    }
+    else if (BuildMesh(task->File, task->CreaseAngle, task->Optimize, task->Progress, task->Mesh))
+    {
+        if (!MeshCache::Write(task->File, buildKey, task->Mesh, &task->Progress.Cancelled) && !task->Progress.Cancelled)
+        {
+            cout << "Could not write mesh cache: " << MeshCache::GetCachePath(task->File) << endl;
+        }
+    }
+    else if (!task->Progress.Cancelled)
+    {
+        cout << "Error reading model: " << task->File << endl;
+        task->Status = State::Failed;
+        return;
+    }
+
+    if (task->Progress.Cancelled)
+    {
+        task->Status = State::Cancelled;
+        return;
+    }
+
+    Thread::RunOnMainThread([task, upload] { Upload(task, upload); });
+}
+
+void ModelLoader::Upload(const shared_ptr<Task>& task, const UploadFunction& upload)
+{
+    if (task->Progress.Cancelled)
+    {
+        task->Status = State::Cancelled;
+    }
+    else
+    {
+        upload(task->File, task->Cache.IsOpen() ? task->Cache.GetMesh() : MeshView(task->Mesh));
+        task->Status = State::Done;
+    }
+
+    task->Cache.Close();
+    task->Mesh = MeshData();
+}
+
+void ModelLoader::Join()
+{
+    Thread::Wait(mJob);
+    mJob = nullptr;
+}
+
+}
@@ -2,6 +2,8 @@
 
 #include <cmath>
 #include <iostream>
+#include <sstream>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 #include <GL/glew.h>
@@ -10,9 +12,11 @@
 #include "GUI/IAction.h"
 #include "Math/ModelerMath.h"
 
-#include "FileIO.h"
 #include "GuiRenderer.h"
+#include "ModelLoader.h"
 #include "ModelerActions.h"
+#include "Profiler.h"
+#include "lodepng.h"
 
 using namespace std;
 using namespace Core;
@@ -75,94 +79,224 @@ std::string FragSource = ""
         "   gl_FragColor = vec4(Color * (diffuse * 0.4 + 0.4 + specular * 0.4), 1.0); \n"
         "} \n";
 
+/** VertSource for copies of a model drawn as instances, each with its own matrices and color */
+std::string InstancedVertSource = ""
+        "#version 120 \n"
+        ""
+        "attribute vec3 aPosition; \n"
+        "attribute vec3 aNormal; \n"
+        "attribute vec4 aModel0; \n"
+        "attribute vec4 aModel1; \n"
+        "attribute vec4 aModel2; \n"
+        "attribute vec4 aModel3; \n"
+        "attribute vec3 aNormalMat0; \n"
+        "attribute vec3 aNormalMat1; \n"
+        "attribute vec3 aNormalMat2; \n"
+        "attribute vec3 aColor; \n"
+        ""
+        "varying vec3 vViewPosition; \n"
+        "varying vec3 vNormal; \n"
+        "varying vec3 vColor; \n"
+        ""
+        "uniform mat4 Projection; \n"
+        "uniform mat4 View; \n"
+        ""
+        "void main() \n"
+        "{ \n"
+        "   mat4 model = mat4(aModel0, aModel1, aModel2, aModel3); \n"
+        "   mat3 normalMat = mat3(aNormalMat0, aNormalMat1, aNormalMat2); \n"
+        "   vNormal = normalize(normalMat * aNormal); \n"
+        "   vColor = aColor; \n"
+        "   gl_Position = View * model * vec4(aPosition, 1.0); \n"
+        "   vViewPosition = gl_Position.xyz; \n "
+        "   gl_Position = Projection * gl_Position; \n"
+        "} \n";
+
+/** FragSource with the color coming from InstancedVertSource */
+std::string InstancedFragSource = ""
+        "#version 120 \n"
+        ""
+        "varying vec3 vViewPosition; \n"
+        "varying vec3 vNormal; \n"
+        "varying vec3 vColor; \n"
+        ""
+        "uniform vec3 LightDirection = vec3(-1, -0.5, -1); \n"
+        "uniform mat4 View; \n"
+        ""
+        "float Diffuse(vec3 normal, vec3 lightDir) \n"
+        "{ \n"
+        "   return clamp((dot(normal, -lightDir)), 0.0, 1.0); \n"
+        "} \n"
+        ""
+        "float Specular(vec3 normal, vec3 lightDir, vec3 cameraDir, float power) \n"
+        "{ \n"
+        "   vec3 halfVec = normalize(lightDir + cameraDir); \n"
+        "   return pow(clamp(dot(normal, -halfVec), 0.0, 1.0), power); "
+        "} \n"
+        ""
+        "void main() \n"
+        "{ \n"
+        "   vec3 normal = normalize((View * vec4(vNormal, 0.0)).xyz); \n"
+        "   vec3 lightDir = normalize((View * vec4(LightDirection, 1.0)).xyz); \n"
+        "   vec3 cameraDir = normalize(vViewPosition); \n"
+        ""
+        "   float diffuse = Diffuse(normal, lightDir); \n"
+        "   float specular = Specular(normal, lightDir, cameraDir, 100); \n"
+        ""
+        "   gl_FragColor = vec4(vColor * (diffuse * 0.4 + 0.4 + specular * 0.4), 1.0); \n"
+        "} \n";
+
 Video::IShader* Shader = nullptr;
 
-float Angle = 0.0f;
+/** Levels of detail may stray this many pixels from the full detail model */
+static const float32 LodPixelError = 1.0f;
 
-namespace Core
-{
+/** Seconds between frames that show load progress, nothing else redraws while a load runs */
+static const float64 LoadProgressInterval = 0.1;
+
+/** Gap between models placed side by side, as a fraction of the width of the one being placed */
+static const float32 ModelSpacing = 0.25f;
 
-Video::VertexFormat vboFormat = Video::VertexFormat()
-        .AddElement(Video::Attribute::Position, 3)
-        .AddElement(Video::Attribute::Normal, 3);
+float Angle = 0.0f;
 
-struct VertexPosition3Normal3
+namespace Core
 {
-    Vector3f Position;
-    Vector3f Normal;
-};
 
 Modeler3D::Modeler3D(IBackend* backend)
     : Application(backend),
       mEnv(nullptr),
       mGuiRenderer(nullptr),
       mShader(nullptr),
-      mGeometry(nullptr),
-      mVbo(nullptr),
+      mInstancedShader(nullptr),
+      mScene(nullptr),
+      mMeshes(),
+      mSelected(Scene::None),
+      mRightEdge(0),
+      mLoader(new ModelLoader([this](const string& file, const MeshView& mesh) { UploadMesh(file, mesh); })),
+      mLoadStatus(nullptr),
       mAngle(0),
 	  mMouse(backend->GetWindow()->GetMouse()),
 	  mCamera(new Camera(backend->GetWindow()->GetWidth(),backend->GetWindow()->GetHeight(), Math::Vector3f(0,0,1), Math::Quaternionf())),
 	  mZoom(2),
 	  mColor(Vector3f(0.8, 0.6, 0.4)),
-	  mScale(Vector3f(1)) {}
+	  mScale(Vector3f(1)),
+	  mScreenshot(),
+	  mScreenshotSaved(false) {}
 
-Modeler3D::~Modeler3D() {}
+Modeler3D::~Modeler3D()
+{
+    delete mLoader;
+}
 
 void Modeler3D::LoadObj(const string& file)
 {
-    boost::filesystem::path obj(file);
+    auto loaded = mMeshes.find(file);
+    if (loaded != mMeshes.end() && mScene->IsValidMesh(loaded->second))
+    {
+        AddModel(loaded->second);
+        mLoadStatus->SetText("Added " + boost::filesystem::path(file).filename().string());
+        Invalidate();
+        return;
+    }
 
-	FileIO objFile;
+    mLoader->Load(file);
+}
 
-	vector<VertexPosition3Normal3> vertices;
+void Modeler3D::Clear()
+{
+    mLoader->Cancel();
+    mScene->Clear();
+    mMeshes.clear();
+    mSelected = Scene::None;
+    mRightEdge = 0;
+    mLoadStatus->SetText("No model loaded");
+    Invalidate();
+}
+
+void Modeler3D::CancelLoad()
+{
+    mLoader->Cancel();
+}
 
-    std::vector<std::vector<double>> positions;
-    std::vector<std::vector<double>> textures;
-    std::vector<std::vector<double>> normals;
-    std::vector<std::vector<std::vector<int>>> faces;
+void Modeler3D::UpdateLoad()
+{
+    switch (mLoader->GetState())
+    {
+    case ModelLoader::State::Loading:
+    {
+        stringstream stream;
+        stream << "Loading " << (int32)(mLoader->GetProgress() * 100) << "%";
+        mLoadStatus->SetText(stream.str());
 
-    objFile.LoadObj2(obj , positions, textures, normals, faces);
+        //also keeps the loop checking on the loader
+        Invalidate(LoadProgressInterval);
+        break;
+    }
+    case ModelLoader::State::Failed:
+        mLoadStatus->SetText("Load failed");
+        break;
+    case ModelLoader::State::Cancelled:
+        mLoadStatus->SetText("Load cancelled");
+        break;
+    default:
+        break;
+    }
+}
 
-    for (uint i = 0; i < faces.size(); i++)
+void Modeler3D::UploadMesh(const string& file, const MeshView& data)
+{
+    Scene::MeshId mesh = mScene->AddMesh(data);
+    if (mesh != Scene::None)
     {
-        VertexPosition3Normal3 verts[3];
-        for (uint j = 0; j < 3; j++)
-        {
-            vector<double> pos = positions[faces[i][j][0] - 1];
+        mMeshes[file] = mesh;
+        AddModel(mesh);
+    }
 
-            for (uint k = 0; k < 3; k++)
-            {
-                verts[j].Position[k] = pos[k] * 1.5;
-            }
-        }
+    BufferMemoryStats memory = Graphics->GetBufferMemory();
+    Profiler::Counter("Buffer KB on GPU", memory.GpuBytes / 1024.0);
+    Profiler::Counter("Buffer KB in system memory", memory.ShadowBytes / 1024.0);
+
+    mLoadStatus->SetText("Loaded " + boost::filesystem::path(file).filename().string());
+    Invalidate();
+}
 
-        Vector3f normal = Cross(Normalize( verts[1].Position -  verts[0].Position), Normalize( verts[2].Position -  verts[0].Position));
-        verts[0].Normal = normal;
-        verts[1].Normal = normal;
-        verts[2].Normal = normal;
+void Modeler3D::AddModel(Scene::MeshId mesh)
+{
+    Vector3f low, high;
+    mScene->GetMeshBounds(mesh, low, high);
+
+    Scene::ObjectId object = mScene->Add(mesh, mShader);
+    mScene->SetColor(object, mColor);
 
-        vertices.push_back(verts[0]);
-        vertices.push_back(verts[1]);
-        vertices.push_back(verts[2]);
+    //the first model stays at the origin the camera looks at
+    float32 x = 0;
+    if (mScene->GetCount() > 1)
+    {
+        x = mRightEdge + (high.X - low.X) * ModelSpacing - low.X;
+        mScene->GetTransforms().SetPosition(mScene->GetNode(object), Vector3f(x, 0, 0));
     }
 
-    mVbo = Graphics->CreateVertexBuffer(vboFormat, vertices.size(), Video::BufferHint::Static);
-    mVbo->SetData((float32*)(&vertices[0]), 0, vertices.size());
-    mGeometry->SetVertexBuffer(mVbo);
+    mRightEdge = x + high.X;
+    mSelected = object;
 }
 
 void Modeler3D::OnInit()
 {
     cout << "Initializing Modeler3D" << endl;
 
-    mGeometry = Graphics->CreateGeometry();
+    //nothing moves on its own, input and loads redraw the window
+    SetRenderOnDemand(true);
+
+    mScene = new Scene(Graphics);
+    mScene->GetTransforms().SetScale(mScene->GetRoot(), mScale);
 
     mEnv = Backend->GetWindow()->GetEnvironment();
     mGuiRenderer = new GuiRenderer(Graphics);
     mShader = Graphics->CreateShader(VertSource, FragSource);
+    mInstancedShader = Graphics->CreateShader(InstancedVertSource, InstancedFragSource);
+    mScene->SetInstancedShader(mShader, mInstancedShader);
 
-    Video::ITexture2D* tex = Graphics->CreateTexture2D("Assets/button.png");
-    mGuiRenderer->SetTexture(tex);
+    mGuiRenderer->SetImage(GuiRenderer::Image::Button);
 
     //Create load buttons
     Gui::Widget* LoadButton1 = new Gui::Button(10, 10 + 50 * 0, 80, 40, new LoadAction(this, "Assets/bunny.obj"), "bunny");
@@ -170,6 +304,11 @@ void Modeler3D::OnInit()
     Gui::Widget* LoadButton3 = new Gui::Button(10, 10 + 50 * 2, 80, 40, new LoadAction(this, "Assets/dragon-big.obj"), "dragon");
     Gui::Widget* LoadButton4 = new Gui::Button(10, 10 + 50 * 3, 80, 40, new LoadAction(this, "Assets/ferrari.obj"), "ferrari");
 
+    //Create load status display and cancel button
+    mLoadStatus = new Gui::Button(100, 10 + 50 * 0, 200, 40, new NoOpAction(), "No model loaded");
+    Gui::Widget* CancelLoadButton = new Gui::Button(100, 10 + 50 * 1, 80, 40, new CancelLoadAction(this), "Cancel");
+    Gui::Widget* ClearButton = new Gui::Button(100, 10 + 50 * 2, 80, 40, new ClearAction(this), "Clear");
+
     //Create zoom buttons
     Gui::Widget* ZoomButton1 = new Gui::Button(10, 10 + 50 * 0,96,40, new ZoomAction(this, mCamera, 1), "Zoom 1x");
     Gui::Widget* ZoomButton2 = new Gui::Button(10, 10 + 50 * 1,96,40, new ZoomAction(this, mCamera, 50), "Zoom 50x");
@@ -207,6 +346,9 @@ void Modeler3D::OnInit()
     LoadButton2->SetAlignment(0, 1);
     LoadButton3->SetAlignment(0, 1);
     LoadButton4->SetAlignment(0, 1);
+    mLoadStatus->SetAlignment(0, 1);
+    CancelLoadButton->SetAlignment(0, 1);
+    ClearButton->SetAlignment(0, 1);
 
     ZoomButton1->SetAlignment(1, 1);
     ZoomButton2->SetAlignment(1, 1);
@@ -237,6 +379,9 @@ void Modeler3D::OnInit()
     mEnv->AddWidget(LoadButton2);
     mEnv->AddWidget(LoadButton3);
     mEnv->AddWidget(LoadButton4);
+    mEnv->AddWidget(mLoadStatus);
+    mEnv->AddWidget(CancelLoadButton);
+    mEnv->AddWidget(ClearButton);
 
     mEnv->AddWidget(ZoomButton1);
     mEnv->AddWidget(ZoomButton2);
@@ -284,6 +429,8 @@ void Modeler3D::OnUpdate(float64 dt)
 
 	mCamera->SetPosition(Normalize(mCamera->GetPosition()) * mZoom);
 
+    UpdateLoad();
+
     mEnv->SetSize(Window->GetWidth(), Window->GetHeight());
     mEnv->Update(dt);
 }
@@ -293,51 +440,83 @@ void Modeler3D::OnRender()
     Graphics->SetClearColor(0.3, 0.3, 0.3);
     Graphics->Clear();
 
-    if (mVbo) //if vertices are set, render
+    if (mScene->GetCount() > 0)
     {
-    	Camera::Projection proj = mCamera->GetProjectionType();
-    	Matrix4f projection;
-    	if(proj == Camera::Projection::PERSPECTIVE) projection = mCamera->GetProjection(Math::ToRadians(70.0f), Graphics->GetAspectRatio(), 0.05f, 5000.0f);
-    	else projection = mCamera->GetProjection(-6000.0f * mZoom, 6000.0f * mZoom, 10 * Window->GetAspectRatio() * mZoom, -10 * Window->GetAspectRatio() * mZoom, 10 * mZoom, -10 * mZoom);
+        Scene::RenderView view;
+        view.Perspective = mCamera->GetProjectionType() == Camera::Projection::PERSPECTIVE;
+        if (view.Perspective)
+        {
+            view.Projection = mCamera->GetProjection(Math::ToRadians(70.0f), Graphics->GetAspectRatio(), 0.05f, 5000.0f);
+            view.PixelsPerUnit = Window->GetHeight() / (2 * std::tan(Math::ToRadians(70.0f) / 2));
+        }
+        else
+        {
+            view.Projection = mCamera->GetProjection(-6000.0f * mZoom, 6000.0f * mZoom, 10 * Window->GetAspectRatio() * mZoom, -10 * Window->GetAspectRatio() * mZoom, 10 * mZoom, -10 * mZoom);
+            view.PixelsPerUnit = Window->GetHeight() / (20 * mZoom);
+        }
 
-        Matrix4f view = mCamera->GetView();
+        view.View = mCamera->GetView();
+        view.Position = mCamera->GetPosition();
+        view.LodPixelError = LodPixelError;
 
-        Matrix4f model = Matrix4f::Identity * Matrix4f::ToScale(mScale);
-//        Matrix4f model = Matrix4f::ToYaw(mAngle) * Matrix4f::ToPitch(mAngle * 1.3) * Matrix4f::ToRoll(mAngle * 1.7);// * Matrix4f::ToTranslation(Vector3f(0.2, -0.8, 0));
+        mScene->Render(view);
+    }
 
-        Matrix3f normalMat(Inverse(Transpose(model)));
+    mGuiRenderer->Reset();
+    mEnv->Draw(mGuiRenderer);
+    mGuiRenderer->Flush();
+}
 
-        mShader->SetMatrix4f("Projection", projection);
-        mShader->SetMatrix4f("View", view);
-        mShader->SetMatrix4f("Model", model);
-        mShader->SetMatrix3f("NormalMat", normalMat);
-        mShader->SetVector3f("Color", mColor);
+bool Modeler3D::IsReady() const
+{
+    return mLoader->GetState() != ModelLoader::State::Loading;
+}
 
-        Graphics->SetShader(mShader);
-        Graphics->SetGeometry(mGeometry);
+void Modeler3D::SetZoom(float32 zoom)
+{
+    mZoom = zoom;
+    Invalidate();
+}
 
-        Graphics->Draw(Video::Primitive::TriangleList, 0, mVbo->GetLength() / 3);
-    }
+void Modeler3D::SetColor(Math::Vector3f color)
+{
+    mColor = color;
+    if (mScene->IsValid(mSelected)) mScene->SetColor(mSelected, color);
+    Invalidate();
+}
 
-    mGuiRenderer->Reset();
-    mEnv->Draw(mGuiRenderer);
+void Modeler3D::SetScale(Math::Vector3f scale)
+{
+    mScale = scale;
+    mScene->GetTransforms().SetScale(mScene->GetRoot(), scale);
+    Invalidate();
 }
 
-void Modeler3D::SetZoom(float32 zoom) { mZoom = zoom; }
+void Modeler3D::OnLastFrame()
+{
+    if (mScreenshot.empty()) return;
 
-void Modeler3D::SetColor(Math::Vector3f color) { mColor = color; }
+    vector<uint8> pixels;
+    uint width, height;
+    Graphics->ReadPixels(pixels, width, height);
 
-void Modeler3D::SetScale(Math::Vector3f scale) { mScale = scale; }
+    if (lodepng::encode(mScreenshot, pixels, width, height, LCT_RGBA) != 0)
+    {
+        cout << "Error writing image: " << mScreenshot << endl;
+        return;
+    }
+    mScreenshotSaved = true;
+}
 
 void Modeler3D::OnDestroy()
 {
     cout << "Destroying Modeler3D" << endl;
+    mLoader->Cancel();
     mGuiRenderer->Release();
     mShader->Release();
-    mGeometry->SetVertexBuffer(nullptr);
-    mGeometry->Release();
-    if(mVbo)
-    	mVbo->Release();
+    mInstancedShader->Release();
+    delete mScene;
+    mScene = nullptr;
 }
 
 }
@@ -0,0 +1,143 @@
+#include "OGL/OglBuffer.h"
+
+#include <string.h>
+
+namespace Video
+{
+
+/** Regions in a Stream buffer's ring, the GPU can be drawing from all but one of them */
+static const uint64 StreamRegions = 4;
+
+BufferMemoryStats OglBuffer::sMemory = { 0, 0, 0 };
+
+static bool KeepsShadow(BufferHint hint, BufferShadow shadow)
+{
+    if (shadow == BufferShadow::Default) return hint == BufferHint::Dynamic;
+    return shadow == BufferShadow::Keep;
+}
+
+static GLenum GetUsage(BufferHint hint)
+{
+    switch (hint)
+    {
+    case BufferHint::Static: return GL_STATIC_DRAW;
+    case BufferHint::Stream: return GL_STREAM_DRAW;
+    default: return GL_DYNAMIC_DRAW;
+    }
+}
+
+/**
+ * @return true if writes can skip waiting for the GPU, otherwise every Stream region is orphaned
+ */
+static bool CanWriteUnsynchronized()
+{
+    return GLEW_ARB_map_buffer_range;
+}
+
+OglBuffer::OglBuffer(OglState* state, GLenum target, uint64 size, BufferHint hint, BufferShadow shadow)
+    : mState(state),
+      mTarget(target),
+      mSize(size),
+      mHint(hint),
+      mCapacity(hint == BufferHint::Stream && CanWriteUnsynchronized() ? size * StreamRegions : size),
+      mRegionOffset(0),
+      mRegionWritten(false),
+      mShadow(KeepsShadow(hint, shadow) ? size : 0),
+      mId(0)
+{
+    glGenBuffers(1, &mId);
+    Orphan();
+
+    sMemory.BufferCount++;
+    sMemory.GpuBytes += mCapacity;
+    sMemory.ShadowBytes += mShadow.size();
+}
+
+OglBuffer::~OglBuffer()
+{
+    Release();
+}
+
+void OglBuffer::Release()
+{
+    if (mId != 0)
+    {
+        mState->BufferDeleted(mId);
+        glDeleteBuffers(1, &mId);
+        mId = 0;
+
+        sMemory.BufferCount--;
+        sMemory.GpuBytes -= mCapacity;
+        sMemory.ShadowBytes -= mShadow.size();
+
+        // nothing can be drawn or read from a released buffer, the copy goes too
+        std::vector<uint8>().swap(mShadow);
+    }
+}
+
+void OglBuffer::Orphan()
+{
+    glBindBuffer(mTarget, mId);
+    glBufferData(mTarget, mCapacity, NULL, GetUsage(mHint));
+    glBindBuffer(mTarget, 0);
+}
+
+void OglBuffer::Read(uint64 offset, void* out, uint64 size) const
+{
+    if (!mShadow.empty())
+    {
+        memcpy(out, &mShadow[offset], size);
+        return;
+    }
+
+    glBindBuffer(mTarget, mId);
+    glGetBufferSubData(mTarget, mRegionOffset + offset, size, out);
+    glBindBuffer(mTarget, 0);
+}
+
+void OglBuffer::Write(uint64 offset, const void* in, uint64 size)
+{
+    if (size == 0) return;
+
+    if (!mShadow.empty()) memcpy(&mShadow[offset], in, size);
+
+    if (mHint == BufferHint::Stream && offset == 0)
+    {
+        // move on to a region the GPU isn't reading, or start over in a fresh buffer object
+        if (mRegionWritten) mRegionOffset += mSize;
+
+        if (mRegionOffset + mSize > mCapacity || (mRegionWritten && !CanWriteUnsynchronized()))
+        {
+            Orphan();
+            mRegionOffset = 0;
+        }
+
+        mRegionWritten = true;
+    }
+
+    glBindBuffer(mTarget, mId);
+
+    if (mHint == BufferHint::Stream && CanWriteUnsynchronized())
+    {
+        void* data = glMapBufferRange(mTarget, mRegionOffset + offset, size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+        if (data)
+        {
+            memcpy(data, in, size);
+            glUnmapBuffer(mTarget);
+        }
+        else
+        {
+            glBufferSubData(mTarget, mRegionOffset + offset, size, in);
+        }
+    }
+    else
+    {
+        glBufferSubData(mTarget, mRegionOffset + offset, size, in);
+    }
+
+    glBindBuffer(mTarget, 0);
+}
+
+}
@@ -1,22 +1,26 @@
 #include "OGL/OglGraphicsDevice.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 #include <GL/glew.h>
 #include <GL/glu.h>
-#include <SDL2/Sdl2Window.h>
 
 #include "lodepng.h"
 
+#include "IWindow.h"
+#include "Profiler.h"
+
 #include "Math/ModelerMath.h"
 #include "Math/Matrix4.h"
 
+#include "OGL/OglBuffer.h"
 #include "OGL/OglGeometry.h"
 #include "OGL/OglIndexBuffer.h"
+#include "OGL/OglState.h"
 #include "OGL/OglTexture2D.h"
 #include "OGL/OglVertexBuffer.h"
 
@@ -24,34 +28,34 @@ using namespace std;
 using namespace Core;
 using namespace Core::Math;
 
-/*
- * TODO
- *
- * This is incredibly inefficient because I just needed to
- * get it to work, I will make this better later.
+namespace Video
+{
+
+/**
+ * @return true if the context can draw instances, from GL 3.3 or the ARB_draw_instanced and
+ *         ARB_instanced_arrays extensions older drivers have
  */
+static bool CanDrawInstanced()
+{
+    return (GLEW_VERSION_3_3 || GLEW_ARB_instanced_arrays) && (GLEW_VERSION_3_1 || GLEW_ARB_draw_instanced);
+}
 
-namespace Video
+static void DrawArraysInstanced(GLint first, GLsizei count, GLsizei instanceCount)
 {
+    if (GLEW_VERSION_3_1) glDrawArraysInstanced(GL_TRIANGLES, first, count, instanceCount);
+    else glDrawArraysInstancedARB(GL_TRIANGLES, first, count, instanceCount);
+}
 
-static std::string AttributeName(Attribute attrib)
+static void DrawElementsInstanced(GLsizei count, GLenum type, uintptr_t offset, GLsizei instanceCount)
 {
-    switch (attrib)
-    {
-    case Attribute::Position: return "aPosition";
-    case Attribute::Normal: return "aNormal";
-    case Attribute::Color: return "aColor";
-    case Attribute::TexCoord0: return "aTexCoord0";
-    case Attribute::TexCoord1: return "aTexCoord1";
-    case Attribute::TexCoord2: return "aTexCoord2";
-    case Attribute::TexCoord3: return "aTexCoord3";
-    default: return "[null]";
-    }
+    if (GLEW_VERSION_3_1) glDrawElementsInstanced(GL_TRIANGLES, count, type, reinterpret_cast<void*>(offset), instanceCount);
+    else glDrawElementsInstancedARB(GL_TRIANGLES, count, type, reinterpret_cast<void*>(offset), instanceCount);
 }
 
-OglGraphicsDevice::OglGraphicsDevice(Sdl2Window* window)
+OglGraphicsDevice::OglGraphicsDevice(IWindow* window)
     : mWindow(window),
-      mTextures(16)
+      mState(),
+      mTextures(OglState::TextureUnitCount)
 {
 }
 
@@ -72,16 +76,21 @@ void OglGraphicsDevice::SetClearColor(float32 r, float32 g, float32 b, float32 a
     glClearColor(r, g, b, a);
 }
 
-IVertexBuffer* OglGraphicsDevice::CreateVertexBuffer(VertexFormat format, uint count, BufferHint hint)
+IVertexBuffer* OglGraphicsDevice::CreateVertexBuffer(VertexFormat format, uint count, BufferHint hint,
+        BufferShadow shadow)
 {
-    OglVertexBuffer* vbo = new OglVertexBuffer(format, count); //, hint);
-    return vbo;
+    return new OglVertexBuffer(&mState, format, count, hint, shadow);
 }
 
-IIndexBuffer* OglGraphicsDevice::CreateIndexBuffer(uint count, BufferHint hint)
+IIndexBuffer* OglGraphicsDevice::CreateIndexBuffer(uint count, BufferHint hint, IndexFormat format,
+        BufferShadow shadow)
 {
-    OglIndexBuffer* ibo = new OglIndexBuffer(count); //, hint);
-    return ibo;
+    return new OglIndexBuffer(&mState, count, format, hint, shadow);
+}
+
+BufferMemoryStats OglGraphicsDevice::GetBufferMemory() const
+{
+    return OglBuffer::GetMemoryStats();
 }
 
 IGeometry* OglGraphicsDevice::CreateGeometry()
@@ -99,6 +108,23 @@ void OglGraphicsDevice::Clear(bool color, bool depth)
     if (flags) glClear(flags);
 }
 
+void OglGraphicsDevice::ReadPixels(vector<uint8>& refPixels, uint& refWidth, uint& refHeight)
+{
+    refWidth = mWindow->GetWidth();
+    refHeight = mWindow->GetHeight();
+    refPixels.resize(refWidth * refHeight * 4);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, refWidth, refHeight, GL_RGBA, GL_UNSIGNED_BYTE, &refPixels[0]);
+
+    // GL reads the bottom row first
+    for (uint y = 0; y < refHeight / 2; y++)
+    {
+        swap_ranges(refPixels.begin() + y * refWidth * 4, refPixels.begin() + (y + 1) * refWidth * 4,
+                refPixels.begin() + (refHeight - y - 1) * refWidth * 4);
+    }
+}
+
 void OglGraphicsDevice::SetGeometry(IGeometry* geom)
 {
     mGeometry = dynamic_cast<OglGeometry*>(geom);
@@ -107,7 +133,7 @@ void OglGraphicsDevice::SetGeometry(IGeometry* geom)
 IShader* OglGraphicsDevice::CreateShader(const std::string& vertex,
         const std::string& fragment)
 {
-    return new OglShader(vertex, fragment);
+    return new OglShader(&mState, vertex, fragment);
 }
 
 void OglGraphicsDevice::SetShader(IShader* shader)
@@ -115,26 +141,27 @@ void OglGraphicsDevice::SetShader(IShader* shader)
     mShader = dynamic_cast<OglShader*>(shader);
 }
 
-float Angle = 0.0;
-
-void OglGraphicsDevice::Draw(Primitive prim, uint start, uint primCount)
+bool OglGraphicsDevice::BindState(uint firstInstance, uint instanceCount)
 {
-    if (mGeometry == nullptr) return;
-    if (mShader == nullptr) return;
-
-    // bind current shader
-    glUseProgram(mShader->GetId());
+    if (mGeometry == nullptr) return false;
+    if (mShader == nullptr) return false;
 
-    Angle += Math::ToRadians(0.3);
+    mState.UseProgram(mShader->GetId());
+    mShader->ApplyUniforms();
 
-    for (uint i = 0; i < 16; i++)
+    for (uint i = 0; i < OglState::TextureUnitCount; i++)
     {
-        glActiveTexture(GL_TEXTURE0 + i);
         OglTexture2D* tex = mTextures[i];
-        glBindTexture(GL_TEXTURE_2D, tex == nullptr ? 0 : tex->GetId());
+        mState.BindTexture(i, tex == nullptr ? 0 : tex->GetId());
     }
 
-    unordered_set<int> usedAttribs;
+    // an attribute in more than one vertex buffer is read from the first
+    uint32 usedAttribs = 0;
+    uint32 usedLocations = 0;
+    uint32 instancedLocations = 0;
+    const bool instancing = CanDrawInstanced();
+    mInstanceAttributes.clear();
+    mInstanceData.clear();
 
     for (uint i = 0; i < mGeometry->GetVertexBufferCount(); i++)
     {
@@ -142,38 +169,69 @@ void OglGraphicsDevice::Draw(Primitive prim, uint start, uint primCount)
 
         if (vbo)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, vbo->GetId());
-
             const VertexFormat& format = vbo->GetFormat();
+            const bool instanced = format.IsInstanced();
+            uintptr_t offset = vbo->GetBindOffset();
+            if (instanced) offset += (uintptr_t)firstInstance * format.GetSizeInBytes();
+
+            // without instancing every instance of the draw is read in one go, not one GetData between draws
+            uint dataStart = mInstanceData.size();
+            if (instanced && !instancing)
+            {
+                if ((uint64)firstInstance + instanceCount > vbo->GetLength()) return false;
+
+                mInstanceData.resize(dataStart + instanceCount * format.GetSizeInFloats());
+                vbo->GetData(&mInstanceData[dataStart], firstInstance, instanceCount);
+            }
 
             for (uint j = 0; j < format.GetElementCount(); j++)
             {
                 const VertexElement& elem = format.GetElement(j);
+                uint32 attribBit = 1u << static_cast<uint>(elem.Attrib);
+                GLint location = mShader->GetAttributeLocation(elem.Attrib);
 
-                int attribId = static_cast<int>(elem.Attrib);
-
-                if (usedAttribs.find(attribId) == usedAttribs.end())
+                if (!(usedAttribs & attribBit) && location >= 0 && instanced && !instancing)
                 {
-                    usedAttribs.insert(attribId);
-                    string name = AttributeName(elem.Attrib);
-//                    cout << "Found " << name << ": " << elem.Count << ", " << format.GetOffsetOf(j) << ", " << format.GetSizeInBytes() << ", " << glGetAttribLocation(mShader->GetId(), name.c_str()) << endl;
-
-                    glVertexAttribPointer(
-                            glGetAttribLocation(mShader->GetId(), name.c_str()),
-                            elem.Count,
-                            GL_FLOAT,
-                            GL_FALSE,
-                            format.GetSizeInBytes(),
-                            reinterpret_cast<void*>(format.GetOffsetOf(j))
-                    );
-                    GLint location = glGetAttribLocation(mShader->GetId(), name.c_str());
-//                    cout << location << " ";
-                    glEnableVertexAttribArray(location);
+                    InstanceAttribute attribute = { location, dataStart + format.GetOffsetOf(j) / 4, format.GetSizeInFloats(),
+                            elem.Count };
+                    mInstanceAttributes.push_back(attribute);
                 }
+                else if (!(usedAttribs & attribBit) && location >= 0)
+                {
+                    mState.SetAttributePointer(location, vbo->GetId(), elem.Count, format.GetSizeInBytes(), offset);
+                    usedLocations |= 1u << location;
+                    if (instanced) instancedLocations |= 1u << location;
+                }
+
+                usedAttribs |= attribBit;
+                offset += elem.GetSizeInBytes();
             }
         }
     }
-//    cout << endl;
+
+    mState.SetAttributeArrays(usedLocations);
+    if (instancing) mState.SetAttributeDivisors(instancedLocations);
+    if (!mInstanceAttributes.empty()) SetInstanceAttributes(0);
+    return true;
+}
+
+void OglGraphicsDevice::SetInstanceAttributes(uint instance)
+{
+    for (const InstanceAttribute& attribute : mInstanceAttributes)
+    {
+        // components the buffer doesn't have are 0, 0, 0, 1 like they are for arrays
+        float32 value[4] = { 0, 0, 0, 1 };
+        const float32* data = &mInstanceData[attribute.Offset + instance * attribute.Stride];
+        copy(data, data + min(attribute.Count, 4u), value);
+        glVertexAttrib4fv(attribute.Location, value);
+    }
+}
+
+void OglGraphicsDevice::Draw(Primitive prim, uint start, uint primCount)
+{
+    PROFILE_ZONE("OglGraphicsDevice::Draw");
+
+    if (!BindState()) return;
 
     glDrawArrays(GL_TRIANGLES, start, primCount * 3);
 }
@@ -207,7 +265,7 @@ ITexture2D* OglGraphicsDevice::CreateTexture2D(const std::string& filename)
     }
     else
     {
-        OglTexture2D* tex = new OglTexture2D(width, height);
+        OglTexture2D* tex = new OglTexture2D(&mState, width, height);
 
         for (uint y = 0; y < height / 2; y++)
         {
@@ -229,66 +287,71 @@ ITexture2D* OglGraphicsDevice::CreateTexture2D(const std::string& filename)
     }
 }
 
+ITexture2D* OglGraphicsDevice::CreateTexture2D(uint width, uint height)
+{
+    return new OglTexture2D(&mState, width, height);
+}
+
 void OglGraphicsDevice::DrawIndices(Primitive prim, uint start, uint primCount)
 {
-    if (mGeometry == nullptr) return;
-    if (mShader == nullptr) return;
+    PROFILE_ZONE("OglGraphicsDevice::DrawIndices");
 
-    // bind current shader
-    glUseProgram(mShader->GetId());
+    if (!BindState()) return;
 
-    for (uint i = 0; i < 16; i++)
+    OglIndexBuffer* ibo = dynamic_cast<OglIndexBuffer*>(mGeometry->GetIndexBuffer());
+
+    if (ibo)
     {
-        glActiveTexture(GL_TEXTURE0 + i);
-        OglTexture2D* tex = mTextures[i];
-        glBindTexture(GL_TEXTURE_2D, tex == nullptr ? 0 : tex->GetId());
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo->GetId());
+        GLenum type = ibo->GetFormat() == IndexFormat::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        uintptr_t offset = ibo->GetBindOffset() + start * ibo->GetBytesPerIndex();
+        glDrawElements(GL_TRIANGLES, primCount * 3, type, reinterpret_cast<void*>(offset));
     }
+}
 
-    unordered_set<int> usedAttribs;
+void OglGraphicsDevice::DrawInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount)
+{
+    PROFILE_ZONE("OglGraphicsDevice::DrawInstanced");
 
-    for (uint i = 0; i < mGeometry->GetVertexBufferCount(); i++)
+    if (instanceCount == 0 || !BindState(instanceStart, instanceCount)) return;
+
+    if (CanDrawInstanced())
     {
-        OglVertexBuffer* vbo = dynamic_cast<OglVertexBuffer*>(mGeometry->GetVertexBuffer(i));
+        DrawArraysInstanced(start, primCount * 3, instanceCount);
+        return;
+    }
 
-        if (vbo)
-        {
-            glBindBuffer(GL_ARRAY_BUFFER, vbo->GetId());
+    // one draw per instance, BindState already set the first instance's attributes
+    for (uint i = 0; i < instanceCount; i++)
+    {
+        if (i > 0) SetInstanceAttributes(i);
+        glDrawArrays(GL_TRIANGLES, start, primCount * 3);
+    }
+}
 
-            const VertexFormat& format = vbo->GetFormat();
+void OglGraphicsDevice::DrawIndicesInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount)
+{
+    PROFILE_ZONE("OglGraphicsDevice::DrawIndicesInstanced");
 
-            for (uint j = 0; j < format.GetElementCount(); j++)
-            {
-                const VertexElement& elem = format.GetElement(j);
+    if (instanceCount == 0 || !BindState(instanceStart, instanceCount)) return;
 
-                int attribId = static_cast<int>(elem.Attrib);
+    OglIndexBuffer* ibo = dynamic_cast<OglIndexBuffer*>(mGeometry->GetIndexBuffer());
+    if (!ibo) return;
 
-                if (usedAttribs.find(attribId) == usedAttribs.end())
-                {
-                    usedAttribs.insert(attribId);
-                    string name = AttributeName(elem.Attrib);
-//                    cout << "Found " << name << ": " << elem.Count << ", " << format.GetOffsetOf(j) << ", " << format.GetSizeInBytes() << ", " << glGetAttribLocation(mShader->GetId(), name.c_str()) << endl;
-
-                    glVertexAttribPointer(
-                            glGetAttribLocation(mShader->GetId(), name.c_str()),
-                            elem.Count,
-                            GL_FLOAT,
-                            GL_FALSE,
-                            format.GetSizeInBytes(),
-                            reinterpret_cast<void*>(format.GetOffsetOf(j))
-                    );
-                    GLint location = glGetAttribLocation(mShader->GetId(), name.c_str());
-                    glEnableVertexAttribArray(location);
-                }
-            }
-        }
-    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo->GetId());
+    GLenum type = ibo->GetFormat() == IndexFormat::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    uintptr_t offset = ibo->GetBindOffset() + start * ibo->GetBytesPerIndex();
 
-    OglIndexBuffer* ibo = dynamic_cast<OglIndexBuffer*>(mGeometry->GetIndexBuffer());
+    if (CanDrawInstanced())
+    {
+        DrawElementsInstanced(primCount * 3, type, offset, instanceCount);
+        return;
+    }
 
-    if (ibo)
+    for (uint i = 0; i < instanceCount; i++)
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo->GetId());
-        glDrawElements(GL_TRIANGLES, primCount * 3, GL_UNSIGNED_INT, reinterpret_cast<void*>(start));
+        if (i > 0) SetInstanceAttributes(i);
+        glDrawElements(GL_TRIANGLES, primCount * 3, type, reinterpret_cast<void*>(offset));
     }
 }
 
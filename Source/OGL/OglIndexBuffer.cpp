@@ -1,19 +1,17 @@
 #include "OGL/OglIndexBuffer.h"
 
-#include <string.h>
+#include <vector>
+
+using namespace std;
 
 namespace Video
 {
 
-OglIndexBuffer::OglIndexBuffer(uint length)
+OglIndexBuffer::OglIndexBuffer(OglState* state, uint length, IndexFormat format, BufferHint hint, BufferShadow shadow)
     : mLength(length),
-      mIndices(length),
-      mId(0)
+      mFormat(format),
+      mBuffer(state, GL_ELEMENT_ARRAY_BUFFER, (uint64)length * GetBytesPerIndex(), hint, shadow)
 {
-    glGenBuffers(1, &mId);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mId);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, length * 4, NULL, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 OglIndexBuffer::~OglIndexBuffer()
@@ -23,25 +21,35 @@ OglIndexBuffer::~OglIndexBuffer()
 
 void OglIndexBuffer::Release()
 {
-    if (mId != 0)
-    {
-        glDeleteBuffers(1, &mId);
-        mId = 0;
-    }
+    mBuffer.Release();
 }
 
 void OglIndexBuffer::GetData(uint32* out, uint start, uint count) const
 {
-    memcpy(out, &mIndices[start], count * 4);
+    if (mFormat == IndexFormat::UInt16)
+    {
+        vector<uint16> indices(count);
+        mBuffer.Read((uint64)start * 2, indices.data(), (uint64)count * 2);
+        for (uint i = 0; i < count; i++) out[i] = indices[i];
+    }
+    else
+    {
+        mBuffer.Read((uint64)start * 4, out, (uint64)count * 4);
+    }
 }
 
 void OglIndexBuffer::SetData(const uint32* in, uint start, uint count)
 {
-    memcpy(&mIndices[start], in, count * 4);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mId);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, start * 4, count * 4, &mIndices[start]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    if (mFormat == IndexFormat::UInt16)
+    {
+        vector<uint16> indices(count);
+        for (uint i = 0; i < count; i++) indices[i] = static_cast<uint16>(in[i]);
+        mBuffer.Write((uint64)start * 2, indices.data(), (uint64)count * 2);
+    }
+    else
+    {
+        mBuffer.Write((uint64)start * 4, in, (uint64)count * 4);
+    }
 }
 
 }
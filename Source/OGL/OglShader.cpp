@@ -1,21 +1,79 @@
 #include "OGL/OglShader.h"
 
+#include <algorithm>
 #include <iostream>
+#include <string.h>
 #include <vector>
 
+#include "OGL/OglState.h"
+
 using namespace std;
 using namespace Core::Math;
 
 namespace Video
 {
 
-OglShader::OglShader(const string& vs, const string& fs)
-    : mVertexSource(vs),
+/**
+ * @return number of floats or ints in a uniform of a type that can be set, 0 for other types
+ */
+static uint UniformSize(GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT: return 1;
+    case GL_FLOAT_VEC2: return 2;
+    case GL_FLOAT_VEC3: return 3;
+    case GL_FLOAT_VEC4: return 4;
+    case GL_FLOAT_MAT3: return 9;
+    case GL_FLOAT_MAT4: return 16;
+    case GL_INT:
+    case GL_BOOL:
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE: return 1;
+    default: return 0;
+    }
+}
+
+static bool IsFloatType(GLenum type)
+{
+    return type == GL_FLOAT || type == GL_FLOAT_VEC2 || type == GL_FLOAT_VEC3 || type == GL_FLOAT_VEC4
+            || type == GL_FLOAT_MAT3 || type == GL_FLOAT_MAT4;
+}
+
+static const char* AttributeName(Attribute attrib)
+{
+    switch (attrib)
+    {
+    case Attribute::Position: return "aPosition";
+    case Attribute::Normal: return "aNormal";
+    case Attribute::Color: return "aColor";
+    case Attribute::TexCoord0: return "aTexCoord0";
+    case Attribute::TexCoord1: return "aTexCoord1";
+    case Attribute::TexCoord2: return "aTexCoord2";
+    case Attribute::TexCoord3: return "aTexCoord3";
+    case Attribute::Model0: return "aModel0";
+    case Attribute::Model1: return "aModel1";
+    case Attribute::Model2: return "aModel2";
+    case Attribute::Model3: return "aModel3";
+    case Attribute::NormalMat0: return "aNormalMat0";
+    case Attribute::NormalMat1: return "aNormalMat1";
+    case Attribute::NormalMat2: return "aNormalMat2";
+    default: return "[null]";
+    }
+}
+
+OglShader::OglShader(OglState* state, const string& vs, const string& fs)
+    : mState(state),
+      mVertexSource(vs),
       mFragmentSource(fs)
 {
 //    cout << "Vertex: " << vs << endl;
 //    cout << "Fragment: " << fs << endl;
 
+    fill(mAttributeLocations, mAttributeLocations + AttributeCount, -1);
+
     mId = glCreateProgram();
 
     GLuint vert = 0, frag = 0;
@@ -27,7 +85,11 @@ OglShader::OglShader(const string& vs, const string& fs)
     {
         cout << "Shader creation failed" << endl;
         Release();
+        return;
     }
+
+    FindAttributeLocations();
+    FindUniforms();
 }
 
 OglShader::~OglShader()
@@ -39,6 +101,7 @@ void OglShader::Release()
 {
     if (mId != 0)
     {
+        mState->ProgramDeleted(mId);
         glDeleteProgram(mId);
         mId = 0;
     }
@@ -71,46 +134,92 @@ GLuint OglShader::CompileShader(const std::string& source, GLenum type,
     return id;
 }
 
-void OglShader::SetMatrix4f(const std::string& name, const Matrix4f& mat)
+UniformHandle OglShader::GetUniform(const string& name) const
 {
-    glUseProgram(mId);
-    glUniformMatrix4fv(glGetUniformLocation(mId, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    auto it = mUniformIndices.find(name);
+    return it == mUniformIndices.end() ? UniformHandle() : UniformHandle(it->second);
 }
 
-void OglShader::SetMatrix3f(const std::string& name, const Matrix3f& mat)
+void OglShader::SetMatrix4f(UniformHandle uniform, const Matrix4f& mat)
 {
-    glUseProgram(mId);
-    glUniformMatrix3fv(glGetUniformLocation(mId, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    SetUniform(uniform, GL_FLOAT_MAT4, &mat[0][0]);
 }
 
-void OglShader::SetVector4f(const std::string& name, const Vector4f& vec)
+void OglShader::SetMatrix3f(UniformHandle uniform, const Matrix3f& mat)
 {
-    glUseProgram(mId);
-    glUniform4fv(glGetUniformLocation(mId, name.c_str()), 1, &vec[0]);
+    SetUniform(uniform, GL_FLOAT_MAT3, &mat[0][0]);
 }
 
-void OglShader::SetVector3f(const std::string& name, const Vector3f& vec)
+void OglShader::SetVector4f(UniformHandle uniform, const Vector4f& vec)
 {
-    glUseProgram(mId);
-    glUniform3fv(glGetUniformLocation(mId, name.c_str()), 1, &vec[0]);
+    SetUniform(uniform, GL_FLOAT_VEC4, &vec[0]);
 }
 
-void OglShader::SetVector2f(const std::string& name, const Vector2f& vec)
+void OglShader::SetVector3f(UniformHandle uniform, const Vector3f& vec)
 {
-    glUseProgram(mId);
-    glUniform2fv(glGetUniformLocation(mId, name.c_str()), 1, &vec[0]);
+    SetUniform(uniform, GL_FLOAT_VEC3, &vec[0]);
 }
 
-void OglShader::SetFloat32(const std::string& name, float32 f)
+void OglShader::SetVector2f(UniformHandle uniform, const Vector2f& vec)
 {
-    glUseProgram(mId);
-    glUniform1f(glGetUniformLocation(mId, name.c_str()), f);
+    SetUniform(uniform, GL_FLOAT_VEC2, &vec[0]);
+}
+
+void OglShader::SetFloat32(UniformHandle uniform, float32 f)
+{
+    SetUniform(uniform, GL_FLOAT, &f);
+}
+
+void OglShader::SetInt32(UniformHandle uniform, int32 i)
+{
+    SetUniform(uniform, GL_INT, &i);
+}
+
+void OglShader::SetUniform(UniformHandle uniform, GLenum type, const void* value)
+{
+    if (!uniform.IsValid() || uniform.Index >= (int32)mUniforms.size()) return;
+
+    Uniform& u = mUniforms[uniform.Index];
+
+    // GL only lets ints set booleans and samplers, and only the exact type set anything else
+    bool matches = u.Type == type || (type == GL_INT && UniformSize(u.Type) == 1 && !IsFloatType(u.Type));
+    if (!matches) return;
+
+    uint32* staged = &mUniformValues[u.Offset];
+    if (memcmp(staged, value, u.Size * 4) == 0) return;
+
+    memcpy(staged, value, u.Size * 4);
+
+    if (!u.Dirty)
+    {
+        u.Dirty = true;
+        mDirtyUniforms.push_back(uniform.Index);
+    }
 }
 
-void OglShader::SetInt32(const std::string& name, int32 i)
+void OglShader::ApplyUniforms()
 {
-    glUseProgram(mId);
-    glUniform1i(glGetUniformLocation(mId, name.c_str()), i);
+    for (int32 index : mDirtyUniforms)
+    {
+        Uniform& u = mUniforms[index];
+        const GLfloat* f = reinterpret_cast<const GLfloat*>(&mUniformValues[u.Offset]);
+        const GLint* i = reinterpret_cast<const GLint*>(&mUniformValues[u.Offset]);
+
+        switch (u.Type)
+        {
+        case GL_FLOAT: glUniform1fv(u.Location, 1, f); break;
+        case GL_FLOAT_VEC2: glUniform2fv(u.Location, 1, f); break;
+        case GL_FLOAT_VEC3: glUniform3fv(u.Location, 1, f); break;
+        case GL_FLOAT_VEC4: glUniform4fv(u.Location, 1, f); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(u.Location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(u.Location, 1, GL_FALSE, f); break;
+        default: glUniform1iv(u.Location, 1, i); break;
+        }
+
+        u.Dirty = false;
+    }
+
+    mDirtyUniforms.clear();
 }
 
 bool OglShader::LinkProgram(GLuint vertex, GLuint fragment)
@@ -141,4 +250,49 @@ bool OglShader::LinkProgram(GLuint vertex, GLuint fragment)
     return true;
 }
 
+void OglShader::FindAttributeLocations()
+{
+    for (uint i = 0; i < AttributeCount; i++)
+    {
+        mAttributeLocations[i] = glGetAttribLocation(mId, AttributeName(static_cast<Attribute>(i)));
+    }
+}
+
+void OglShader::FindUniforms()
+{
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(mId, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(mId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    vector<GLchar> name(maxLength + 1);
+
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint arraySize = 0;
+        GLenum type = 0;
+        glGetActiveUniform(mId, i, name.size(), &length, &arraySize, &type, &name[0]);
+
+        uint size = UniformSize(type);
+        if (size == 0) continue;
+
+        // arrays are reported as name[0], only their first element can be set
+        string uniformName(&name[0], length);
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+        {
+            uniformName.resize(uniformName.size() - 3);
+        }
+
+        GLint location = glGetUniformLocation(mId, uniformName.c_str());
+        if (location < 0) continue;
+
+        Uniform uniform = { location, type, (uint)mUniformValues.size(), size, false };
+        mUniformIndices[uniformName] = mUniforms.size();
+        mUniforms.push_back(uniform);
+
+        // GL starts every uniform at 0
+        mUniformValues.resize(mUniformValues.size() + size, 0);
+    }
+}
+
 }
@@ -0,0 +1,126 @@
+#include "OGL/OglState.h"
+
+namespace Video
+{
+
+const uint OglState::TextureUnitCount;
+const uint OglState::AttributeLocationCount;
+
+OglState::OglState()
+    : mProgram(0),
+      mActiveUnit(0),
+      mTextures(),
+      mAttributePointers(),
+      mAttributeArrays(0),
+      mAttributeDivisors(0)
+{
+}
+
+void OglState::UseProgram(GLuint program)
+{
+    if (program == mProgram) return;
+
+    glUseProgram(program);
+    mProgram = program;
+}
+
+void OglState::ProgramDeleted(GLuint program)
+{
+    if (program == mProgram)
+    {
+        glUseProgram(0);
+        mProgram = 0;
+    }
+}
+
+void OglState::BindTexture(uint unit, GLuint texture)
+{
+    if (mTextures[unit] == texture) return;
+
+    if (mActiveUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        mActiveUnit = unit;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    mTextures[unit] = texture;
+}
+
+void OglState::BindTextureForEdit(GLuint texture)
+{
+    BindTexture(mActiveUnit, texture);
+}
+
+void OglState::TextureDeleted(GLuint texture)
+{
+    for (uint i = 0; i < TextureUnitCount; i++)
+    {
+        if (mTextures[i] == texture) mTextures[i] = 0;
+    }
+}
+
+void OglState::SetAttributePointer(GLuint location, GLuint buffer, GLint count, GLsizei stride, uintptr_t offset)
+{
+    AttributePointer& pointer = mAttributePointers[location];
+    if (pointer.Buffer == buffer && pointer.Count == count && pointer.Stride == stride && pointer.Offset == offset)
+    {
+        return;
+    }
+
+    // buffers bind and unbind GL_ARRAY_BUFFER on their own, so it isn't remembered
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(location, count, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset));
+
+    pointer.Buffer = buffer;
+    pointer.Count = count;
+    pointer.Stride = stride;
+    pointer.Offset = offset;
+}
+
+void OglState::BufferDeleted(GLuint buffer)
+{
+    for (uint i = 0; i < AttributeLocationCount; i++)
+    {
+        if (mAttributePointers[i].Buffer == buffer) mAttributePointers[i].Buffer = 0;
+    }
+}
+
+void OglState::SetAttributeArrays(uint32 mask)
+{
+    uint32 changed = mask ^ mAttributeArrays;
+
+    for (uint i = 0; changed != 0; i++, changed >>= 1)
+    {
+        if (!(changed & 1)) continue;
+
+        if (mask & (1u << i))
+        {
+            glEnableVertexAttribArray(i);
+        }
+        else
+        {
+            glDisableVertexAttribArray(i);
+        }
+    }
+
+    mAttributeArrays = mask;
+}
+
+void OglState::SetAttributeDivisors(uint32 mask)
+{
+    uint32 changed = mask ^ mAttributeDivisors;
+
+    for (uint i = 0; changed != 0; i++, changed >>= 1)
+    {
+        if (!(changed & 1)) continue;
+
+        // contexts older than 3.3 only have the ARB_instanced_arrays version
+        if (GLEW_VERSION_3_3) glVertexAttribDivisor(i, (mask >> i) & 1);
+        else glVertexAttribDivisorARB(i, (mask >> i) & 1);
+    }
+
+    mAttributeDivisors = mask;
+}
+
+}
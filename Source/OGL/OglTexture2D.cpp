@@ -1,18 +1,21 @@
 #include "OGL/OglTexture2D.h"
 
+#include "OGL/OglState.h"
+
 #include <iostream>
 using namespace std;
 
 namespace Video
 {
 
-OglTexture2D::OglTexture2D(uint width, uint height)
-    : mId(0),
+OglTexture2D::OglTexture2D(OglState* state, uint width, uint height)
+    : mState(state),
+      mId(0),
       mWidth(width),
       mHeight(height)
 {
     glGenTextures(1, &mId);
-    glBindTexture(GL_TEXTURE_2D, mId);
+    mState->BindTextureForEdit(mId);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -35,6 +38,7 @@ void OglTexture2D::Release()
 {
     if (mId)
     {
+        mState->TextureDeleted(mId);
         glDeleteTextures(1, &mId);
         mId = 0;
     }
@@ -59,7 +63,7 @@ void OglTexture2D::GetData(uint8* out, uint x, uint y, uint w, uint h) const
 
 void OglTexture2D::SetData(const uint8* in, uint x, uint y, uint w, uint h)
 {
-    glBindTexture(GL_TEXTURE_2D, mId);
+    mState->BindTextureForEdit(mId);
     glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, (const void*) in);
 }
 
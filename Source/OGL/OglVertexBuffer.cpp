@@ -1,23 +1,16 @@
 #include "OGL/OglVertexBuffer.h"
 
-#include <string.h>
-
 #include "IVertexBuffer.h"
 #include "Types.h"
 
 namespace Video
 {
 
-OglVertexBuffer::OglVertexBuffer(VertexFormat format, uint length)
+OglVertexBuffer::OglVertexBuffer(OglState* state, VertexFormat format, uint length, BufferHint hint, BufferShadow shadow)
     : mFormat(format),
       mLength(length),
-      mData(length * format.GetSizeInBytes()),
-      mId(0)
+      mBuffer(state, GL_ARRAY_BUFFER, (uint64)length * format.GetSizeInBytes(), hint, shadow)
 {
-    glGenBuffers(1, &mId);
-    glBindBuffer(GL_ARRAY_BUFFER, mId);
-    glBufferData(GL_ARRAY_BUFFER, length * GetSizeInBytes(), NULL, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 OglVertexBuffer::~OglVertexBuffer()
@@ -27,29 +20,21 @@ OglVertexBuffer::~OglVertexBuffer()
 
 void OglVertexBuffer::Release()
 {
-    if (mId != 0)
-    {
-        glDeleteBuffers(1, &mId);
-    }
-    mId = 0;
+    mBuffer.Release();
 }
 
 void OglVertexBuffer::GetData(float32* out, uint start, uint count) const
 {
-    uint index = start * mFormat.GetSizeInBytes();
-    uint size = count * mFormat.GetSizeInBytes();
-    memcpy(out, &mData[index], size);
+    uint64 index = (uint64)start * mFormat.GetSizeInBytes();
+    uint64 size = (uint64)count * mFormat.GetSizeInBytes();
+    mBuffer.Read(index, out, size);
 }
 
 void OglVertexBuffer::SetData(const float32* in, uint start, uint count)
 {
-    uint index = start * mFormat.GetSizeInBytes();
-    uint size = count * mFormat.GetSizeInBytes();
-
-    memcpy(&mData[index], in, size);
-    glBindBuffer(GL_ARRAY_BUFFER, mId);
-    glBufferSubData(GL_ARRAY_BUFFER, index, size, &mData[index]);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uint64 index = (uint64)start * mFormat.GetSizeInBytes();
+    uint64 size = (uint64)count * mFormat.GetSizeInBytes();
+    mBuffer.Write(index, in, size);
 }
 
 }
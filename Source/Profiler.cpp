@@ -0,0 +1,247 @@
+#include "Profiler.h"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TimeUtil.h"
+#include "Types.h"
+
+using namespace std;
+
+namespace Core
+{
+
+namespace Profiler
+{
+
+/** Events per chunk of a thread's buffer */
+static const uint64 ChunkSize = 4096;
+
+/** Chunks per thread, events past them are dropped */
+static const uint64 MaxChunks = 256;
+
+struct Event
+{
+    const char* Name;
+    uint64 Start;
+    /** Nanoseconds for zones */
+    uint64 Duration;
+    /** Value for counters */
+    float64 Value;
+    bool IsCounter;
+};
+
+/**
+ * Events of one thread. Chunks are never moved once allocated, so Export can read the events
+ * below Count while the thread keeps adding to the end.
+ */
+struct ThreadBuffer
+{
+    uint32 Id;
+    /** Guarded by the registry's mutex */
+    string Name;
+    atomic<uint64> Count;
+    atomic<Event*> Chunks[MaxChunks];
+};
+
+/**
+ * Every thread's buffer, kept until the program ends because threads can record until then
+ */
+struct Registry
+{
+    mutex Mutex;
+    vector<unique_ptr<ThreadBuffer>> Buffers;
+};
+
+static atomic<bool> sRecording(false);
+
+static thread_local ThreadBuffer* sBuffer = nullptr;
+
+static Registry& GetRegistry()
+{
+    //never deleted, threads that outlive static destruction still use it
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+static ThreadBuffer& GetBuffer()
+{
+    if (sBuffer) return *sBuffer;
+
+    Registry& registry = GetRegistry();
+    lock_guard<mutex> lock(registry.Mutex);
+
+    ThreadBuffer* buffer = new ThreadBuffer();
+    buffer->Id = registry.Buffers.size() + 1;
+    buffer->Count = 0;
+    for (uint64 i = 0; i < MaxChunks; i++) buffer->Chunks[i] = nullptr;
+
+    registry.Buffers.push_back(unique_ptr<ThreadBuffer>(buffer));
+    sBuffer = buffer;
+    return *buffer;
+}
+
+static void Record(const Event& event)
+{
+    ThreadBuffer& buffer = GetBuffer();
+
+    // only this thread writes Count, Export reads it
+    uint64 count = buffer.Count.load(memory_order_relaxed);
+    if (count >= ChunkSize * MaxChunks) return;
+
+    Event* chunk = buffer.Chunks[count / ChunkSize].load(memory_order_relaxed);
+    if (!chunk)
+    {
+        chunk = new Event[ChunkSize];
+        buffer.Chunks[count / ChunkSize].store(chunk, memory_order_release);
+    }
+
+    chunk[count % ChunkSize] = event;
+    buffer.Count.store(count + 1, memory_order_release);
+}
+
+/**
+ * Writes a string as a JSON string
+ */
+static void WriteString(ostream& out, const char* text)
+{
+    out << '"';
+    for (const char* c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\') out << '\\' << *c;
+        else if ((uint8)*c < 0x20) out << ' ';
+        else out << *c;
+    }
+    out << '"';
+}
+
+Zone::Zone(const char* name)
+    : mName(nullptr),
+      mStart(0)
+{
+    if (!sRecording.load(memory_order_relaxed)) return;
+
+    mName = name;
+    mStart = Time::Nanos();
+}
+
+Zone::~Zone()
+{
+    if (!mName) return;
+
+    Event event = { mName, mStart, Time::Nanos() - mStart, 0, false };
+    Record(event);
+}
+
+void Start()
+{
+    sRecording = true;
+}
+
+void Stop()
+{
+    sRecording = false;
+}
+
+bool IsRecording()
+{
+    return sRecording;
+}
+
+void Counter(const char* name, float64 value)
+{
+    if (!sRecording.load(memory_order_relaxed)) return;
+
+    Event event = { name, Time::Nanos(), 0, value, true };
+    Record(event);
+}
+
+void SetThreadName(const string& name)
+{
+    ThreadBuffer& buffer = GetBuffer();
+
+    lock_guard<mutex> lock(GetRegistry().Mutex);
+    buffer.Name = name;
+}
+
+uint64 GetEventCount()
+{
+    Registry& registry = GetRegistry();
+    lock_guard<mutex> lock(registry.Mutex);
+
+    uint64 count = 0;
+    for (const unique_ptr<ThreadBuffer>& buffer : registry.Buffers)
+    {
+        count += buffer->Count;
+    }
+    return count;
+}
+
+bool Export(const string& file)
+{
+    ofstream out(file);
+    if (!out)
+    {
+        cout << "Could not write trace: " << file << endl;
+        return false;
+    }
+
+    Registry& registry = GetRegistry();
+    lock_guard<mutex> lock(registry.Mutex);
+
+    // times are in microseconds, keep them to the nanosecond
+    out << fixed << setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    for (const unique_ptr<ThreadBuffer>& buffer : registry.Buffers)
+    {
+        if (!buffer->Name.empty())
+        {
+            out << (first ? "\n" : ",\n");
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->Id << ",\"args\":{\"name\":";
+            WriteString(out, buffer->Name.c_str());
+            out << "}}";
+            first = false;
+        }
+
+        uint64 count = buffer->Count.load(memory_order_acquire);
+        for (uint64 i = 0; i < count; i++)
+        {
+            const Event& event = buffer->Chunks[i / ChunkSize].load(memory_order_acquire)[i % ChunkSize];
+
+            out << (first ? "\n" : ",\n");
+            out << "{\"name\":";
+            WriteString(out, event.Name);
+            if (event.IsCounter)
+            {
+                out << ",\"ph\":\"C\",\"ts\":" << event.Start / 1000.0 << ",\"pid\":1,\"tid\":" << buffer->Id
+                    << ",\"args\":{\"value\":" << event.Value << "}}";
+            }
+            else
+            {
+                out << ",\"ph\":\"X\",\"ts\":" << event.Start / 1000.0 << ",\"dur\":" << event.Duration / 1000.0
+                    << ",\"pid\":1,\"tid\":" << buffer->Id << "}";
+            }
+            first = false;
+        }
+    }
+
+    out << "\n]}\n";
+
+    if (!out)
+    {
+        cout << "Could not write trace: " << file << endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+}
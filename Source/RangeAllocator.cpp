@@ -0,0 +1,75 @@
+#include "RangeAllocator.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace Core
+{
+
+const uint32 RangeAllocator::Invalid;
+
+RangeAllocator::RangeAllocator(uint32 capacity)
+    : mFree(),
+      mCapacity(capacity),
+      mFreeCount(capacity)
+{
+    if (capacity > 0) mFree[0] = capacity;
+}
+
+uint32 RangeAllocator::Allocate(uint32 count)
+{
+    if (count == 0) return Invalid;
+
+    for (auto range = mFree.begin(); range != mFree.end(); ++range)
+    {
+        if (range->second < count) continue;
+
+        uint32 start = range->first;
+        uint32 left = range->second - count;
+        mFree.erase(range);
+        if (left > 0) mFree[start + count] = left;
+
+        mFreeCount -= count;
+        return start;
+    }
+    return Invalid;
+}
+
+void RangeAllocator::Free(uint32 start, uint32 count)
+{
+    if (count == 0) return;
+
+    mFreeCount += count;
+
+    auto next = mFree.lower_bound(start);
+    if (next != mFree.end() && start + count == next->first)
+    {
+        count += next->second;
+        next = mFree.erase(next);
+    }
+
+    if (next != mFree.begin())
+    {
+        auto previous = prev(next);
+        if (previous->first + previous->second == start)
+        {
+            previous->second += count;
+            return;
+        }
+    }
+
+    mFree[start] = count;
+}
+
+uint32 RangeAllocator::GetLargestFree() const
+{
+    uint32 largest = 0;
+    for (const auto& range : mFree)
+    {
+        largest = max(largest, range.second);
+    }
+    return largest;
+}
+
+}
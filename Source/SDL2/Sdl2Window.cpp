@@ -1,5 +1,6 @@
 #include "SDL2/Sdl2Window.h"
 
+#include <cmath>
 #include <iostream>
 #include <string>
 
@@ -129,6 +130,28 @@ void Sdl2Window::PollEvents()
     }
 }
 
+void Sdl2Window::WaitEvents(float64 timeout)
+{
+    //without an event to fill in, SDL leaves the event in the queue for PollEvents
+    if (timeout < 0)
+    {
+        SDL_WaitEvent(nullptr);
+    }
+    else
+    {
+        SDL_WaitEventTimeout(nullptr, (int)std::ceil(timeout * 1000));
+    }
+}
+
+void Sdl2Window::Wake()
+{
+    //PollEvents skips events it doesn't know
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = SDL_USEREVENT;
+    SDL_PushEvent(&e);
+}
+
 void Sdl2Window::SwapBuffers()
 {
     SDL_GL_SwapWindow(mWindow);
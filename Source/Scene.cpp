@@ -0,0 +1,583 @@
+#include "Scene.h"
+
+#include <algorithm>
+
+#include "MeshUtil.h"
+#include "Profiler.h"
+
+using namespace std;
+using namespace Core::Math;
+using namespace Video;
+
+namespace Core
+{
+
+const uint32 Scene::None;
+const uint32 Scene::PageVertexCount;
+const uint32 Scene::PageIndexCount;
+const uint32 Scene::MinInstanceCount;
+
+/**
+ * Vertices of the instance buffer, one per instance
+ */
+static const VertexFormat InstanceFormat = VertexFormat()
+        .AddElement(Attribute::Model0, 4)
+        .AddElement(Attribute::Model1, 4)
+        .AddElement(Attribute::Model2, 4)
+        .AddElement(Attribute::Model3, 4)
+        .AddElement(Attribute::NormalMat0, 3)
+        .AddElement(Attribute::NormalMat1, 3)
+        .AddElement(Attribute::NormalMat2, 3)
+        .AddElement(Attribute::Color, 3)
+        .SetInstanced(true);
+
+/**
+ * @return true if vertices of both formats can share a buffer
+ */
+static bool SameFormat(const VertexFormat& a, const VertexFormat& b)
+{
+    if (a.GetElementCount() != b.GetElementCount()) return false;
+
+    for (uint i = 0; i < a.GetElementCount(); i++)
+    {
+        if (a[i].Attrib != b[i].Attrib || a[i].Count != b[i].Count) return false;
+    }
+    return true;
+}
+
+/**
+ * @return length of the longest axis of a matrix, how much it scales a sphere by
+ */
+static float32 GetMaxScale(const Matrix4f& world)
+{
+    float32 scale = 0;
+    for (uint c = 0; c < 3; c++)
+    {
+        scale = max(scale, Length(Vector3f(world[c].X, world[c].Y, world[c].Z)));
+    }
+    return scale;
+}
+
+Scene::Scene(IGraphicsDevice* graphics)
+    : mGraphics(graphics),
+      mTransforms(),
+      mRoot(TransformHierarchy::None),
+      mPages(),
+      mMeshes(),
+      mFreeMeshes(),
+      mObjects(),
+      mObjectSlots(),
+      mFreeObjects(),
+      mInstancedShaders(),
+      mInstances(nullptr),
+      mDraws(),
+      mBatches(),
+      mInstanceData(),
+      mStats()
+{
+    mRoot = mTransforms.Add();
+}
+
+Scene::~Scene()
+{
+    for (uint32 page = 0; page < mPages.size(); page++)
+    {
+        if (mPages[page].Geometry) ReleasePage(page);
+    }
+
+    if (mInstances)
+    {
+        mInstances->Release();
+        delete mInstances;
+    }
+}
+
+Scene::MeshId Scene::AddMesh(const MeshView& mesh)
+{
+    const uint32 vertexCount = mesh.VertexCount;
+
+    //meshes without indices get the ones that draw their vertices in order
+    vector<uint32> ownIndices;
+    if (mesh.IndexCount == 0)
+    {
+        ownIndices.resize(vertexCount - vertexCount % 3);
+        for (uint32 i = 0; i < ownIndices.size(); i++) ownIndices[i] = i;
+    }
+    const uint32* indices = mesh.IndexCount == 0 ? ownIndices.data() : mesh.Indices;
+    const uint32 indexCount = mesh.IndexCount == 0 ? ownIndices.size() : mesh.IndexCount;
+
+    if (vertexCount == 0 || indexCount == 0) return None;
+
+    MeshInfo info;
+    info.Page = FindPage(mesh.Format, vertexCount, indexCount);
+    Page& page = mPages[info.Page];
+    info.VertexStart = page.Vertices.Allocate(vertexCount);
+    info.VertexCount = vertexCount;
+    info.IndexStart = page.Indices.Allocate(indexCount);
+    info.IndexCount = indexCount;
+
+    page.Vbo->SetData(mesh.Vertices, info.VertexStart, vertexCount);
+
+    //indices point into the whole page, not just the mesh's vertices
+    if (info.VertexStart == 0)
+    {
+        page.Ibo->SetData(indices, info.IndexStart, indexCount);
+    }
+    else
+    {
+        vector<uint32> rebased(indices, indices + indexCount);
+        for (uint32& index : rebased) index += info.VertexStart;
+        page.Ibo->SetData(rebased.data(), info.IndexStart, indexCount);
+    }
+
+    info.Lods.assign(mesh.Lods, mesh.Lods + mesh.LodCount);
+    if (info.Lods.empty())
+    {
+        MeshLod full = { 0, indexCount, 0.0f };
+        info.Lods.push_back(full);
+    }
+
+    info.Low = Vector3f(0);
+    info.High = Vector3f(0);
+    for (uint i = 0; i < mesh.Format.GetElementCount(); i++)
+    {
+        if (mesh.Format[i].Attrib != Attribute::Position) continue;
+
+        const float32* positions = mesh.Vertices + mesh.Format.GetOffsetOf(i) / 4;
+        MeshUtil::ComputeBounds(MeshUtil::Interleaved(positions, vertexCount, mesh.Format.GetSizeInFloats()), info.Low, info.High);
+        break;
+    }
+    info.Center = (info.Low + info.High) * 0.5f;
+    info.Radius = Length(info.High - info.Low) * 0.5f;
+    info.Valid = true;
+
+    MeshId id;
+    if (mFreeMeshes.empty())
+    {
+        id = mMeshes.size();
+        mMeshes.push_back(info);
+    }
+    else
+    {
+        id = mFreeMeshes.back();
+        mFreeMeshes.pop_back();
+        mMeshes[id] = info;
+    }
+    return id;
+}
+
+void Scene::RemoveMesh(MeshId mesh)
+{
+    if (!IsValidMesh(mesh)) return;
+
+    for (uint32 slot = mObjects.size(); slot-- > 0;)
+    {
+        if (mObjects[slot].Mesh == mesh) Remove(mObjects[slot].Id);
+    }
+
+    MeshInfo& info = mMeshes[mesh];
+    Page& page = mPages[info.Page];
+    page.Vertices.Free(info.VertexStart, info.VertexCount);
+    page.Indices.Free(info.IndexStart, info.IndexCount);
+    if (page.Vertices.IsEmpty()) ReleasePage(info.Page);
+
+    info.Lods.clear();
+    info.Valid = false;
+    mFreeMeshes.push_back(mesh);
+}
+
+bool Scene::IsValidMesh(MeshId mesh) const
+{
+    return mesh < mMeshes.size() && mMeshes[mesh].Valid;
+}
+
+void Scene::GetMeshBounds(MeshId mesh, Vector3f& refLow, Vector3f& refHigh) const
+{
+    if (!IsValidMesh(mesh))
+    {
+        refLow = refHigh = Vector3f(0);
+        return;
+    }
+
+    refLow = mMeshes[mesh].Low;
+    refHigh = mMeshes[mesh].High;
+}
+
+uint32 Scene::FindPage(const VertexFormat& format, uint32 vertexCount, uint32 indexCount)
+{
+    const bool dedicated = vertexCount > PageVertexCount || indexCount > PageIndexCount;
+
+    uint32 unused = mPages.size();
+    for (uint32 i = 0; i < mPages.size(); i++)
+    {
+        const Page& page = mPages[i];
+        if (!page.Geometry)
+        {
+            unused = min(unused, i);
+            continue;
+        }
+
+        if (dedicated || page.Dedicated || !SameFormat(page.Format, format)) continue;
+        if (page.Vertices.GetLargestFree() >= vertexCount && page.Indices.GetLargestFree() >= indexCount) return i;
+    }
+
+    Page page;
+    page.Format = format;
+    page.Dedicated = dedicated;
+    page.Vertices = RangeAllocator(dedicated ? vertexCount : PageVertexCount);
+    page.Indices = RangeAllocator(dedicated ? indexCount : PageIndexCount);
+
+    //shared pages are written again whenever a mesh moves in, but nothing reads the meshes back often
+    //enough to be worth the second copy in system memory a dynamic buffer would otherwise keep
+    const BufferHint hint = dedicated ? BufferHint::Static : BufferHint::Dynamic;
+    page.Vbo = mGraphics->CreateVertexBuffer(format, page.Vertices.GetCapacity(), hint, BufferShadow::None);
+
+    //16 bit indices when every vertex can be reached with them
+    IndexFormat indexFormat = page.Vertices.GetCapacity() <= 0x10000 ? IndexFormat::UInt16 : IndexFormat::UInt32;
+    page.Ibo = mGraphics->CreateIndexBuffer(page.Indices.GetCapacity(), hint, indexFormat, BufferShadow::None);
+
+    page.Geometry = mGraphics->CreateGeometry();
+    page.Geometry->SetVertexBuffer(page.Vbo);
+    page.Geometry->SetIndexBuffer(page.Ibo);
+
+    page.InstancedGeometry = mGraphics->CreateGeometry();
+    BindInstances(page);
+
+    if (unused == mPages.size()) mPages.push_back(page);
+    else mPages[unused] = page;
+    return unused;
+}
+
+void Scene::ReleasePage(uint32 page)
+{
+    Page& refPage = mPages[page];
+
+    refPage.Geometry->SetVertexBuffer(nullptr);
+    refPage.Geometry->SetIndexBuffer(nullptr);
+    refPage.Geometry->Release();
+    delete refPage.Geometry;
+
+    refPage.InstancedGeometry->SetVertexBuffer(nullptr);
+    refPage.InstancedGeometry->SetIndexBuffer(nullptr);
+    refPage.InstancedGeometry->Release();
+    delete refPage.InstancedGeometry;
+
+    refPage.Vbo->Release();
+    delete refPage.Vbo;
+
+    refPage.Ibo->Release();
+    delete refPage.Ibo;
+
+    refPage.Geometry = nullptr;
+    refPage.InstancedGeometry = nullptr;
+    refPage.Vbo = nullptr;
+    refPage.Ibo = nullptr;
+    refPage.Vertices = RangeAllocator();
+    refPage.Indices = RangeAllocator();
+}
+
+void Scene::BindInstances(Page& refPage)
+{
+    IVertexBuffer* vbos[] = { refPage.Vbo, mInstances };
+    refPage.InstancedGeometry->SetVertexBuffers(vbos, mInstances ? 2 : 1);
+    refPage.InstancedGeometry->SetIndexBuffer(refPage.Ibo);
+}
+
+Scene::ObjectId Scene::Add(MeshId mesh, IShader* shader, TransformHierarchy::NodeId parent)
+{
+    if (!IsValidMesh(mesh)) return None;
+
+    Object object;
+    object.Mesh = mesh;
+    object.Shader = shader;
+    object.Color = Vector3f(1);
+    object.Node = mTransforms.Add(mTransforms.IsValid(parent) ? parent : mRoot);
+
+    if (mFreeObjects.empty())
+    {
+        object.Id = mObjectSlots.size();
+        mObjectSlots.push_back(None);
+    }
+    else
+    {
+        object.Id = mFreeObjects.back();
+        mFreeObjects.pop_back();
+    }
+
+    mObjectSlots[object.Id] = mObjects.size();
+    mObjects.push_back(object);
+    return object.Id;
+}
+
+void Scene::Remove(ObjectId object)
+{
+    if (!IsValid(object)) return;
+
+    const uint nodeCount = mTransforms.GetCount();
+    const uint32 slot = mObjectSlots[object];
+    mTransforms.Remove(mObjects[slot].Node);
+    RemoveSlot(slot);
+
+    //nothing was below the node, otherwise objects on the nodes below it lost them too
+    if (mTransforms.GetCount() + 1 == nodeCount) return;
+
+    for (uint32 below = mObjects.size(); below-- > 0;)
+    {
+        if (!mTransforms.IsValid(mObjects[below].Node)) RemoveSlot(below);
+    }
+}
+
+void Scene::RemoveSlot(uint32 slot)
+{
+    const ObjectId object = mObjects[slot].Id;
+
+    mObjects[slot] = mObjects.back();
+    mObjectSlots[mObjects[slot].Id] = slot;
+    mObjects.pop_back();
+
+    mObjectSlots[object] = None;
+    mFreeObjects.push_back(object);
+}
+
+void Scene::Clear()
+{
+    while (!mObjects.empty())
+    {
+        Remove(mObjects.back().Id);
+    }
+
+    for (MeshId mesh = 0; mesh < mMeshes.size(); mesh++)
+    {
+        RemoveMesh(mesh);
+    }
+}
+
+bool Scene::IsValid(ObjectId object) const
+{
+    return object < mObjectSlots.size() && mObjectSlots[object] != None;
+}
+
+void Scene::SetColor(ObjectId object, const Vector3f& color)
+{
+    if (!IsValid(object)) return;
+
+    mObjects[mObjectSlots[object]].Color = color;
+}
+
+void Scene::SetShader(ObjectId object, IShader* shader)
+{
+    if (!IsValid(object)) return;
+
+    mObjects[mObjectSlots[object]].Shader = shader;
+}
+
+void Scene::SetInstancedShader(IShader* shader, IShader* instanced)
+{
+    for (uint i = 0; i < mInstancedShaders.size(); i++)
+    {
+        if (mInstancedShaders[i].first != shader) continue;
+
+        if (instanced) mInstancedShaders[i].second = instanced;
+        else mInstancedShaders.erase(mInstancedShaders.begin() + i);
+        return;
+    }
+
+    if (instanced) mInstancedShaders.push_back(make_pair(shader, instanced));
+}
+
+IShader* Scene::FindInstancedShader(IShader* shader) const
+{
+    for (const pair<IShader*, IShader*>& instanced : mInstancedShaders)
+    {
+        if (instanced.first == shader) return instanced.second;
+    }
+    return nullptr;
+}
+
+void Scene::UploadInstances()
+{
+    const uint32 instanceSize = InstanceFormat.GetSizeInFloats();
+
+    mInstanceData.clear();
+    for (Batch& batch : mBatches)
+    {
+        if (!batch.Instanced) continue;
+
+        batch.InstanceStart = mInstanceData.size() / instanceSize;
+        for (uint32 i = batch.First; i < batch.First + batch.Count; i++)
+        {
+            const Object& object = mObjects[mDraws[i].Slot];
+            Matrix4f model = mTransforms.GetWorldMatrix(object.Node);
+            const Matrix3f normalMat(Inverse(Transpose(model)));
+
+            for (uint c = 0; c < 4; c++)
+            {
+                mInstanceData.insert(mInstanceData.end(), { model[c].X, model[c].Y, model[c].Z, model[c].W });
+            }
+            for (uint c = 0; c < 3; c++)
+            {
+                mInstanceData.insert(mInstanceData.end(), { normalMat[c].X, normalMat[c].Y, normalMat[c].Z });
+            }
+            mInstanceData.insert(mInstanceData.end(), { object.Color.X, object.Color.Y, object.Color.Z });
+        }
+    }
+
+    const uint32 instanceCount = mInstanceData.size() / instanceSize;
+    if (instanceCount == 0) return;
+
+    //grown to twice the size it needs so it isn't recreated every time a few objects are added
+    if (!mInstances || mInstances->GetLength() < instanceCount)
+    {
+        uint32 length = max(instanceCount, mInstances ? mInstances->GetLength() * 2 : 0u);
+        if (mInstances)
+        {
+            mInstances->Release();
+            delete mInstances;
+        }
+        //devices that can't draw instances themselves read them back from the buffer, the copy saves a readback
+        mInstances = mGraphics->CreateVertexBuffer(InstanceFormat, length, BufferHint::Stream, BufferShadow::Keep);
+
+        for (Page& page : mPages)
+        {
+            if (page.Geometry) BindInstances(page);
+        }
+    }
+
+    mInstances->SetData(mInstanceData.data(), 0, instanceCount);
+}
+
+void Scene::Render(const RenderView& view)
+{
+    PROFILE_ZONE("Scene::Render");
+
+    mTransforms.Update();
+
+    const Frustumf frustum(view.Projection * view.View);
+
+    mDraws.clear();
+    for (uint32 slot = 0; slot < mObjects.size(); slot++)
+    {
+        const Object& object = mObjects[slot];
+        const MeshInfo& mesh = mMeshes[object.Mesh];
+        const Matrix4f& world = mTransforms.GetWorldMatrix(object.Node);
+        const float32 scale = GetMaxScale(world);
+
+        Vector4f center = world * Vector4f(mesh.Center.X, mesh.Center.Y, mesh.Center.Z, 1);
+        if (!frustum.Intersects(Vector3f(center.X, center.Y, center.Z), mesh.Radius * scale)) continue;
+
+        //how many pixels one model unit covers at the object's distance
+        float32 pixelsPerUnit = view.PixelsPerUnit * scale;
+        if (view.Perspective)
+        {
+            Vector3f origin(world[3].X, world[3].Y, world[3].Z);
+            pixelsPerUnit /= max(Length(view.Position - origin), 1e-6f);
+        }
+
+        //coarsest level that strays less than LodPixelError pixels from the full detail mesh
+        uint32 lod = 0;
+        while (lod + 1 < mesh.Lods.size() && mesh.Lods[lod + 1].Error * pixelsPerUnit <= view.LodPixelError)
+        {
+            lod++;
+        }
+
+        Draw draw = { object.Shader, mesh.Page, object.Mesh, slot, lod };
+        mDraws.push_back(draw);
+    }
+
+    sort(mDraws.begin(), mDraws.end(), [](const Draw& a, const Draw& b)
+    {
+        if (a.Shader != b.Shader) return less<IShader*>()(a.Shader, b.Shader);
+        if (a.Page != b.Page) return a.Page < b.Page;
+        if (a.Mesh != b.Mesh) return a.Mesh < b.Mesh;
+        return a.Lod < b.Lod;
+    });
+
+    //draws sharing a mesh, level of detail and shader are drawn at once if the shader has an instanced version
+    mBatches.clear();
+    for (uint32 first = 0; first < mDraws.size();)
+    {
+        const Draw& draw = mDraws[first];
+        uint32 last = first + 1;
+        while (last < mDraws.size() && mDraws[last].Shader == draw.Shader && mDraws[last].Mesh == draw.Mesh &&
+                mDraws[last].Lod == draw.Lod)
+        {
+            last++;
+        }
+
+        Batch batch = { first, last - first, nullptr, 0 };
+        if (batch.Count >= MinInstanceCount) batch.Instanced = FindInstancedShader(draw.Shader);
+        mBatches.push_back(batch);
+        first = last;
+    }
+    UploadInstances();
+
+    mStats.ObjectCount = mObjects.size();
+    mStats.VisibleCount = mDraws.size();
+    mStats.DrawCount = 0;
+    mStats.StateChanges = 0;
+    mStats.InstancedCount = 0;
+    mStats.TriangleCount = 0;
+    mStats.PageCount = 0;
+    for (const Page& page : mPages)
+    {
+        if (page.Geometry) mStats.PageCount++;
+    }
+
+    IShader* shader = nullptr;
+    IGeometry* geometry = nullptr;
+    for (const Batch& batch : mBatches)
+    {
+        const Draw& first = mDraws[batch.First];
+        const Page& page = mPages[first.Page];
+        IShader* batchShader = batch.Instanced ? batch.Instanced : first.Shader;
+        IGeometry* batchGeometry = batch.Instanced ? page.InstancedGeometry : page.Geometry;
+
+        if (batchShader != shader)
+        {
+            shader = batchShader;
+            shader->SetMatrix4f("Projection", view.Projection);
+            shader->SetMatrix4f("View", view.View);
+            mGraphics->SetShader(shader);
+            mStats.StateChanges++;
+        }
+
+        if (batchGeometry != geometry)
+        {
+            geometry = batchGeometry;
+            mGraphics->SetGeometry(geometry);
+            mStats.StateChanges++;
+        }
+
+        const MeshInfo& mesh = mMeshes[first.Mesh];
+        const MeshLod& lod = mesh.Lods[first.Lod];
+
+        if (batch.Instanced)
+        {
+            mGraphics->DrawIndicesInstanced(Primitive::TriangleList, mesh.IndexStart + lod.IndexStart, lod.IndexCount / 3,
+                    batch.InstanceStart, batch.Count);
+
+            mStats.DrawCount++;
+            mStats.InstancedCount += batch.Count;
+            mStats.TriangleCount += (uint64)batch.Count * (lod.IndexCount / 3);
+            continue;
+        }
+
+        for (uint32 i = batch.First; i < batch.First + batch.Count; i++)
+        {
+            const Object& object = mObjects[mDraws[i].Slot];
+            Matrix4f model = mTransforms.GetWorldMatrix(object.Node);
+            shader->SetMatrix4f("Model", model);
+            shader->SetMatrix3f("NormalMat", Matrix3f(Inverse(Transpose(model))));
+            shader->SetVector3f("Color", object.Color);
+
+            mGraphics->DrawIndices(Primitive::TriangleList, mesh.IndexStart + lod.IndexStart, lod.IndexCount / 3);
+
+            mStats.DrawCount++;
+            mStats.TriangleCount += lod.IndexCount / 3;
+        }
+    }
+
+    Profiler::Counter("Scene objects drawn", mStats.DrawCount);
+}
+
+}
@@ -0,0 +1,30 @@
+#include "Soft/SoftBackend.h"
+
+#include <iostream>
+
+using namespace std;
+
+namespace Core
+{
+
+SoftBackend::SoftBackend(uint width, uint height)
+    : mWindow("Modeler3D", width, height),
+      mGraphics(&mWindow)
+{
+}
+
+SoftBackend::~SoftBackend()
+{
+}
+
+void SoftBackend::Init()
+{
+    cout << "Software rasterizer on " << mGraphics.GetThreadCount() << " threads" << endl;
+    mGraphics.Init();
+}
+
+void SoftBackend::Destroy()
+{
+}
+
+}
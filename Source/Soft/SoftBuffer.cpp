@@ -0,0 +1,46 @@
+#include "Soft/SoftBuffer.h"
+
+#include <string.h>
+
+namespace Video
+{
+
+BufferMemoryStats SoftBuffer::sMemory = { 0, 0, 0 };
+
+SoftBuffer::SoftBuffer(uint64 size)
+    : mData(size, 0),
+      mReleased(false)
+{
+    sMemory.BufferCount++;
+    sMemory.GpuBytes += size;
+}
+
+SoftBuffer::~SoftBuffer()
+{
+    Release();
+}
+
+void SoftBuffer::Release()
+{
+    if (mReleased) return;
+
+    sMemory.BufferCount--;
+    sMemory.GpuBytes -= mData.size();
+
+    std::vector<uint8>().swap(mData);
+    mReleased = true;
+}
+
+void SoftBuffer::Read(uint64 offset, void* out, uint64 size) const
+{
+    if (offset + size > mData.size()) return;
+    memcpy(out, mData.data() + offset, size);
+}
+
+void SoftBuffer::Write(uint64 offset, const void* in, uint64 size)
+{
+    if (offset + size > mData.size()) return;
+    memcpy(mData.data() + offset, in, size);
+}
+
+}
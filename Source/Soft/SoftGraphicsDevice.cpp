@@ -0,0 +1,456 @@
+#include "Soft/SoftGraphicsDevice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lodepng.h"
+
+#include "IWindow.h"
+#include "Profiler.h"
+
+#include "Math/ModelerMath.h"
+
+#include "Soft/SoftBuffer.h"
+#include "Soft/SoftGeometry.h"
+#include "Soft/SoftIndexBuffer.h"
+#include "Soft/SoftTexture2D.h"
+#include "Soft/SoftVertexBuffer.h"
+
+using namespace std;
+using namespace Core;
+using namespace Core::Math;
+
+namespace Video
+{
+
+/** Texture units, the same number OglGraphicsDevice has */
+static const uint TextureUnitCount = 16;
+
+/** Vertices each vertex stage task transforms */
+static const uint VerticesPerTask = 4096;
+
+/** Floats the Lit program passes to its pixels, view space position then normal */
+static const uint LitVaryings = 6;
+
+/** Floats the Screen program passes to its pixels, color then texture coordinate */
+static const uint ScreenVaryings = 6;
+
+static float32 Saturate(float32 value)
+{
+    return min(max(value, 0.0f), 1.0f);
+}
+
+/**
+ * Modeler3D's fragment shader, diffuse and specular light from LightDirection over an ambient term
+ */
+class LitPixelShader : public SoftPixelShader
+{
+public:
+    Vector3f Color;
+    /** LightDirection in view space, normalized */
+    Vector3f LightDirection;
+
+    void Shade(const float32* varyings, float32* refColor) const
+    {
+        Vector3f cameraDir = Normalize(Vector3f(varyings[0], varyings[1], varyings[2]));
+        Vector3f normal = Normalize(Vector3f(varyings[3], varyings[4], varyings[5]));
+
+        float32 diffuse = Saturate(Dot(normal, -LightDirection));
+
+        Vector3f halfVec = Normalize(LightDirection + cameraDir);
+        float32 specular = pow(Saturate(Dot(normal, -halfVec)), 100.0f);
+
+        float32 light = diffuse * 0.4f + 0.4f + specular * 0.4f;
+        refColor[0] = Color.X * light;
+        refColor[1] = Color.Y * light;
+        refColor[2] = Color.Z * light;
+        refColor[3] = 1;
+    }
+};
+
+/**
+ * GuiRenderer's fragment shader, the vertex color times the texture
+ */
+class ScreenPixelShader : public SoftPixelShader
+{
+public:
+    bool Textured;
+    /** nullptr samples black, like an incomplete GL texture */
+    const SoftTexture2D* Texture;
+
+    void Shade(const float32* varyings, float32* refColor) const
+    {
+        copy(varyings, varyings + 4, refColor);
+        if (!Textured) return;
+
+        float32 texel[4] = { 0, 0, 0, 1 };
+        if (Texture) Texture->Sample(varyings[4], varyings[5], texel);
+
+        for (uint i = 0; i < 4; i++) refColor[i] *= texel[i];
+    }
+};
+
+/**
+ * Reads one vertex's attribute, components the buffer doesn't have default to 0, 0, 0, 1 like GL
+ */
+static void Fetch(const float32* data, uint stride, uint count, uint vertex, float32* refValue)
+{
+    refValue[0] = refValue[1] = refValue[2] = 0;
+    refValue[3] = 1;
+    if (data) copy(data + (uint64)vertex * stride, data + (uint64)vertex * stride + count, refValue);
+}
+
+SoftGraphicsDevice::SoftGraphicsDevice(IWindow* window)
+    : mWindow(window),
+      mTextures(TextureUnitCount),
+      mRasterizer(),
+      mVertices(),
+      mIndices()
+{
+    mClearColor[0] = mClearColor[1] = mClearColor[2] = 0;
+    mClearColor[3] = 1;
+}
+
+SoftGraphicsDevice::~SoftGraphicsDevice()
+{
+}
+
+void SoftGraphicsDevice::Init()
+{
+    UpdateSize();
+}
+
+void SoftGraphicsDevice::UpdateSize()
+{
+    if (mWindow->GetWidth() != mRasterizer.GetWidth() || mWindow->GetHeight() != mRasterizer.GetHeight())
+    {
+        mRasterizer.Resize(mWindow->GetWidth(), mWindow->GetHeight());
+    }
+}
+
+void SoftGraphicsDevice::SetClearColor(float32 r, float32 g, float32 b, float32 a)
+{
+    mClearColor[0] = r;
+    mClearColor[1] = g;
+    mClearColor[2] = b;
+    mClearColor[3] = a;
+}
+
+IVertexBuffer* SoftGraphicsDevice::CreateVertexBuffer(VertexFormat format, uint count, BufferHint hint,
+        BufferShadow shadow)
+{
+    return new SoftVertexBuffer(format, count);
+}
+
+IIndexBuffer* SoftGraphicsDevice::CreateIndexBuffer(uint count, BufferHint hint, IndexFormat format,
+        BufferShadow shadow)
+{
+    return new SoftIndexBuffer(count, format);
+}
+
+BufferMemoryStats SoftGraphicsDevice::GetBufferMemory() const
+{
+    return SoftBuffer::GetMemoryStats();
+}
+
+IGeometry* SoftGraphicsDevice::CreateGeometry()
+{
+    return new SoftGeometry;
+}
+
+void SoftGraphicsDevice::Clear(bool color, bool depth)
+{
+    UpdateSize();
+    mRasterizer.Clear(color ? mClearColor : nullptr, depth);
+}
+
+void SoftGraphicsDevice::ReadPixels(vector<uint8>& refPixels, uint& refWidth, uint& refHeight)
+{
+    refWidth = mRasterizer.GetWidth();
+    refHeight = mRasterizer.GetHeight();
+    mRasterizer.ReadPixels(refPixels);
+}
+
+void SoftGraphicsDevice::SetGeometry(IGeometry* geom)
+{
+    mGeometry = dynamic_cast<SoftGeometry*>(geom);
+}
+
+IShader* SoftGraphicsDevice::CreateShader(const std::string& vertex, const std::string& fragment)
+{
+    return new SoftShader(vertex, fragment);
+}
+
+void SoftGraphicsDevice::SetShader(IShader* shader)
+{
+    mShader = dynamic_cast<SoftShader*>(shader);
+}
+
+float32 SoftGraphicsDevice::GetWidth() const
+{
+    return mWindow->GetWidth();
+}
+
+float32 SoftGraphicsDevice::GetHeight() const
+{
+    return mWindow->GetHeight();
+}
+
+float32 SoftGraphicsDevice::GetAspectRatio() const
+{
+    return mWindow->GetAspectRatio();
+}
+
+ITexture2D* SoftGraphicsDevice::CreateTexture2D(const std::string& filename)
+{
+    vector<uint8> pixels;
+    uint width, height;
+
+    uint error = lodepng::decode(pixels, width, height, filename, LCT_RGBA);
+
+    if (error)
+    {
+        cout << "Error reading image: " << filename << endl;
+        return nullptr;
+    }
+
+    // the first row is at the bottom of a texture
+    for (uint y = 0; y < height / 2; y++)
+    {
+        swap_ranges(pixels.begin() + y * width * 4, pixels.begin() + (y + 1) * width * 4,
+                pixels.begin() + (height - y - 1) * width * 4);
+    }
+
+    SoftTexture2D* tex = new SoftTexture2D(width, height);
+    tex->SetData(&pixels[0], 0, 0, width, height);
+    return tex;
+}
+
+ITexture2D* SoftGraphicsDevice::CreateTexture2D(uint width, uint height)
+{
+    return new SoftTexture2D(width, height);
+}
+
+void SoftGraphicsDevice::SetTexture(uint index, ITexture2D* tex)
+{
+    mTextures[index] = dynamic_cast<SoftTexture2D*>(tex);
+}
+
+uint SoftGraphicsDevice::FindAttributes(AttributeSource* refSources, uint& refInstanceCount) const
+{
+    uint vertexCount = 0xFFFFFFFF;
+    refInstanceCount = 0xFFFFFFFF;
+
+    for (uint i = 0; i < AttributeCount; i++)
+    {
+        refSources[i].Data = nullptr;
+        refSources[i].Stride = 0;
+        refSources[i].Count = 0;
+        refSources[i].Instanced = false;
+    }
+
+    // an attribute in more than one vertex buffer is read from the first
+    for (uint i = 0; i < mGeometry->GetVertexBufferCount(); i++)
+    {
+        const SoftVertexBuffer* vbo = dynamic_cast<const SoftVertexBuffer*>(mGeometry->GetVertexBuffer(i));
+        if (!vbo) continue;
+
+        const VertexFormat& format = vbo->GetFormat();
+        if (format.IsInstanced()) refInstanceCount = min(refInstanceCount, vbo->GetLength());
+        else vertexCount = min(vertexCount, vbo->GetLength());
+
+        for (uint j = 0; j < format.GetElementCount(); j++)
+        {
+            const VertexElement& elem = format.GetElement(j);
+            AttributeSource& source = refSources[static_cast<uint>(elem.Attrib)];
+
+            if (!source.Data)
+            {
+                source.Data = vbo->GetVertices() + format.GetOffsetOf(j) / 4;
+                source.Stride = format.GetSizeInFloats();
+                source.Count = min(elem.Count, 4u);
+                source.Instanced = format.IsInstanced();
+            }
+        }
+    }
+
+    return vertexCount;
+}
+
+void SoftGraphicsDevice::FetchAttribute(const AttributeSource& source, uint vertex, uint instance, float32* refValue)
+{
+    Fetch(source.Data, source.Stride, source.Count, source.Instanced ? instance : vertex, refValue);
+}
+
+void SoftGraphicsDevice::DrawVertices(uint first, uint count, const uint32* indices, uint triangleCount, uint instanceStart,
+        uint instanceCount)
+{
+    PROFILE_ZONE("SoftGraphicsDevice::DrawVertices");
+
+    AttributeSource sources[AttributeCount];
+    uint instanceLength;
+    if ((uint64)first + count > FindAttributes(sources, instanceLength)) return;
+
+    // instances are only read from instanced buffers, there's nothing to check without one
+    if (instanceLength != 0xFFFFFFFF && (uint64)instanceStart + instanceCount > instanceLength) return;
+
+    const AttributeSource& position = sources[static_cast<uint>(Attribute::Position)];
+    const AttributeSource& normal = sources[static_cast<uint>(Attribute::Normal)];
+    const AttributeSource& color = sources[static_cast<uint>(Attribute::Color)];
+    const AttributeSource& texCoord = sources[static_cast<uint>(Attribute::TexCoord0)];
+
+    mVertices.resize(count);
+    const uint taskCount = (count + VerticesPerTask - 1) / VerticesPerTask;
+
+    for (uint instance = instanceStart; instance < instanceStart + instanceCount; instance++)
+    {
+        if (mShader->GetProgram() == SoftProgram::Lit)
+        {
+            const Matrix4f projection = mShader->GetMatrix4f("Projection");
+            const Matrix4f view = mShader->GetMatrix4f("View");
+            const Matrix3f viewRotation(view);
+
+            Matrix4f modelView;
+            Matrix3f normalMat;
+            LitPixelShader shader;
+            if (mShader->IsInstanced())
+            {
+                // the matrices are split into one attribute per column
+                Matrix4f model;
+                for (uint c = 0; c < 4; c++)
+                {
+                    float32 column[4];
+                    FetchAttribute(sources[static_cast<uint>(Attribute::Model0) + c], first, instance, column);
+                    model[c] = Vector4f(column[0], column[1], column[2], column[3]);
+                }
+                for (uint c = 0; c < 3; c++)
+                {
+                    float32 column[4];
+                    FetchAttribute(sources[static_cast<uint>(Attribute::NormalMat0) + c], first, instance, column);
+                    normalMat[c] = Vector3f(column[0], column[1], column[2]);
+                }
+                modelView = view * model;
+
+                float32 instanceColor[4];
+                FetchAttribute(color, first, instance, instanceColor);
+                shader.Color = Vector3f(instanceColor[0], instanceColor[1], instanceColor[2]);
+            }
+            else
+            {
+                modelView = view * mShader->GetMatrix4f("Model");
+                normalMat = mShader->GetMatrix3f("NormalMat");
+                shader.Color = mShader->GetVector3f("Color");
+            }
+
+            mRasterizer.Run(taskCount, [&](uint task)
+            {
+                uint end = min(count, (task + 1) * VerticesPerTask);
+                for (uint i = task * VerticesPerTask; i < end; i++)
+                {
+                    float32 p[4], n[4];
+                    FetchAttribute(position, first + i, instance, p);
+                    FetchAttribute(normal, first + i, instance, n);
+
+                    Vector4f viewPosition = modelView * Vector4f(p[0], p[1], p[2], 1.0f);
+                    Vector4f clip = projection * viewPosition;
+
+                    // the fragment shader turns the normal into view space, it is linear so that can happen here
+                    Vector3f viewNormal = viewRotation * Normalize(normalMat * Vector3f(n[0], n[1], n[2]));
+
+                    SoftVertex& vertex = mVertices[i];
+                    copy(&clip[0], &clip[0] + 4, vertex.Position);
+                    copy(&viewPosition[0], &viewPosition[0] + 3, vertex.Varyings);
+                    copy(&viewNormal[0], &viewNormal[0] + 3, vertex.Varyings + 3);
+                }
+            });
+
+            Vector3f lightDirection = mShader->GetVector3f("LightDirection");
+            Vector4f viewLight = view * Vector4f(lightDirection.X, lightDirection.Y, lightDirection.Z, 1.0f);
+            shader.LightDirection = Normalize(Vector3f(viewLight.X, viewLight.Y, viewLight.Z));
+
+            mRasterizer.DrawTriangles(mVertices.data(), indices, triangleCount, LitVaryings, shader);
+        }
+        else
+        {
+            mRasterizer.Run(taskCount, [&](uint task)
+            {
+                uint end = min(count, (task + 1) * VerticesPerTask);
+                for (uint i = task * VerticesPerTask; i < end; i++)
+                {
+                    float32 p[4];
+                    FetchAttribute(position, first + i, instance, p);
+
+                    SoftVertex& vertex = mVertices[i];
+                    vertex.Position[0] = p[0];
+                    vertex.Position[1] = p[1];
+                    vertex.Position[2] = -1;
+                    vertex.Position[3] = 1;
+
+                    FetchAttribute(color, first + i, instance, vertex.Varyings);
+
+                    float32 uv[4];
+                    FetchAttribute(texCoord, first + i, instance, uv);
+                    vertex.Varyings[4] = uv[0];
+                    vertex.Varyings[5] = uv[1];
+                }
+            });
+
+            ScreenPixelShader shader;
+            shader.Textured = mShader->HasUniform("Texture");
+            shader.Texture = mTextures[min<uint>(mShader->GetInt32("Texture"), TextureUnitCount - 1)];
+
+            mRasterizer.DrawTriangles(mVertices.data(), indices, triangleCount, ScreenVaryings, shader);
+        }
+    }
+}
+
+void SoftGraphicsDevice::Draw(Primitive prim, uint start, uint primCount)
+{
+    DrawInstanced(prim, start, primCount, 0, 1);
+}
+
+void SoftGraphicsDevice::DrawIndices(Primitive prim, uint start, uint primCount)
+{
+    DrawIndicesInstanced(prim, start, primCount, 0, 1);
+}
+
+void SoftGraphicsDevice::DrawInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount)
+{
+    if (mGeometry == nullptr || mShader == nullptr || instanceCount == 0) return;
+
+    UpdateSize();
+    DrawVertices(start, primCount * 3, nullptr, primCount, instanceStart, instanceCount);
+}
+
+void SoftGraphicsDevice::DrawIndicesInstanced(Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount)
+{
+    if (mGeometry == nullptr || mShader == nullptr || instanceCount == 0) return;
+
+    const SoftIndexBuffer* ibo = dynamic_cast<const SoftIndexBuffer*>(mGeometry->GetIndexBuffer());
+    if (!ibo || primCount == 0 || (uint64)start + primCount * 3 > ibo->GetLength()) return;
+
+    // only the vertices the indices reach go through the vertex stage
+    const uint count = primCount * 3;
+    uint32 lowest = 0xFFFFFFFF, highest = 0;
+    mIndices.resize(count);
+    for (uint i = 0; i < count; i++)
+    {
+        uint32 index = ibo->GetIndex(start + i);
+        mIndices[i] = index;
+        lowest = min(lowest, index);
+        highest = max(highest, index);
+    }
+
+    for (uint32& index : mIndices)
+    {
+        index -= lowest;
+    }
+
+    UpdateSize();
+    DrawVertices(lowest, highest - lowest + 1, mIndices.data(), primCount, instanceStart, instanceCount);
+}
+
+}
@@ -0,0 +1,55 @@
+#include "Soft/SoftIndexBuffer.h"
+
+#include <vector>
+
+using namespace std;
+
+namespace Video
+{
+
+SoftIndexBuffer::SoftIndexBuffer(uint length, IndexFormat format)
+    : mLength(length),
+      mFormat(format),
+      mBuffer((uint64)length * GetBytesPerIndex())
+{
+}
+
+SoftIndexBuffer::~SoftIndexBuffer()
+{
+    Release();
+}
+
+void SoftIndexBuffer::Release()
+{
+    mBuffer.Release();
+}
+
+void SoftIndexBuffer::GetData(uint32* out, uint start, uint count) const
+{
+    if (mFormat == IndexFormat::UInt16)
+    {
+        vector<uint16> indices(count);
+        mBuffer.Read((uint64)start * 2, indices.data(), (uint64)count * 2);
+        for (uint i = 0; i < count; i++) out[i] = indices[i];
+    }
+    else
+    {
+        mBuffer.Read((uint64)start * 4, out, (uint64)count * 4);
+    }
+}
+
+void SoftIndexBuffer::SetData(const uint32* in, uint start, uint count)
+{
+    if (mFormat == IndexFormat::UInt16)
+    {
+        vector<uint16> indices(count);
+        for (uint i = 0; i < count; i++) indices[i] = static_cast<uint16>(in[i]);
+        mBuffer.Write((uint64)start * 2, indices.data(), (uint64)count * 2);
+    }
+    else
+    {
+        mBuffer.Write((uint64)start * 4, in, (uint64)count * 4);
+    }
+}
+
+}
@@ -0,0 +1,521 @@
+#include "Soft/SoftRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ThreadUtil.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFT_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace Core;
+
+namespace Video
+{
+
+/** Width and height of the screen tiles in pixels, a multiple of 4 */
+static const int32 TileSize = 32;
+
+/** Subpixel steps per pixel vertices are snapped to */
+static const int32 SubpixelSteps = 16;
+
+/** Pixels triangles may reach past the screen before they are clipped */
+static const float32 GuardPixels = 2048;
+
+/** Fewer triangles than this aren't worth a setup task of their own */
+static const uint MinChunkTriangles = 256;
+
+/** Setup tasks per thread, more than one evens out chunks that are slower to clip */
+static const uint ChunksPerThread = 4;
+
+/** Planes triangles are clipped against, near then the guard band's left, right, top and bottom */
+static const uint ClipPlaneCount = 5;
+
+/**
+ * @return how far inside a clip plane a vertex is, negative outside
+ */
+static float32 PlaneDistance(const SoftVertex& vertex, uint plane, float32 guardX, float32 guardY)
+{
+    const float32* p = vertex.Position;
+    switch (plane)
+    {
+    case 0: return p[2] + p[3];
+    case 1: return guardX * p[3] + p[0];
+    case 2: return guardX * p[3] - p[0];
+    case 3: return guardY * p[3] + p[1];
+    default: return guardY * p[3] - p[1];
+    }
+}
+
+SoftRasterizer::SoftRasterizer()
+    : mWidth(0),
+      mHeight(0),
+      mStride(0),
+      mTilesX(0),
+      mTilesY(0),
+      mGuardX(1),
+      mGuardY(1),
+      mColor(),
+      mDepth(),
+      mChunks(),
+      mBins(),
+      mChunkCount(0)
+{
+}
+
+void SoftRasterizer::Resize(uint width, uint height)
+{
+    mWidth = width;
+    mHeight = height;
+    mStride = (width + 3) & ~3u;
+    mTilesX = (width + TileSize - 1) / TileSize;
+    mTilesY = (height + TileSize - 1) / TileSize;
+
+    mColor.assign((uint64)mStride * height * 4, 0);
+    mDepth.assign((uint64)mStride * height, 1.0f);
+
+    // bins are laid out by tile count
+    mBins.clear();
+
+    if (width > 0 && height > 0)
+    {
+        mGuardX = 1 + 2 * GuardPixels / width;
+        mGuardY = 1 + 2 * GuardPixels / height;
+    }
+}
+
+void SoftRasterizer::Clear(const float32* color, bool depth)
+{
+    if (color)
+    {
+        uint8 rgba[4];
+        for (uint i = 0; i < 4; i++)
+        {
+            rgba[i] = (uint8)(min(max(color[i], 0.0f), 1.0f) * 255 + 0.5f);
+        }
+
+        for (uint64 i = 0; i < mColor.size(); i += 4)
+        {
+            copy(rgba, rgba + 4, &mColor[i]);
+        }
+    }
+
+    if (depth) fill(mDepth.begin(), mDepth.end(), 1.0f);
+}
+
+void SoftRasterizer::ReadPixels(vector<uint8>& refPixels) const
+{
+    refPixels.resize((uint64)mWidth * mHeight * 4);
+
+    for (uint y = 0; y < mHeight; y++)
+    {
+        const uint8* row = &mColor[(uint64)y * mStride * 4];
+        copy(row, row + mWidth * 4, &refPixels[(uint64)y * mWidth * 4]);
+    }
+}
+
+void SoftRasterizer::Run(uint count, const function<void(uint)>& task)
+{
+    Thread::ParallelFor(count, 1, [&](uint64 begin, uint64 end)
+    {
+        for (uint64 i = begin; i < end; i++) task(i);
+    });
+}
+
+void SoftRasterizer::DrawTriangles(const SoftVertex* vertices, const uint32* indices, uint triangleCount,
+        uint varyingCount, const SoftPixelShader& shader)
+{
+    if (triangleCount == 0 || mWidth == 0 || mHeight == 0) return;
+
+    const uint tileCount = mTilesX * mTilesY;
+
+    mChunkCount = (triangleCount + MinChunkTriangles - 1) / MinChunkTriangles;
+    mChunkCount = max(1u, min(mChunkCount, GetThreadCount() * ChunksPerThread));
+
+    if (mChunks.size() < mChunkCount) mChunks.resize(mChunkCount);
+    if (mBins.size() < (uint64)mChunkCount * tileCount) mBins.resize((uint64)mChunkCount * tileCount);
+
+    // each setup task only touches its own chunk and bins
+    Run(mChunkCount, [&](uint chunk)
+    {
+        uint begin = (uint64)triangleCount * chunk / mChunkCount;
+        uint end = (uint64)triangleCount * (chunk + 1) / mChunkCount;
+        SetupChunk(chunk, vertices, indices, begin, end, varyingCount);
+    });
+
+    Run(tileCount, [&](uint tile)
+    {
+        RasterizeTile(tile, shader, varyingCount);
+    });
+}
+
+void SoftRasterizer::SetupChunk(uint chunk, const SoftVertex* vertices, const uint32* indices, uint begin, uint end,
+        uint varyingCount)
+{
+    const uint tileCount = mTilesX * mTilesY;
+
+    mChunks[chunk].Triangles.clear();
+    mChunks[chunk].Clipped.clear();
+    for (uint tile = 0; tile < tileCount; tile++)
+    {
+        mBins[(uint64)chunk * tileCount + tile].clear();
+    }
+
+    for (uint t = begin; t < end; t++)
+    {
+        const SoftVertex* v[3];
+        for (uint k = 0; k < 3; k++)
+        {
+            v[k] = &vertices[indices ? indices[t * 3 + k] : t * 3 + k];
+        }
+
+        // skip triangles entirely outside one plane, only clip the ones crossing
+        bool clip = false;
+        bool outside = false;
+        for (uint plane = 0; plane < ClipPlaneCount && !outside; plane++)
+        {
+            uint out = 0;
+            for (uint k = 0; k < 3; k++)
+            {
+                if (PlaneDistance(*v[k], plane, mGuardX, mGuardY) < 0) out++;
+            }
+            outside = out == 3;
+            clip |= out > 0;
+        }
+
+        // past the far plane
+        if (v[0]->Position[2] > v[0]->Position[3] && v[1]->Position[2] > v[1]->Position[3]
+                && v[2]->Position[2] > v[2]->Position[3]) outside = true;
+
+        if (outside) continue;
+
+        if (clip)
+        {
+            ClipTriangle(v[0], v[1], v[2], varyingCount, chunk);
+        }
+        else
+        {
+            SetupTriangle(v[0], v[1], v[2], chunk);
+        }
+    }
+}
+
+void SoftRasterizer::ClipTriangle(const SoftVertex* a, const SoftVertex* b, const SoftVertex* c, uint varyingCount,
+        uint chunk)
+{
+    // every plane can add one vertex
+    const SoftVertex* polygons[2][ClipPlaneCount + 3] = { { a, b, c } };
+    uint count = 3;
+    uint current = 0;
+
+    deque<SoftVertex>& clipped = mChunks[chunk].Clipped;
+
+    for (uint plane = 0; plane < ClipPlaneCount; plane++)
+    {
+        const SoftVertex** in = polygons[current];
+        const SoftVertex** out = polygons[current ^ 1];
+        uint outCount = 0;
+
+        for (uint i = 0; i < count; i++)
+        {
+            const SoftVertex* from = in[i];
+            const SoftVertex* to = in[(i + 1) % count];
+            float32 fromDistance = PlaneDistance(*from, plane, mGuardX, mGuardY);
+            float32 toDistance = PlaneDistance(*to, plane, mGuardX, mGuardY);
+
+            if (fromDistance >= 0) out[outCount++] = from;
+
+            if ((fromDistance >= 0) != (toDistance >= 0))
+            {
+                float32 t = fromDistance / (fromDistance - toDistance);
+
+                SoftVertex vertex;
+                for (uint k = 0; k < 4; k++)
+                {
+                    vertex.Position[k] = from->Position[k] + (to->Position[k] - from->Position[k]) * t;
+                }
+                for (uint k = 0; k < varyingCount; k++)
+                {
+                    vertex.Varyings[k] = from->Varyings[k] + (to->Varyings[k] - from->Varyings[k]) * t;
+                }
+
+                clipped.push_back(vertex);
+                out[outCount++] = &clipped.back();
+            }
+        }
+
+        count = outCount;
+        current ^= 1;
+        if (count < 3) return;
+    }
+
+    const SoftVertex** polygon = polygons[current];
+    for (uint i = 1; i + 1 < count; i++)
+    {
+        SetupTriangle(polygon[0], polygon[i], polygon[i + 1], chunk);
+    }
+}
+
+void SoftRasterizer::SetupTriangle(const SoftVertex* a, const SoftVertex* b, const SoftVertex* c, uint chunk)
+{
+    Triangle triangle;
+    triangle.Vertices[0] = a;
+    triangle.Vertices[1] = b;
+    triangle.Vertices[2] = c;
+
+    // window coordinates, y down so the first row read back is the top one, depth from 0 to 1
+    float64 z[3];
+    int64 snappedX[3], snappedY[3];
+    for (uint k = 0; k < 3; k++)
+    {
+        const float32* p = triangle.Vertices[k]->Position;
+        triangle.InvW[k] = 1.0f / p[3];
+
+        float64 x = (p[0] * triangle.InvW[k] + 1) * 0.5 * mWidth;
+        float64 y = (1 - p[1] * triangle.InvW[k]) * 0.5 * mHeight;
+        z[k] = (p[2] * triangle.InvW[k] + 1) * 0.5;
+
+        snappedX[k] = (int64)floor(x * SubpixelSteps + 0.5);
+        snappedY[k] = (int64)floor(y * SubpixelSteps + 0.5);
+    }
+
+    int64 area = (snappedX[1] - snappedX[0]) * (snappedY[2] - snappedY[0])
+            - (snappedX[2] - snappedX[0]) * (snappedY[1] - snappedY[0]);
+    if (area == 0) return;
+
+    // nothing is culled, wind every triangle the same way so inside is always positive
+    if (area < 0)
+    {
+        swap(triangle.Vertices[1], triangle.Vertices[2]);
+        swap(triangle.InvW[1], triangle.InvW[2]);
+        swap(z[1], z[2]);
+        swap(snappedX[1], snappedX[2]);
+        swap(snappedY[1], snappedY[2]);
+        area = -area;
+    }
+
+    // edge k is across from vertex k, its function is that vertex's barycentric times area
+    for (uint k = 0; k < 3; k++)
+    {
+        uint from = (k + 1) % 3;
+        uint to = (k + 2) % 3;
+        int64 edgeA = snappedY[from] - snappedY[to];
+        int64 edgeB = snappedX[to] - snappedX[from];
+
+        // pixels exactly on an edge belong to the triangle on its right or below it
+        bool topLeft = edgeA > 0 || (edgeA == 0 && edgeB > 0);
+
+        triangle.A[k] = (int32)edgeA;
+        triangle.B[k] = (int32)edgeB;
+        triangle.C[k] = -edgeA * snappedX[from] - edgeB * snappedY[from] + (topLeft ? 1 : 0);
+    }
+
+    // barycentrics of vertices 1 and 2 at pixel positions, from the same snapped vertices as coverage
+    const float64 areaScale = (float64)SubpixelSteps / area;
+    for (uint k = 1; k < 3; k++)
+    {
+        uint from = (k + 1) % 3;
+        uint to = (k + 2) % 3;
+        float64 planeX = (snappedY[from] - snappedY[to]) * areaScale;
+        float64 planeY = (snappedX[to] - snappedX[from]) * areaScale;
+
+        triangle.Planes[k - 1][0] = (float32)planeX;
+        triangle.Planes[k - 1][1] = (float32)planeY;
+        triangle.Planes[k - 1][2] = (float32)(-(planeX * snappedX[from] + planeY * snappedY[from]) / SubpixelSteps);
+    }
+
+    for (uint k = 0; k < 3; k++)
+    {
+        triangle.Planes[2][k] = (float32)((z[1] - z[0]) * triangle.Planes[0][k] + (z[2] - z[0]) * triangle.Planes[1][k]);
+    }
+    triangle.Planes[2][2] += (float32)z[0];
+
+    int64 minX = min(snappedX[0], min(snappedX[1], snappedX[2]));
+    int64 maxX = max(snappedX[0], max(snappedX[1], snappedX[2]));
+    int64 minY = min(snappedY[0], min(snappedY[1], snappedY[2]));
+    int64 maxY = max(snappedY[0], max(snappedY[1], snappedY[2]));
+
+    triangle.MinX = (int32)max<int64>(0, minX / SubpixelSteps);
+    triangle.MinY = (int32)max<int64>(0, minY / SubpixelSteps);
+    triangle.MaxX = (int32)min<int64>(mWidth - 1, maxX / SubpixelSteps);
+    triangle.MaxY = (int32)min<int64>(mHeight - 1, maxY / SubpixelSteps);
+
+    if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY) return;
+
+    Chunk& refChunk = mChunks[chunk];
+    uint32 index = refChunk.Triangles.size();
+    refChunk.Triangles.push_back(triangle);
+
+    const uint tileCount = mTilesX * mTilesY;
+    for (int32 tileY = triangle.MinY / TileSize; tileY <= triangle.MaxY / TileSize; tileY++)
+    {
+        for (int32 tileX = triangle.MinX / TileSize; tileX <= triangle.MaxX / TileSize; tileX++)
+        {
+            mBins[(uint64)chunk * tileCount + tileY * mTilesX + tileX].push_back(index);
+        }
+    }
+}
+
+void SoftRasterizer::RasterizeTile(uint tile, const SoftPixelShader& shader, uint varyingCount)
+{
+    const uint tileCount = mTilesX * mTilesY;
+    int32 tileX = (tile % mTilesX) * TileSize;
+    int32 tileY = (tile / mTilesX) * TileSize;
+
+    // chunks hold consecutive triangles, so going through them in order keeps the draw order
+    for (uint chunk = 0; chunk < mChunkCount; chunk++)
+    {
+        const vector<Triangle>& triangles = mChunks[chunk].Triangles;
+        for (uint32 index : mBins[(uint64)chunk * tileCount + tile])
+        {
+            RasterizeTriangle(triangles[index], tileX, tileY, shader, varyingCount);
+        }
+    }
+}
+
+void SoftRasterizer::RasterizeTriangle(const Triangle& triangle, int32 tileX, int32 tileY,
+        const SoftPixelShader& shader, uint varyingCount)
+{
+    const int32 x0 = max(triangle.MinX, tileX);
+    const int32 y0 = max(triangle.MinY, tileY);
+    const int32 x1 = min(triangle.MaxX, tileX + TileSize - 1);
+    const int32 y1 = min(triangle.MaxY, tileY + TileSize - 1);
+    if (x0 > x1 || y0 > y1) return;
+
+    // edges the whole rectangle is inside of don't need testing, one it is all outside of skips the triangle
+    uint tested[3];
+    uint testedCount = 0;
+    for (uint k = 0; k < 3; k++)
+    {
+        int64 left = (int64)triangle.A[k] * (x0 * SubpixelSteps + SubpixelSteps / 2);
+        int64 right = (int64)triangle.A[k] * (x1 * SubpixelSteps + SubpixelSteps / 2);
+        int64 top = (int64)triangle.B[k] * (y0 * SubpixelSteps + SubpixelSteps / 2);
+        int64 bottom = (int64)triangle.B[k] * (y1 * SubpixelSteps + SubpixelSteps / 2);
+
+        int64 least = min(left, right) + min(top, bottom) + triangle.C[k];
+        int64 most = max(left, right) + max(top, bottom) + triangle.C[k];
+
+        if (most <= 0) return;
+        if (least <= 0) tested[testedCount++] = k;
+    }
+
+    // what's left crosses the rectangle, so its edge functions inside it fit in 32 bits
+    const int32 xStart = x0 & ~3;
+    int32 steps[3];
+    for (uint i = 0; i < testedCount; i++)
+    {
+        steps[i] = triangle.A[tested[i]] * SubpixelSteps;
+    }
+
+#ifdef SOFT_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i laneOffsets[3], quadSteps[3];
+    for (uint i = 0; i < testedCount; i++)
+    {
+        laneOffsets[i] = _mm_set_epi32(steps[i] * 3, steps[i] * 2, steps[i], 0);
+        quadSteps[i] = _mm_set1_epi32(steps[i] * 4);
+    }
+#endif
+
+    float32 varyings[SoftMaxVaryings];
+    float32 color[4];
+
+    for (int32 y = y0; y <= y1; y++)
+    {
+        const int64 sampleY = (int64)y * SubpixelSteps + SubpixelSteps / 2;
+        const int64 sampleX = (int64)xStart * SubpixelSteps + SubpixelSteps / 2;
+
+#ifdef SOFT_SSE2
+        __m128i edges[3];
+        for (uint i = 0; i < testedCount; i++)
+        {
+            uint k = tested[i];
+            int32 rowStart = (int32)(triangle.A[k] * sampleX + triangle.B[k] * sampleY + triangle.C[k]);
+            edges[i] = _mm_add_epi32(_mm_set1_epi32(rowStart), laneOffsets[i]);
+        }
+#else
+        int32 edges[3][4];
+        for (uint i = 0; i < testedCount; i++)
+        {
+            uint k = tested[i];
+            int32 rowStart = (int32)(triangle.A[k] * sampleX + triangle.B[k] * sampleY + triangle.C[k]);
+            for (uint lane = 0; lane < 4; lane++) edges[i][lane] = rowStart + steps[i] * lane;
+        }
+#endif
+
+        for (int32 x = xStart; x <= x1; x += 4)
+        {
+            uint mask = 0xF;
+            if (x < x0) mask &= ~((1u << (x0 - x)) - 1);
+            if (x + 3 > x1) mask &= (1u << (x1 - x + 1)) - 1;
+
+#ifdef SOFT_SSE2
+            __m128i inside = _mm_cmpeq_epi32(zero, zero);
+            for (uint i = 0; i < testedCount; i++)
+            {
+                inside = _mm_and_si128(inside, _mm_cmpgt_epi32(edges[i], zero));
+                edges[i] = _mm_add_epi32(edges[i], quadSteps[i]);
+            }
+            mask &= _mm_movemask_ps(_mm_castsi128_ps(inside));
+#else
+            for (uint i = 0; i < testedCount; i++)
+            {
+                for (uint lane = 0; lane < 4; lane++)
+                {
+                    if (edges[i][lane] <= 0) mask &= ~(1u << lane);
+                    edges[i][lane] += steps[i] * 4;
+                }
+            }
+#endif
+
+            for (uint lane = 0; mask; lane++, mask >>= 1)
+            {
+                if (!(mask & 1)) continue;
+
+                const float32 px = x + lane + 0.5f;
+                const float32 py = y + 0.5f;
+                const uint64 pixel = (uint64)y * mStride + x + lane;
+
+                float32 depth = triangle.Planes[2][0] * px + triangle.Planes[2][1] * py + triangle.Planes[2][2];
+                if (depth < 0 || depth > 1 || depth > mDepth[pixel]) continue;
+
+                // perspective correct weights
+                float32 b1 = triangle.Planes[0][0] * px + triangle.Planes[0][1] * py + triangle.Planes[0][2];
+                float32 b2 = triangle.Planes[1][0] * px + triangle.Planes[1][1] * py + triangle.Planes[1][2];
+                float32 w0 = (1 - b1 - b2) * triangle.InvW[0];
+                float32 w1 = b1 * triangle.InvW[1];
+                float32 w2 = b2 * triangle.InvW[2];
+                float32 scale = 1.0f / (w0 + w1 + w2);
+                w0 *= scale;
+                w1 *= scale;
+                w2 *= scale;
+
+                const float32* v0 = triangle.Vertices[0]->Varyings;
+                const float32* v1 = triangle.Vertices[1]->Varyings;
+                const float32* v2 = triangle.Vertices[2]->Varyings;
+                for (uint k = 0; k < varyingCount; k++)
+                {
+                    varyings[k] = v0[k] * w0 + v1[k] * w1 + v2[k] * w2;
+                }
+
+                shader.Shade(varyings, color);
+
+                uint8* target = &mColor[pixel * 4];
+                float32 alpha = min(max(color[3], 0.0f), 1.0f);
+                for (uint k = 0; k < 4; k++)
+                {
+                    float32 source = min(max(color[k], 0.0f), 1.0f);
+                    float32 blended = source * alpha + target[k] * (1.0f / 255) * (1 - alpha);
+                    target[k] = (uint8)(blended * 255 + 0.5f);
+                }
+
+                mDepth[pixel] = depth;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,186 @@
+#include "Soft/SoftShader.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <regex>
+#include <string.h>
+
+using namespace std;
+using namespace Core::Math;
+
+namespace Video
+{
+
+/**
+ * @return number of floats in a uniform of a GLSL type, 0 for types that can't be set
+ */
+static uint UniformSize(const string& type)
+{
+    if (type == "float" || type == "int" || type == "bool" || type == "sampler2D") return 1;
+    if (type == "vec2") return 2;
+    if (type == "vec3") return 3;
+    if (type == "vec4") return 4;
+    if (type == "mat3") return 9;
+    if (type == "mat4") return 16;
+    return 0;
+}
+
+/**
+ * Reads the numbers of an initializer like "vec3(-1, -0.5, -1)" or "2.0"
+ */
+static void ParseDefault(const string& initializer, uint size, float32* refValue)
+{
+    string::size_type open = initializer.find('(');
+    const char* next = initializer.c_str() + (open == string::npos ? 0 : open + 1);
+
+    vector<float32> numbers;
+    while (*next)
+    {
+        char* end;
+        float32 number = strtof(next, &end);
+        if (end == next)
+        {
+            next++;
+            continue;
+        }
+        numbers.push_back(number);
+        next = end;
+    }
+
+    // a single number fills a vector, like GLSL's vec3(1.0)
+    if (numbers.size() == 1 && size <= 4) numbers.assign(size, numbers[0]);
+    if (numbers.size() == size) copy(numbers.begin(), numbers.end(), refValue);
+}
+
+SoftShader::SoftShader(const string& vs, const string& fs)
+    : mVertexSource(vs),
+      mFragmentSource(fs),
+      mProgram(SoftProgram::Screen),
+      mInstanced(regex_search(vs, regex("attribute\\s+vec4\\s+aModel0\\s*;")))
+{
+    FindUniforms(vs);
+    FindUniforms(fs);
+
+    if (HasUniform("NormalMat") || mInstanced) mProgram = SoftProgram::Lit;
+}
+
+SoftShader::~SoftShader()
+{
+    Release();
+}
+
+void SoftShader::Release()
+{
+}
+
+void SoftShader::FindUniforms(const string& source)
+{
+    static const regex declaration("uniform\\s+(\\w+)\\s+(\\w+)\\s*(=\\s*[^;]*)?;");
+
+    for (sregex_iterator it(source.begin(), source.end(), declaration), end; it != end; ++it)
+    {
+        const smatch& match = *it;
+        string name = match[2];
+        uint size = UniformSize(match[1]);
+
+        // the vertex and fragment shaders share uniforms with the same name, like GL does
+        if (size == 0 || mUniformIndices.count(name)) continue;
+
+        Uniform u = { (uint)mUniformValues.size(), size };
+        mUniformValues.resize(u.Offset + size, 0);
+        if (match[3].matched) ParseDefault(match[3], size, &mUniformValues[u.Offset]);
+
+        mUniformIndices[name] = mUniforms.size();
+        mUniforms.push_back(u);
+    }
+}
+
+UniformHandle SoftShader::GetUniform(const string& name) const
+{
+    auto it = mUniformIndices.find(name);
+    return it == mUniformIndices.end() ? UniformHandle() : UniformHandle(it->second);
+}
+
+void SoftShader::SetMatrix4f(UniformHandle uniform, const Matrix4f& mat)
+{
+    SetUniform(uniform, 16, &mat[0][0]);
+}
+
+void SoftShader::SetMatrix3f(UniformHandle uniform, const Matrix3f& mat)
+{
+    SetUniform(uniform, 9, &mat[0][0]);
+}
+
+void SoftShader::SetVector4f(UniformHandle uniform, const Vector4f& vec)
+{
+    SetUniform(uniform, 4, &vec[0]);
+}
+
+void SoftShader::SetVector3f(UniformHandle uniform, const Vector3f& vec)
+{
+    SetUniform(uniform, 3, &vec[0]);
+}
+
+void SoftShader::SetVector2f(UniformHandle uniform, const Vector2f& vec)
+{
+    SetUniform(uniform, 2, &vec[0]);
+}
+
+void SoftShader::SetFloat32(UniformHandle uniform, float32 f)
+{
+    SetUniform(uniform, 1, &f);
+}
+
+void SoftShader::SetInt32(UniformHandle uniform, int32 i)
+{
+    float32 f = (float32)i;
+    SetUniform(uniform, 1, &f);
+}
+
+void SoftShader::SetUniform(UniformHandle uniform, uint size, const float32* value)
+{
+    if (!uniform.IsValid() || uniform.Index >= (int32)mUniforms.size()) return;
+
+    const Uniform& u = mUniforms[uniform.Index];
+    if (u.Size != size) return;
+
+    memcpy(&mUniformValues[u.Offset], value, size * 4);
+}
+
+const float32* SoftShader::GetValue(const string& name, uint size) const
+{
+    UniformHandle uniform = GetUniform(name);
+    if (!uniform.IsValid() || mUniforms[uniform.Index].Size != size) return nullptr;
+
+    return &mUniformValues[mUniforms[uniform.Index].Offset];
+}
+
+Matrix4f SoftShader::GetMatrix4f(const string& name) const
+{
+    Matrix4f mat;
+    const float32* value = GetValue(name, 16);
+    if (value) memcpy(&mat[0][0], value, 16 * 4);
+    return mat;
+}
+
+Matrix3f SoftShader::GetMatrix3f(const string& name) const
+{
+    Matrix3f mat;
+    const float32* value = GetValue(name, 9);
+    if (value) memcpy(&mat[0][0], value, 9 * 4);
+    return mat;
+}
+
+Vector3f SoftShader::GetVector3f(const string& name) const
+{
+    const float32* value = GetValue(name, 3);
+    return value ? Vector3f(value[0], value[1], value[2]) : Vector3f(0);
+}
+
+int32 SoftShader::GetInt32(const string& name) const
+{
+    const float32* value = GetValue(name, 1);
+    return value ? (int32)value[0] : 0;
+}
+
+}
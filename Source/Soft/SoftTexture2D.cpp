@@ -0,0 +1,85 @@
+#include "Soft/SoftTexture2D.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace Video
+{
+
+SoftTexture2D::SoftTexture2D(uint width, uint height)
+    : mWidth(width),
+      mHeight(height),
+      mPixels((uint64)width * height * 4, 0)
+{
+}
+
+SoftTexture2D::~SoftTexture2D()
+{
+    Release();
+}
+
+void SoftTexture2D::Release()
+{
+    vector<uint8>().swap(mPixels);
+    mWidth = mHeight = 0;
+}
+
+void SoftTexture2D::GetData(uint8* out, uint x, uint y, uint w, uint h) const
+{
+    if (x + w > mWidth || y + h > mHeight) return;
+
+    for (uint row = 0; row < h; row++)
+    {
+        const uint8* src = &mPixels[((uint64)(y + row) * mWidth + x) * 4];
+        copy(src, src + w * 4, out + (uint64)row * w * 4);
+    }
+}
+
+void SoftTexture2D::SetData(const uint8* in, uint x, uint y, uint w, uint h)
+{
+    if (x + w > mWidth || y + h > mHeight) return;
+
+    for (uint row = 0; row < h; row++)
+    {
+        const uint8* src = in + (uint64)row * w * 4;
+        copy(src, src + w * 4, &mPixels[((uint64)(y + row) * mWidth + x) * 4]);
+    }
+}
+
+void SoftTexture2D::Sample(float32 u, float32 v, float32* refColor) const
+{
+    if (mPixels.empty())
+    {
+        refColor[0] = refColor[1] = refColor[2] = 0;
+        refColor[3] = 1;
+        return;
+    }
+
+    float32 x = u * mWidth - 0.5f;
+    float32 y = v * mHeight - 0.5f;
+    float32 fx = floor(x);
+    float32 fy = floor(y);
+    float32 tx = x - fx;
+    float32 ty = y - fy;
+
+    int32 x0 = min(max((int32)fx, 0), (int32)mWidth - 1);
+    int32 x1 = min(max((int32)fx + 1, 0), (int32)mWidth - 1);
+    int32 y0 = min(max((int32)fy, 0), (int32)mHeight - 1);
+    int32 y1 = min(max((int32)fy + 1, 0), (int32)mHeight - 1);
+
+    const uint8* p00 = &mPixels[((uint64)y0 * mWidth + x0) * 4];
+    const uint8* p10 = &mPixels[((uint64)y0 * mWidth + x1) * 4];
+    const uint8* p01 = &mPixels[((uint64)y1 * mWidth + x0) * 4];
+    const uint8* p11 = &mPixels[((uint64)y1 * mWidth + x1) * 4];
+
+    for (uint i = 0; i < 4; i++)
+    {
+        float32 top = p00[i] + (p10[i] - p00[i]) * tx;
+        float32 bottom = p01[i] + (p11[i] - p01[i]) * tx;
+        refColor[i] = (top + (bottom - top) * ty) * (1.0f / 255);
+    }
+}
+
+}
@@ -0,0 +1,40 @@
+#include "Soft/SoftVertexBuffer.h"
+
+#include "IVertexBuffer.h"
+#include "Types.h"
+
+namespace Video
+{
+
+SoftVertexBuffer::SoftVertexBuffer(VertexFormat format, uint length)
+    : mFormat(format),
+      mLength(length),
+      mBuffer((uint64)length * format.GetSizeInBytes())
+{
+}
+
+SoftVertexBuffer::~SoftVertexBuffer()
+{
+    Release();
+}
+
+void SoftVertexBuffer::Release()
+{
+    mBuffer.Release();
+}
+
+void SoftVertexBuffer::GetData(float32* out, uint start, uint count) const
+{
+    uint64 index = (uint64)start * mFormat.GetSizeInBytes();
+    uint64 size = (uint64)count * mFormat.GetSizeInBytes();
+    mBuffer.Read(index, out, size);
+}
+
+void SoftVertexBuffer::SetData(const float32* in, uint start, uint count)
+{
+    uint64 index = (uint64)start * mFormat.GetSizeInBytes();
+    uint64 size = (uint64)count * mFormat.GetSizeInBytes();
+    mBuffer.Write(index, in, size);
+}
+
+}
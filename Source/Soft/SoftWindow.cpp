@@ -0,0 +1,35 @@
+#include "Soft/SoftWindow.h"
+
+#include <string>
+
+#include "GUI/AllWidgets.h"
+#include "SDL2/SdlMouse.h"
+
+using namespace std;
+
+namespace Core
+{
+
+SoftWindow::SoftWindow(const string& title, uint width, uint height)
+    : mTitle(title),
+      mWidth(width),
+      mHeight(height),
+      mVisible(false),
+      mMouse(new SdlMouse()),
+      mEnv(new Gui::Environment(width, height))
+{
+}
+
+SoftWindow::~SoftWindow()
+{
+    delete mEnv;
+    delete mMouse;
+}
+
+void SoftWindow::SetSize(uint width, uint height)
+{
+    mWidth = width;
+    mHeight = height;
+}
+
+}
@@ -1,20 +1,347 @@
 #include "ThreadUtil.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #ifdef _WIN32
 #include <windows.h>
 #else // UNIX
 #include <chrono>
-#include <thread>
 #endif
 
+#include "Profiler.h"
 #include "Types.h"
 
+using namespace std;
+
 namespace Core
 {
 
 namespace Thread
 {
 
+/** Ranges ParallelFor splits its count into per thread, more than one evens out uneven ranges */
+static const uint64 RangesPerThread = 4;
+
+struct Job
+{
+    function<void()> Task;
+    /** Dependencies still running, plus one until the job is fully set up */
+    atomic<uint> Pending;
+    /** Set once the job is in a queue, its dependencies are done */
+    atomic<bool> Queued;
+    /** Set by the thread that runs the job, the copy left in a queue is skipped */
+    atomic<bool> Started;
+    atomic<bool> Done;
+    bool MainThread;
+    /** Guards Done changing and Continuations */
+    mutex Mutex;
+    /** Jobs waiting on this one */
+    vector<JobHandle> Continuations;
+};
+
+/**
+ * Worker threads with their job queues, see Run
+ */
+class Scheduler
+{
+public:
+    Scheduler();
+
+    /**
+     * Stops the workers, jobs that are still queued never run
+     */
+    ~Scheduler();
+
+    uint GetWorkerCount() const { return mWorkers.size(); }
+
+    JobHandle Create(const function<void()>& task, const vector<JobHandle>& dependencies, bool mainThread);
+    void RunMainThreadJobs();
+    void SetMainThreadWakeUp(const function<void()>& wakeUp);
+    void Wait(const JobHandle& job);
+private:
+    struct Worker
+    {
+        mutex Mutex;
+        deque<JobHandle> Jobs;
+        thread WorkerThread;
+    };
+
+    void Submit(const JobHandle& job);
+    void Execute(const JobHandle& job);
+    bool TryPop(deque<JobHandle>& jobs, mutex& jobsMutex, bool newest, JobHandle& refJob);
+    bool RunOne();
+    void WorkerMain(uint index);
+
+    vector<unique_ptr<Worker>> mWorkers;
+
+    /** Jobs queued from threads that aren't workers */
+    mutex mSharedMutex;
+    deque<JobHandle> mShared;
+
+    mutex mMainMutex;
+    vector<JobHandle> mMainJobs;
+    function<void()> mMainWakeUp;
+
+    /** Jobs in the worker and shared queues, can dip below zero while a job is being queued */
+    atomic<int64> mQueued;
+    /** Guards sleeping on the condition variables against missing a wake up */
+    mutex mSleepMutex;
+    condition_variable mWork;
+    condition_variable mFinished;
+    uint mWaiters;
+    bool mQuit;
+};
+
+/** Index of the worker the current thread is, -1 for any other thread */
+static thread_local int32 sWorkerIndex = -1;
+
+static Scheduler& GetScheduler()
+{
+    static Scheduler scheduler;
+    return scheduler;
+}
+
+Scheduler::Scheduler()
+    : mWorkers(),
+      mShared(),
+      mMainJobs(),
+      mMainWakeUp(),
+      mQueued(0),
+      mWaiters(0),
+      mQuit(false)
+{
+    uint workerCount = max(2u, thread::hardware_concurrency()) - 1;
+
+    // every queue has to exist before a worker can steal from it
+    for (uint i = 0; i < workerCount; i++)
+    {
+        mWorkers.push_back(unique_ptr<Worker>(new Worker()));
+    }
+    for (uint i = 0; i < workerCount; i++)
+    {
+        mWorkers[i]->WorkerThread = thread(&Scheduler::WorkerMain, this, i);
+    }
+}
+
+Scheduler::~Scheduler()
+{
+    {
+        lock_guard<mutex> lock(mSleepMutex);
+        mQuit = true;
+    }
+    mWork.notify_all();
+
+    for (unique_ptr<Worker>& worker : mWorkers)
+    {
+        worker->WorkerThread.join();
+    }
+}
+
+JobHandle Scheduler::Create(const function<void()>& task, const vector<JobHandle>& dependencies, bool mainThread)
+{
+    JobHandle job = make_shared<Job>();
+    job->Task = task;
+    job->Pending = dependencies.size() + 1;
+    job->Queued = false;
+    job->Started = false;
+    job->Done = false;
+    job->MainThread = mainThread;
+
+    for (const JobHandle& dependency : dependencies)
+    {
+        bool done = true;
+        if (dependency)
+        {
+            lock_guard<mutex> lock(dependency->Mutex);
+            done = dependency->Done;
+            if (!done) dependency->Continuations.push_back(job);
+        }
+        if (done) job->Pending--;
+    }
+
+    if (--job->Pending == 0) Submit(job);
+    return job;
+}
+
+void Scheduler::Submit(const JobHandle& job)
+{
+    if (job->MainThread)
+    {
+        function<void()> wakeUp;
+        {
+            lock_guard<mutex> lock(mMainMutex);
+            mMainJobs.push_back(job);
+            wakeUp = mMainWakeUp;
+        }
+        if (wakeUp) wakeUp();
+        return;
+    }
+
+    job->Queued = true;
+
+    if (sWorkerIndex >= 0)
+    {
+        Worker& worker = *mWorkers[sWorkerIndex];
+        lock_guard<mutex> lock(worker.Mutex);
+        worker.Jobs.push_back(job);
+    }
+    else
+    {
+        lock_guard<mutex> lock(mSharedMutex);
+        mShared.push_back(job);
+    }
+    mQueued++;
+
+    bool waiters;
+    {
+        lock_guard<mutex> lock(mSleepMutex);
+        waiters = mWaiters > 0;
+    }
+    mWork.notify_one();
+    if (waiters) mFinished.notify_all();
+}
+
+void Scheduler::Execute(const JobHandle& job)
+{
+    {
+        PROFILE_ZONE("Job");
+        job->Task();
+    }
+    job->Task = nullptr;
+
+    vector<JobHandle> continuations;
+    {
+        lock_guard<mutex> lock(job->Mutex);
+        job->Done = true;
+        continuations.swap(job->Continuations);
+    }
+
+    for (const JobHandle& continuation : continuations)
+    {
+        if (--continuation->Pending == 0) Submit(continuation);
+    }
+
+    bool waiters;
+    {
+        lock_guard<mutex> lock(mSleepMutex);
+        waiters = mWaiters > 0;
+    }
+    if (waiters) mFinished.notify_all();
+}
+
+bool Scheduler::TryPop(deque<JobHandle>& jobs, mutex& jobsMutex, bool newest, JobHandle& refJob)
+{
+    lock_guard<mutex> lock(jobsMutex);
+
+    // jobs a waiting thread already ran are dropped on the way
+    while (!jobs.empty())
+    {
+        if (newest)
+        {
+            refJob = std::move(jobs.back());
+            jobs.pop_back();
+        }
+        else
+        {
+            refJob = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        mQueued--;
+
+        if (!refJob->Started.exchange(true)) return true;
+    }
+
+    refJob = nullptr;
+    return false;
+}
+
+bool Scheduler::RunOne()
+{
+    const uint workerCount = mWorkers.size();
+    const int32 self = sWorkerIndex;
+
+    JobHandle job;
+    bool found = self >= 0 && TryPop(mWorkers[self]->Jobs, mWorkers[self]->Mutex, true, job);
+
+    if (!found) found = TryPop(mShared, mSharedMutex, false, job);
+
+    // steal the oldest job, the one most likely to be a big piece of work
+    uint first = self >= 0 ? self + 1 : 0;
+    for (uint i = 0; !found && i < workerCount; i++)
+    {
+        uint victim = (first + i) % workerCount;
+        if ((int32)victim == self) continue;
+        found = TryPop(mWorkers[victim]->Jobs, mWorkers[victim]->Mutex, false, job);
+    }
+
+    if (!found) return false;
+
+    Execute(job);
+    return true;
+}
+
+void Scheduler::WorkerMain(uint index)
+{
+    sWorkerIndex = index;
+    Profiler::SetThreadName("Worker " + to_string(index + 1));
+
+    while (true)
+    {
+        if (RunOne()) continue;
+
+        unique_lock<mutex> lock(mSleepMutex);
+        mWork.wait(lock, [this] { return mQuit || mQueued > 0; });
+        if (mQuit) return;
+    }
+}
+
+void Scheduler::RunMainThreadJobs()
+{
+    vector<JobHandle> jobs;
+    {
+        lock_guard<mutex> lock(mMainMutex);
+        jobs.swap(mMainJobs);
+    }
+
+    // main thread jobs queued by these run on the next call
+    for (const JobHandle& job : jobs)
+    {
+        Execute(job);
+    }
+}
+
+void Scheduler::SetMainThreadWakeUp(const function<void()>& wakeUp)
+{
+    lock_guard<mutex> lock(mMainMutex);
+    mMainWakeUp = wakeUp;
+}
+
+void Scheduler::Wait(const JobHandle& job)
+{
+    while (!job->Done)
+    {
+        // only the job itself is run here, any other job could be a long one that keeps the
+        // waiting thread, often the main thread, from getting back to its own work
+        if (job->Queued && !job->Started.exchange(true))
+        {
+            Execute(job);
+            continue;
+        }
+
+        unique_lock<mutex> lock(mSleepMutex);
+        mWaiters++;
+        mFinished.wait(lock, [&] { return job->Done || (job->Queued && !job->Started); });
+        mWaiters--;
+    }
+}
+
 void Sleep(uint64 millis)
 {
 #ifdef _WIN32
@@ -24,6 +351,87 @@ void Sleep(uint64 millis)
 #endif
 }
 
+JobHandle Run(const function<void()>& task)
+{
+    return GetScheduler().Create(task, vector<JobHandle>(), false);
+}
+
+JobHandle Run(const function<void()>& task, const vector<JobHandle>& dependencies)
+{
+    return GetScheduler().Create(task, dependencies, false);
+}
+
+JobHandle RunOnMainThread(const function<void()>& task)
+{
+    return GetScheduler().Create(task, vector<JobHandle>(), true);
+}
+
+JobHandle RunOnMainThread(const function<void()>& task, const vector<JobHandle>& dependencies)
+{
+    return GetScheduler().Create(task, dependencies, true);
+}
+
+void RunMainThreadJobs()
+{
+    GetScheduler().RunMainThreadJobs();
+}
+
+void SetMainThreadWakeUp(const function<void()>& wakeUp)
+{
+    GetScheduler().SetMainThreadWakeUp(wakeUp);
+}
+
+void Wait(const JobHandle& job)
+{
+    if (job) GetScheduler().Wait(job);
+}
+
+bool IsDone(const JobHandle& job)
+{
+    return !job || job->Done;
+}
+
+uint GetWorkerCount()
+{
+    return GetScheduler().GetWorkerCount();
+}
+
+void ParallelFor(uint64 count, uint64 minRange, const function<void(uint64, uint64)>& body)
+{
+    if (count == 0) return;
+
+    const uint64 threadCount = GetWorkerCount() + 1;
+    const uint64 rangeCount = max<uint64>(1, min(threadCount * RangesPerThread, count / max<uint64>(1, minRange)));
+
+    if (rangeCount == 1)
+    {
+        body(0, count);
+        return;
+    }
+
+    // helpers take the next range until there are none left, so no range waits on a busy thread
+    atomic<uint64> next(0);
+    function<void()> runRanges = [&]
+    {
+        for (uint64 i = next++; i < rangeCount; i = next++)
+        {
+            body(count * i / rangeCount, count * (i + 1) / rangeCount);
+        }
+    };
+
+    vector<JobHandle> helpers;
+    for (uint64 i = 1; i < min(threadCount, rangeCount); i++)
+    {
+        helpers.push_back(Run(runRanges));
+    }
+    runRanges();
+
+    for (const JobHandle& helper : helpers)
+    {
+        Wait(helper);
+    }
+}
+
 }
 
 }
@@ -10,16 +10,21 @@ namespace Core
 namespace Time
 {
 
-uint64 Millis()
+static const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+
+uint64 Nanos()
 {
-    return std::chrono::system_clock::now().time_since_epoch() / std::chrono::milliseconds(1L);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - StartTime).count();
 }
 
-static const uint64 StartTime = Millis();
+uint64 Millis()
+{
+    return Nanos() / 1000000;
+}
 
 float64 Seconds()
 {
-    return (Millis() - StartTime) / 1000.0;
+    return ToSeconds(Nanos());
 }
 
 }
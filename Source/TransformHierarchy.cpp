@@ -0,0 +1,325 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+#include "ThreadUtil.h"
+#include "Types.h"
+
+using namespace std;
+using namespace Core::Math;
+
+namespace Core
+{
+
+/** Fewest nodes of one level worth giving their own thread */
+static const uint64 MinRange = 1 << 13;
+
+const TransformHierarchy::NodeId TransformHierarchy::None;
+const uint32 TransformHierarchy::NoSlot;
+
+/**
+ * Moves every item to its new slot, items whose new slot is NoSlot are dropped
+ */
+template <typename Item>
+static void Permute(vector<Item>& refItems, const vector<uint32>& newSlots, uint32 newCount, uint32 noSlot)
+{
+    vector<Item> sorted(newCount);
+    for (uint32 slot = 0; slot < refItems.size(); slot++)
+    {
+        if (newSlots[slot] != noSlot) sorted[newSlots[slot]] = refItems[slot];
+    }
+    refItems.swap(sorted);
+}
+
+/**
+ * @return translation * rotation * scale, built directly in float32 instead of multiplying the
+ *         three matrices Quaternionf::ToRotation and Matrix4f make
+ */
+static Matrix4f ComposeLocal(const Vector3f& position, const Quaternionf& rotation, const Vector3f& scale)
+{
+    const float32 x = rotation.X, y = rotation.Y, z = rotation.Z, w = rotation.W;
+    const float32 xx = 2 * x * x, yy = 2 * y * y, zz = 2 * z * z;
+    const float32 xy = 2 * x * y, xz = 2 * x * z, yz = 2 * y * z;
+    const float32 xw = 2 * x * w, yw = 2 * y * w, zw = 2 * z * w;
+
+    return Matrix4f(Vector4f((1 - yy - zz) * scale.X, (xy + zw) * scale.X, (xz - yw) * scale.X, 0),
+            Vector4f((xy - zw) * scale.Y, (1 - xx - zz) * scale.Y, (yz + xw) * scale.Y, 0),
+            Vector4f((xz + yw) * scale.Z, (yz - xw) * scale.Z, (1 - xx - yy) * scale.Z, 0),
+            Vector4f(position.X, position.Y, position.Z, 1));
+}
+
+TransformHierarchy::TransformHierarchy()
+    : mIds(),
+      mParents(),
+      mPositions(),
+      mRotations(),
+      mScales(),
+      mWorlds(),
+      mDirty(),
+      mSlots(),
+      mFreeIds(),
+      mLevelStarts(),
+      mRemovedCount(0),
+      mUnsorted(false),
+      mAnyDirty(false)
+{
+}
+
+TransformHierarchy::NodeId TransformHierarchy::Add(NodeId parent)
+{
+    NodeId node;
+    if (mFreeIds.empty())
+    {
+        node = mSlots.size();
+        mSlots.push_back(NoSlot);
+    }
+    else
+    {
+        node = mFreeIds.back();
+        mFreeIds.pop_back();
+    }
+
+    // appended at the end until the next Sort puts it after its parent's level
+    uint32 slot = mIds.size();
+    mSlots[node] = slot;
+    mIds.push_back(node);
+    mParents.push_back(IsValid(parent) ? mSlots[parent] : NoSlot);
+    mPositions.push_back(Vector3f(0));
+    mRotations.push_back(Quaternionf());
+    mScales.push_back(Vector3f(1));
+    mWorlds.push_back(Matrix4f());
+    mDirty.push_back(0);
+
+    MakeDirty(slot);
+    mUnsorted = true;
+    return node;
+}
+
+void TransformHierarchy::Remove(NodeId node)
+{
+    if (!IsValid(node)) return;
+
+    // parents have to come first for one pass to find every node below
+    if (mUnsorted) Sort();
+
+    const uint32 first = mSlots[node];
+    vector<uint8> removed(mIds.size() - first, 0);
+    removed[0] = 1;
+    for (uint32 slot = first + 1; slot < mIds.size(); slot++)
+    {
+        uint32 parent = mParents[slot];
+        removed[slot - first] = parent != NoSlot && parent >= first && removed[parent - first];
+    }
+
+    for (uint32 slot = first; slot < mIds.size(); slot++)
+    {
+        if (!removed[slot - first]) continue;
+
+        mSlots[mIds[slot]] = NoSlot;
+        mFreeIds.push_back(mIds[slot]);
+        mIds[slot] = None;
+        mParents[slot] = NoSlot;
+        mDirty[slot] = 0;
+        mRemovedCount++;
+    }
+    mUnsorted = true;
+}
+
+bool TransformHierarchy::IsValid(NodeId node) const
+{
+    return node < mSlots.size() && mSlots[node] != NoSlot;
+}
+
+bool TransformHierarchy::SetParent(NodeId node, NodeId parent)
+{
+    if (!IsValid(node)) return false;
+
+    const uint32 slot = mSlots[node];
+    const uint32 parentSlot = IsValid(parent) ? mSlots[parent] : NoSlot;
+
+    for (uint32 above = parentSlot; above != NoSlot; above = mParents[above])
+    {
+        if (above == slot) return false;
+    }
+
+    mParents[slot] = parentSlot;
+    MakeDirty(slot);
+    mUnsorted = true;
+    return true;
+}
+
+TransformHierarchy::NodeId TransformHierarchy::GetParent(NodeId node) const
+{
+    if (!IsValid(node)) return None;
+
+    uint32 parent = mParents[mSlots[node]];
+    return parent == NoSlot ? None : mIds[parent];
+}
+
+void TransformHierarchy::SetPosition(NodeId node, const Vector3f& position)
+{
+    if (!IsValid(node)) return;
+
+    mPositions[mSlots[node]] = position;
+    MakeDirty(mSlots[node]);
+}
+
+void TransformHierarchy::SetRotation(NodeId node, const Quaternionf& rotation)
+{
+    if (!IsValid(node)) return;
+
+    mRotations[mSlots[node]] = Normalize(rotation);
+    MakeDirty(mSlots[node]);
+}
+
+void TransformHierarchy::SetScale(NodeId node, const Vector3f& scale)
+{
+    if (!IsValid(node)) return;
+
+    mScales[mSlots[node]] = scale;
+    MakeDirty(mSlots[node]);
+}
+
+Matrix4f TransformHierarchy::GetLocalMatrix(NodeId node) const
+{
+    if (!IsValid(node)) return Matrix4f();
+
+    const uint32 slot = mSlots[node];
+    return ComposeLocal(mPositions[slot], mRotations[slot], mScales[slot]);
+}
+
+void TransformHierarchy::MakeDirty(uint32 slot)
+{
+    mDirty[slot] = 1;
+    mAnyDirty = true;
+}
+
+void TransformHierarchy::Update()
+{
+    PROFILE_ZONE("TransformHierarchy::Update");
+
+    if (mUnsorted) Sort();
+    if (!mAnyDirty) return;
+
+    // parents come before their children, so dirtiness reaches the bottom of the tree in one pass
+    const uint32 slotCount = mIds.size();
+    for (uint32 slot = 0; slot < slotCount; slot++)
+    {
+        uint32 parent = mParents[slot];
+        if (parent != NoSlot && mDirty[parent]) mDirty[slot] = 1;
+    }
+
+    for (uint level = 0; level + 1 < mLevelStarts.size(); level++)
+    {
+        const uint32 begin = mLevelStarts[level];
+        Thread::ParallelFor(mLevelStarts[level + 1] - begin, MinRange, [&](uint64 first, uint64 last)
+        {
+            for (uint32 slot = begin + first; slot < begin + last; slot++)
+            {
+                if (!mDirty[slot]) continue;
+                mDirty[slot] = 0;
+
+                Matrix4f local = ComposeLocal(mPositions[slot], mRotations[slot], mScales[slot]);
+                uint32 parent = mParents[slot];
+                if (parent == NoSlot)
+                {
+                    mWorlds[slot] = local;
+                    continue;
+                }
+#ifdef CORE_MATH_SIMD
+                // both are affine, so the parent's last column only adds to the translation
+                const Vector4f* p = mWorlds[parent].mMatrix;
+                const Simd::Float4 p0 = Simd::Load(&p[0].X);
+                const Simd::Float4 p1 = Simd::Load(&p[1].X);
+                const Simd::Float4 p2 = Simd::Load(&p[2].X);
+                Vector4f* world = mWorlds[slot].mMatrix;
+                for (uint c = 0; c < 4; c++)
+                {
+                    Simd::Float4 column = Simd::Mul(p0, Simd::Splat(local[c].X));
+                    column = Simd::Add(column, Simd::Mul(p1, Simd::Splat(local[c].Y)));
+                    column = Simd::Add(column, Simd::Mul(p2, Simd::Splat(local[c].Z)));
+                    if (c == 3) column = Simd::Add(column, Simd::Load(&p[3].X));
+                    Simd::Store(&world[c].X, column);
+                }
+#else
+                mWorlds[slot] = mWorlds[parent] * local;
+#endif
+            }
+        });
+    }
+
+    mAnyDirty = false;
+}
+
+void TransformHierarchy::Sort()
+{
+    const uint32 slotCount = mIds.size();
+
+    // depth of every node, found by walking up to the nearest node whose depth is known
+    vector<uint32> depths(slotCount, NoSlot);
+    vector<uint32> path;
+    uint32 levelCount = 0;
+    for (uint32 slot = 0; slot < slotCount; slot++)
+    {
+        if (mIds[slot] == None || depths[slot] != NoSlot) continue;
+
+        uint32 top = slot;
+        while (depths[top] == NoSlot && mParents[top] != NoSlot)
+        {
+            path.push_back(top);
+            top = mParents[top];
+        }
+        if (depths[top] == NoSlot) depths[top] = 0;
+
+        uint32 depth = depths[top];
+        while (!path.empty())
+        {
+            depths[path.back()] = ++depth;
+            path.pop_back();
+        }
+        levelCount = max(levelCount, depth + 1);
+    }
+
+    // counting sort by depth, nodes keep their order within a level
+    mLevelStarts.assign(levelCount + 1, 0);
+    for (uint32 slot = 0; slot < slotCount; slot++)
+    {
+        if (mIds[slot] != None) mLevelStarts[depths[slot] + 1]++;
+    }
+    for (uint32 level = 0; level < levelCount; level++)
+    {
+        mLevelStarts[level + 1] += mLevelStarts[level];
+    }
+
+    vector<uint32> cursors(mLevelStarts.begin(), mLevelStarts.end() - 1);
+    vector<uint32> newSlots(slotCount, NoSlot);
+    for (uint32 slot = 0; slot < slotCount; slot++)
+    {
+        if (mIds[slot] != None) newSlots[slot] = cursors[depths[slot]]++;
+    }
+
+    for (uint32 slot = 0; slot < slotCount; slot++)
+    {
+        if (mParents[slot] != NoSlot) mParents[slot] = newSlots[mParents[slot]];
+    }
+
+    const uint32 newCount = slotCount - mRemovedCount;
+    Permute(mIds, newSlots, newCount, NoSlot);
+    Permute(mParents, newSlots, newCount, NoSlot);
+    Permute(mPositions, newSlots, newCount, NoSlot);
+    Permute(mRotations, newSlots, newCount, NoSlot);
+    Permute(mScales, newSlots, newCount, NoSlot);
+    Permute(mWorlds, newSlots, newCount, NoSlot);
+    Permute(mDirty, newSlots, newCount, NoSlot);
+
+    for (uint32 slot = 0; slot < newCount; slot++)
+    {
+        mSlots[mIds[slot]] = slot;
+    }
+
+    mRemovedCount = 0;
+    mUnsorted = false;
+}
+
+}
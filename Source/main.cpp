@@ -1,12 +1,18 @@
 #include <SDL2/Sdl2Backend.h>
 #include <SDL2/Sdl2Window.h>
+#include <EGL/EglBackend.h>
+#include <Soft/SoftBackend.h>
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 #include "../Include/Boost.h"
 #include "Application.h"
 #include "IBackend.h"
 #include "Modeler3D.h"
+#include "Profiler.h"
 #include "Types.h"
 
 #include "Math/ModelerMath.h"
@@ -14,18 +20,93 @@
 using namespace Core;
 using namespace std;
 
+static void PrintUsage()
+{
+	cout << "Usage: Modeler3D [--headless | --software] [--frames N] [--screenshot file.png] [--profile file.json] [model.obj]" << endl;
+	cout << "  --headless           render offscreen without a display, needs --frames" << endl;
+	cout << "  --software           render offscreen on the CPU without OpenGL, needs --frames" << endl;
+	cout << "  --frames N           render N frames as fast as possible once the model is loaded, then exit" << endl;
+	cout << "  --screenshot file    save the last frame as a PNG, needs --frames" << endl;
+	cout << "  --profile file       record a timeline of the run, open it in chrome://tracing or ui.perfetto.dev" << endl;
+}
+
 int main(int argc, char** argv)
 {
+	bool headless = false;
+	bool software = false;
+	uint32 frames = 0;
+	string screenshot;
+	string profile;
+	string model;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--headless") == 0) headless = true;
+		else if(strcmp(argv[i], "--software") == 0) software = true;
+		else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frames = strtoul(argv[++i], nullptr, 10);
+		else if(strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc) screenshot = argv[++i];
+		else if(strcmp(argv[i], "--profile") == 0 && i + 1 < argc) profile = argv[++i];
+		else if(argv[i][0] != '-') model = argv[i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	//a headless run has no window to close, it has to stop by itself, and the screenshot
+	//is taken when the last frame is done
+	if((headless || software || !screenshot.empty()) && frames == 0)
+	{
+		PrintUsage();
+		return 1;
+	}
+
 	cout << "Starting Modeler3D" << endl;
 
-	IBackend* backend = new Sdl2Backend();
+	if(!profile.empty()) Profiler::Start();
+
+	IBackend* backend;
+	if(software)
+	{
+		backend = new SoftBackend();
+	}
+	else if(headless)
+	{
+		EglBackend* eglBackend = new EglBackend();
+		if(!eglBackend->IsValid())
+		{
+			delete eglBackend;
+			return 1;
+		}
+		backend = eglBackend;
+	}
+	else
+	{
+		backend = new Sdl2Backend();
+	}
 
-	Modeler3D app(backend);
-	app.Start();
+	int result = 0;
+	{
+		Modeler3D app(backend);
+		app.SetFrameLimit(frames);
+		app.SetScreenshot(screenshot);
+		if(!model.empty()) app.LoadObj(model);
+		app.Start();
+
+		if(!screenshot.empty() && !app.IsScreenshotSaved()) result = 1;
+	}
 
 	delete backend;
 
+	if(!profile.empty())
+	{
+		Profiler::Stop();
+		cout << "Writing " << Profiler::GetEventCount() << " profiler events to " << profile << endl;
+		if(!Profiler::Export(profile)) result = 1;
+	}
+
 	cout << "Exiting Modeler3D" << endl;
 
-	return 0;
+	return result;
 }
@@ -1106,4 +1106,122 @@ TEST_CASE( "Transform methods work correctly with float", "[math][transform]" )
 	}
 }
 
+//************************* Frustum *************************
+TEST_CASE( "Frustum culls spheres outside the view", "[math][frustum]" ) {
+	using namespace Core;
+
+	Math::Matrix4f projection = Math::Matrix4f::ToPerspective(Math::ToRadians(90.0f), 1.0f, 1.0f, 100.0f);
+	Math::Matrix4f view = Math::Matrix4f::ToLookAt(Math::Vector3f(0, 0, 10), Math::Vector3f(0, 0, 0));
+	Math::Frustumf frustum(projection * view);
+
+	//every plane is normalized
+	for(uint i = 0; i < 6; ++i)
+	{
+		const Math::Vector4f& plane = frustum.GetPlane(i);
+		REQUIRE( Math::Length(Math::Vector3f(plane.X, plane.Y, plane.Z)) == Approx(1.0f) );
+	}
+
+	REQUIRE( frustum.Intersects(Math::Vector3f(0, 0, 0), 1) );
+	REQUIRE( frustum.Intersects(Math::Vector3f(0, 0, -80), 1) );
+
+	//behind the camera, past the far plane and off to the side
+	REQUIRE_FALSE( frustum.Intersects(Math::Vector3f(0, 0, 20), 1) );
+	REQUIRE_FALSE( frustum.Intersects(Math::Vector3f(0, 0, -100), 1) );
+	REQUIRE_FALSE( frustum.Intersects(Math::Vector3f(30, 0, 0), 1) );
+
+	//a sphere that only reaches into the view is kept
+	REQUIRE( frustum.Intersects(Math::Vector3f(12, 0, 0), 3) );
+	REQUIRE_FALSE( frustum.Intersects(Math::Vector3f(12, 0, 0), 1) );
+
+	Math::Matrix4f ortho = Math::Matrix4f::ToOrthographic(-10.0f, 10.0f, 5.0f, -5.0f, 5.0f, -5.0f);
+	Math::Frustumf box(ortho);
+	REQUIRE( box.Intersects(Math::Vector3f(4, -4, 0), 0) );
+	REQUIRE_FALSE( box.Intersects(Math::Vector3f(6, 0, 0), 0.5f) );
+	REQUIRE( box.Intersects(Math::Vector3f(6, 0, 0), 1.5f) );
+}
+
+//************************* SIMD *************************
+TEST_CASE( "float32 SIMD kernels match the float64 templates", "[math][simd]" ) {
+	using namespace Core;
+
+	//values with no pattern, float64 copies run through the plain templates
+	Math::Matrix4f a;
+	Math::Matrix4f b;
+	Math::Matrix4d ad;
+	Math::Matrix4d bd;
+	for(int32 i = 0; i < 4; ++i)
+	{
+		for(int32 j = 0; j < 4; ++j)
+		{
+			a[i][j] = std::sin(1.0f + i * 7 + j * j) * 3.0f + (i == j ? 4.0f : 0.0f);
+			b[i][j] = std::cos(2.0f + j * 4 + i) * 2.0f;
+			ad[i][j] = a[i][j];
+			bd[i][j] = b[i][j];
+		}
+	}
+
+	SECTION("matrix products") {
+		Math::Matrix4f product = a * b;
+		Math::Matrix4d productd = ad * bd;
+		for(int32 i = 0; i < 4; ++i)
+		{
+			for(int32 j = 0; j < 4; ++j)
+			{
+				CHECK( product[i][j] == Approx(productd[i][j]).epsilon(0.0001) );
+			}
+		}
+
+		Math::Vector4f v(0.5, -2.0, 3.25, 1.0);
+		Math::Vector4d vd(0.5, -2.0, 3.25, 1.0);
+		Math::Vector4f mv = a * v;
+		Math::Vector4d mvd = ad * vd;
+		for(int32 i = 0; i < 4; ++i)
+		{
+			CHECK( mv[i] == Approx(mvd[i]).epsilon(0.0001) );
+		}
+	}
+
+	SECTION("matrix inverse") {
+		Math::Matrix4f inv = Math::Inverse(a);
+		Math::Matrix4d invd = Math::Inverse(ad);
+		for(int32 i = 0; i < 4; ++i)
+		{
+			for(int32 j = 0; j < 4; ++j)
+			{
+				CHECK( inv[i][j] == Approx(invd[i][j]).epsilon(0.0001) );
+			}
+		}
+
+		REQUIRE( matrixFuzzyEquals(inv * a, Math::Matrix4f()) );
+		REQUIRE( Math::Inverse(Math::Matrix4f(2.0)) == Math::Matrix4f(0.0) ); //singular gives zero
+	}
+
+	SECTION("quaternions") {
+		Math::Quaternionf q(0.3, -1.2, 0.8, 2.0);
+		Math::Quaternionf r(-0.7, 0.1, 1.5, -0.4);
+		Math::Quaterniond qd(0.3f, -1.2f, 0.8f, 2.0f);
+		Math::Quaterniond rd(-0.7f, 0.1f, 1.5f, -0.4f);
+
+		Math::Quaternionf product = q * r;
+		Math::Quaterniond productd = qd * rd;
+		Math::Quaternionf norm = Math::Normalize(q);
+		Math::Quaterniond normd = Math::Normalize(qd);
+		for(int32 i = 0; i < 4; ++i)
+		{
+			CHECK( product[i] == Approx(productd[i]) );
+			CHECK( norm[i] == Approx(normd[i]) );
+		}
+		REQUIRE( Math::Normalize(Math::Quaternionf(0, 0, 0, 0)) == Math::Quaternionf(0, 0, 0, 0) );
+
+		Math::Vector3f v(1.5, -0.5, 2.0);
+		Math::Vector3d vd(1.5, -0.5, 2.0);
+		Math::Vector3d rotatedd = Math::Rotate(vd, qd);
+		REQUIRE( vectorFuzzyEquals(Math::Rotate(v, q), Math::Vector3f(rotatedd.X, rotatedd.Y, rotatedd.Z)) );
+
+		Math::Vector4f v4(3.0, -4.0, 0.0, 12.0);
+		REQUIRE( vectorFuzzyEquals(Math::Normalize(v4), Math::Vector4f(3.0/13, -4.0/13, 0.0, 12.0/13)) );
+		REQUIRE( Math::Normalize(Math::Vector4f(0.0)) == Math::Vector4f(0.0) );
+	}
+}
+
 #endif
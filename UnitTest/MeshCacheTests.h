@@ -0,0 +1,125 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "MeshCache.h"
+#include "MeshData.h"
+#include "Types.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+TEST_CASE( "Mesh cache rejects truncated and corrupt files" ) {
+	using namespace Core;
+
+	boost::filesystem::path obj = boost::filesystem::temp_directory_path( ) / "modeler3d-cache-test.obj";
+	{
+		boost::filesystem::ofstream out( obj );
+		out << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+	}
+	const std::string source = obj.string( );
+	const std::string cachePath = MeshCache::GetCachePath( source );
+
+	MeshData mesh;
+	mesh.Format = Video::VertexFormat( ).AddElement( Video::Attribute::Position, 3 );
+	mesh.Vertices = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+	mesh.VertexCount = 3;
+	mesh.Indices = { 0, 1, 2 };
+	MeshLod full = { 0, 3, 0.0f };
+	mesh.Lods = { full };
+
+	REQUIRE( MeshCache::Write( source, 7, mesh ) );
+	const uint64 size = boost::filesystem::file_size( cachePath );
+
+	std::vector< char > bytes( size );
+	{
+		boost::filesystem::ifstream in( cachePath, std::ios::binary );
+		in.read( bytes.data( ), size );
+	}
+
+	//replaces the cache file with data
+	auto rewrite = [&]( const std::vector< char >& data ) {
+		boost::filesystem::ofstream out( cachePath, std::ios::binary | std::ios::trunc );
+		out.write( data.data( ), data.size( ) );
+	};
+
+	//VertexCount follows the magic, version, build key, source key and elements, aligned to 8 bytes,
+	//then come VertexOffset, IndexCount, IndexOffset, LodCount, LodOffset and FileSize
+	const uint64 vertexCountOffset = 112;
+	const uint64 indexOffsetOffset = vertexCountOffset + 24;
+	const uint64 fileSizeOffset = vertexCountOffset + 48;
+
+	MeshCache cache;
+
+	SECTION( "An intact cache maps its arrays" ) {
+		REQUIRE( cache.Open( source, 7 ) );
+		CHECK( cache.GetVertexCount( ) == 3 );
+		CHECK( cache.GetIndexCount( ) == 3 );
+		CHECK( cache.GetIndices( )[ 2 ] == 2 );
+		CHECK( *reinterpret_cast< const uint64* >( &bytes[ vertexCountOffset ] ) == 3 );
+		CHECK( *reinterpret_cast< const uint64* >( &bytes[ fileSizeOffset ] ) == size );
+		CHECK_FALSE( cache.Open( source, 8 ) );
+	}
+
+	SECTION( "A cancelled write leaves no cache behind" ) {
+		std::atomic< bool > cancelled( true );
+		boost::filesystem::remove( cachePath );
+		CHECK_FALSE( MeshCache::Write( source, 7, mesh, &cancelled ) );
+		CHECK_FALSE( boost::filesystem::exists( cachePath ) );
+		CHECK_FALSE( boost::filesystem::exists( cachePath + ".tmp" ) );
+	}
+
+	SECTION( "The mapped arrays are viewed in place" ) {
+		REQUIRE( cache.Open( source, 7 ) );
+		MeshView view = cache.GetMesh( );
+		CHECK( view.Vertices == cache.GetVertices( ) );
+		CHECK( view.VertexCount == 3 );
+		CHECK( view.Indices == cache.GetIndices( ) );
+		CHECK( view.IndexCount == 3 );
+		CHECK( view.LodCount == 1 );
+		CHECK( view.Lods[ 0 ].IndexCount == 3 );
+	}
+
+	SECTION( "A truncated cache is rejected" ) {
+		//the header is whole and agrees with the file's size, only the arrays are cut off, partway into the indices
+		uint64 indexOffset;
+		memcpy( &indexOffset, &bytes[ indexOffsetOffset ], sizeof( indexOffset ) );
+		uint64 truncatedSize = indexOffset + sizeof( uint32 );
+		REQUIRE( truncatedSize >= fileSizeOffset + sizeof( uint64 ) );
+		REQUIRE( truncatedSize < size );
+
+		std::vector< char > truncated( bytes.begin( ), bytes.begin( ) + truncatedSize );
+		memcpy( &truncated[ fileSizeOffset ], &truncatedSize, sizeof( truncatedSize ) );
+		rewrite( truncated );
+		CHECK_FALSE( cache.Open( source, 7 ) );
+	}
+
+	SECTION( "Counts past the end of the file are rejected" ) {
+		std::vector< char > corrupt( bytes );
+		uint64 huge = 0x4000000000000000ULL;
+		memcpy( &corrupt[ vertexCountOffset ], &huge, sizeof( huge ) );
+		rewrite( corrupt );
+		CHECK_FALSE( cache.Open( source, 7 ) );
+	}
+
+	SECTION( "Indices past the last vertex are rejected" ) {
+		std::vector< char > corrupt( bytes );
+		uint64 indexOffset;
+		memcpy( &indexOffset, &corrupt[ indexOffsetOffset ], sizeof( indexOffset ) );
+		uint32 outside = 3;
+		memcpy( &corrupt[ indexOffset + 2 * sizeof( uint32 ) ], &outside, sizeof( outside ) );
+		rewrite( corrupt );
+		CHECK_FALSE( cache.Open( source, 7 ) );
+	}
+
+	cache.Close( );
+	boost::filesystem::remove( cachePath );
+	boost::filesystem::remove( obj );
+}
+
+#endif
@@ -0,0 +1,111 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <algorithm>
+#include <vector>
+
+#include "Types.h"
+#include "MeshOptimizer.h"
+
+//size x size quads on the z = 0 plane, triangles listed in a scrambled order
+static void BuildScrambledGrid( uint size, std::vector< float32 >& positions, std::vector< uint32 >& indices )
+{
+	positions.clear( );
+	indices.clear( );
+
+	for( uint y = 0; y <= size; y++ )
+	{
+		for( uint x = 0; x <= size; x++ )
+		{
+			positions.push_back( ( float32 )x );
+			positions.push_back( ( float32 )y );
+			positions.push_back( 0 );
+		}
+	}
+
+	std::vector< uint32 > triangles;
+	for( uint y = 0; y < size; y++ )
+	{
+		for( uint x = 0; x < size; x++ )
+		{
+			uint32 a = y * ( size + 1 ) + x, b = a + 1, c = a + size + 1, d = c + 1;
+			triangles.insert( triangles.end( ), { a, b, d, a, d, c } );
+		}
+	}
+
+	uint triangleCount = triangles.size( ) / 3;
+	for( uint i = 0; i < triangleCount; i++ )
+	{
+		uint t = ( i * 7919 ) % triangleCount;
+		indices.insert( indices.end( ), &triangles[ t * 3 ], &triangles[ t * 3 ] + 3 );
+	}
+}
+
+static std::vector< std::vector< uint32 > > SortedTriangles( const std::vector< uint32 >& indices )
+{
+	std::vector< std::vector< uint32 > > triangles;
+	for( uint i = 0; i < indices.size( ); i += 3 )
+	{
+		std::vector< uint32 > triangle( &indices[ i ], &indices[ i ] + 3 );
+		std::rotate( triangle.begin( ), std::min_element( triangle.begin( ), triangle.end( ) ), triangle.end( ) );
+		triangles.push_back( triangle );
+	}
+	std::sort( triangles.begin( ), triangles.end( ) );
+	return triangles;
+}
+
+TEST_CASE( "Vertex cache analysis counts misses" ) {
+	//two triangles sharing an edge load 4 vertices
+	uint32 indices[] = { 0, 1, 2, 2, 1, 3 };
+	Core::MeshOptimizer::VertexCacheStats stats = Core::MeshOptimizer::AnalyzeVertexCache( indices, 6, 4 );
+
+	CHECK( stats.Acmr == Approx( 2.0f ) );
+	CHECK( stats.Atvr == Approx( 1.0f ) );
+}
+
+TEST_CASE( "Vertex cache optimization keeps the triangles and lowers ACMR" ) {
+	std::vector< float32 > positions;
+	std::vector< uint32 > indices;
+	BuildScrambledGrid( 64, positions, indices );
+	const uint vertexCount = positions.size( ) / 3;
+
+	std::vector< uint32 > original = indices;
+	Core::MeshOptimizer::VertexCacheStats before = Core::MeshOptimizer::AnalyzeVertexCache( indices.data( ), indices.size( ), vertexCount );
+
+	Core::MeshOptimizer::OptimizeVertexCache( indices.data( ), indices.size( ), vertexCount );
+	Core::MeshOptimizer::VertexCacheStats after = Core::MeshOptimizer::AnalyzeVertexCache( indices.data( ), indices.size( ), vertexCount );
+
+	UNIT_TEST_OUTPUT( std::cout << "Grid ACMR " << before.Acmr << " -> " << after.Acmr << std::endl )
+
+	CHECK( SortedTriangles( indices ) == SortedTriangles( original ) );
+	CHECK( after.Acmr < 0.8f );
+	CHECK( after.Acmr < before.Acmr );
+
+	Core::MeshOptimizer::OptimizeOverdraw( indices.data( ), indices.size( ), positions.data( ), vertexCount, 3 );
+	Core::MeshOptimizer::VertexCacheStats sorted = Core::MeshOptimizer::AnalyzeVertexCache( indices.data( ), indices.size( ), vertexCount );
+
+	CHECK( SortedTriangles( indices ) == SortedTriangles( original ) );
+	CHECK( sorted.Acmr <= after.Acmr * 1.1f );
+}
+
+TEST_CASE( "Vertex fetch optimization orders vertices by first use and drops unused ones" ) {
+	//vertex 1 is never used
+	float32 vertices[] = { 0, 0, 0,   9, 9, 9,   1, 0, 0,   0, 1, 0 };
+	uint32 indices[] = { 3, 2, 0 };
+
+	uint count = Core::MeshOptimizer::OptimizeVertexFetch( vertices, 4, 3, indices, 3 );
+
+	REQUIRE( count == 3 );
+	CHECK( indices[ 0 ] == 0 );
+	CHECK( indices[ 1 ] == 1 );
+	CHECK( indices[ 2 ] == 2 );
+
+	float32 expected[] = { 0, 1, 0,   1, 0, 0,   0, 0, 0 };
+	for( uint i = 0; i < 9; i++ )
+	{
+		CHECK( vertices[ i ] == expected[ i ] );
+	}
+}
+
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <vector>
+
+#include "Types.h"
+#include "MeshSimplifier.h"
+
+//flat size x size grid of quads in the xy plane, from 0 to 1
+static void MakeGrid( uint size, std::vector< float32 > &refPositions, std::vector< uint32 > &refIndices )
+{
+	for( uint y = 0; y <= size; y++ )
+	{
+		for( uint x = 0; x <= size; x++ )
+		{
+			refPositions.push_back( x / ( float32 )size );
+			refPositions.push_back( y / ( float32 )size );
+			refPositions.push_back( 0 );
+		}
+	}
+
+	for( uint y = 0; y < size; y++ )
+	{
+		for( uint x = 0; x < size; x++ )
+		{
+			uint32 a = y * ( size + 1 ) + x;
+			uint32 b = a + 1;
+			uint32 c = a + size + 2;
+			uint32 d = a + size + 1;
+			refIndices.insert( refIndices.end( ), { a, b, c, a, c, d } );
+		}
+	}
+}
+
+TEST_CASE( "Simplifying a flat grid keeps its shape" ) {
+	std::vector< float32 > positions;
+	std::vector< uint32 > indices;
+	MakeGrid( 20, positions, indices );
+
+	Core::MeshSimplifier simplifier( positions.data( ), positions.size( ) / 3, indices.data( ), indices.size( ) );
+	REQUIRE( simplifier.GetTriangleCount( ) == 800 );
+
+	uint left = simplifier.Simplify( 100 );
+	CHECK( left <= 100 );
+	CHECK( simplifier.GetError( ) == Approx( 0 ) );
+
+	std::vector< float32 > simplePositions;
+	std::vector< uint32 > simpleIndices;
+	simplifier.GetMesh( simplePositions, simpleIndices );
+
+	REQUIRE( simpleIndices.size( ) == left * 3 );
+
+	//border vertices only slide along the border, so the grid still covers the unit square
+	float32 area = 0;
+	for( uint i = 0; i < simpleIndices.size( ); i += 3 )
+	{
+		const float32* a = &simplePositions[ simpleIndices[ i ] * 3 ];
+		const float32* b = &simplePositions[ simpleIndices[ i + 1 ] * 3 ];
+		const float32* c = &simplePositions[ simpleIndices[ i + 2 ] * 3 ];
+
+		CHECK( a[ 2 ] == Approx( 0 ) );
+		float32 cross = ( b[ 0 ] - a[ 0 ] ) * ( c[ 1 ] - a[ 1 ] ) - ( b[ 1 ] - a[ 1 ] ) * ( c[ 0 ] - a[ 0 ] );
+
+		//no triangle was folded over
+		CHECK( cross >= 0 );
+		area += cross / 2;
+	}
+	CHECK( area == Approx( 1 ) );
+}
+
+TEST_CASE( "Simplifying again continues from the last result" ) {
+	std::vector< float32 > positions;
+	std::vector< uint32 > indices;
+	MakeGrid( 20, positions, indices );
+
+	//bend the grid into a ridge so collapses have a cost
+	for( uint i = 0; i < positions.size( ); i += 3 )
+	{
+		positions[ i + 2 ] = 0.5f - std::abs( positions[ i ] - 0.5f );
+	}
+
+	Core::MeshSimplifier simplifier( positions.data( ), positions.size( ) / 3, indices.data( ), indices.size( ) );
+
+	uint first = simplifier.Simplify( 400 );
+	float32 firstError = simplifier.GetError( );
+	uint second = simplifier.Simplify( 50 );
+
+	CHECK( first <= 400 );
+	CHECK( second <= 50 );
+	CHECK( simplifier.GetError( ) >= firstError );
+}
+
+#endif
@@ -0,0 +1,245 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <cmath>
+#include <vector>
+
+#include "Types.h"
+#include "MeshUtil.h"
+#include "Math/ModelerMath.h"
+
+TEST_CASE( "Welding merges identical vertices" ) {
+	//two triangles of a quad, sharing an edge, one shared corner uses -0
+	float32 vertices[] = {
+		0, 0, 0,   1, 0, 0,   1, 1, 0,
+		-0.0f, 0, 0,   1, 1, 0,   0, 1, 0
+	};
+
+	std::vector< float32 > unique;
+	std::vector< uint32 > indices;
+	Core::MeshUtil::WeldVertices( vertices, 6, 3, unique, indices );
+
+	REQUIRE( unique.size( ) == 4 * 3 );
+	REQUIRE( indices.size( ) == 6 );
+	CHECK( indices == std::vector< uint32 >( { 0, 1, 2, 0, 2, 3 } ) );
+
+	for( uint i = 0; i < 6; i++ )
+	{
+		for( uint j = 0; j < 3; j++ )
+		{
+			CHECK( unique[ indices[ i ] * 3 + j ] == vertices[ i * 3 + j ] );
+		}
+	}
+}
+
+TEST_CASE( "Welding keeps vertices that differ in any attribute" ) {
+	float32 vertices[] = {
+		0, 0, 0, 0, 0, 1,
+		0, 0, 0, 0, 1, 0,
+		0, 0, 0, 0, 0, 1
+	};
+
+	std::vector< float32 > unique;
+	std::vector< uint32 > indices;
+	Core::MeshUtil::WeldVertices( vertices, 3, 6, unique, indices );
+
+	CHECK( unique.size( ) == 2 * 6 );
+	CHECK( indices == std::vector< uint32 >( { 0, 1, 0 } ) );
+}
+
+//unit cube, two triangles per side, wound counter clockwise from outside
+static const float32 CubePositions[] = {
+	0, 0, 0,   1, 0, 0,   1, 1, 0,   0, 1, 0,
+	0, 0, 1,   1, 0, 1,   1, 1, 1,   0, 1, 1
+};
+static const uint32 CubeIndices[] = {
+	0, 2, 1,   0, 3, 2,
+	4, 5, 6,   4, 6, 7,
+	0, 1, 5,   0, 5, 4,
+	3, 7, 6,   3, 6, 2,
+	0, 4, 7,   0, 7, 3,
+	1, 2, 6,   1, 6, 5
+};
+
+TEST_CASE( "Generated normals split at the crease angle" ) {
+	std::vector< float32 > vertices;
+	std::vector< uint32 > indices;
+	Core::MeshUtil::GenerateNormals( CubePositions, 8, CubeIndices, 36, Core::Math::ToRadians( 60.0f ), vertices, indices );
+
+	//every corner of the cube splits into one vertex per side
+	REQUIRE( vertices.size( ) == 24 * 6 );
+	REQUIRE( indices.size( ) == 36 );
+
+	for( uint i = 0; i < 36; i++ )
+	{
+		const float32* vertex = &vertices[ indices[ i ] * 6 ];
+		const float32* expected = &CubePositions[ CubeIndices[ i ] * 3 ];
+
+		CHECK( vertex[ 0 ] == expected[ 0 ] );
+		CHECK( vertex[ 1 ] == expected[ 1 ] );
+		CHECK( vertex[ 2 ] == expected[ 2 ] );
+
+		//normals point straight out of the side
+		float32 nx = vertex[ 3 ], ny = vertex[ 4 ], nz = vertex[ 5 ];
+		CHECK( std::abs( nx ) + std::abs( ny ) + std::abs( nz ) == Approx( 1 ) );
+		CHECK( nx * ( expected[ 0 ] - 0.5f ) + ny * ( expected[ 1 ] - 0.5f ) + nz * ( expected[ 2 ] - 0.5f ) == Approx( 0.5f ) );
+	}
+}
+
+TEST_CASE( "Generated normals are smooth and angle weighted below the crease angle" ) {
+	std::vector< float32 > vertices;
+	std::vector< uint32 > indices;
+	Core::MeshUtil::GenerateNormals( CubePositions, 8, CubeIndices, 36, Core::Math::ToRadians( 180.0f ), vertices, indices );
+
+	REQUIRE( vertices.size( ) == 8 * 6 );
+
+	//each side meets a corner at 90 degrees in total, so corners point along the diagonal
+	for( uint i = 0; i < 36; i++ )
+	{
+		const float32* vertex = &vertices[ indices[ i ] * 6 ];
+
+		for( uint k = 0; k < 3; k++ )
+		{
+			float32 direction = vertex[ k ] > 0.5f ? 1.0f : -1.0f;
+			CHECK( vertex[ k + 3 ] == Approx( direction / std::sqrt( 3.0f ) ) );
+		}
+	}
+}
+
+TEST_CASE( "Generated normals drop unused positions" ) {
+	float32 positions[] = {
+		5, 5, 5,
+		0, 0, 0,
+		1, 0, 0,
+		0, 1, 0
+	};
+	uint32 triangle[] = { 1, 2, 3 };
+
+	std::vector< float32 > vertices;
+	std::vector< uint32 > indices;
+	Core::MeshUtil::GenerateNormals( positions, 4, triangle, 3, Core::Math::ToRadians( 60.0f ), vertices, indices );
+
+	REQUIRE( vertices.size( ) == 3 * 6 );
+	CHECK( indices == std::vector< uint32 >( { 0, 1, 2 } ) );
+	CHECK( vertices[ 5 ] == Approx( 1 ) );
+}
+
+TEST_CASE( "Batch transforms match transforming one vector at a time" ) {
+	using namespace Core;
+
+	//an odd count leaves vectors past the last group of four
+	const uint count = 103;
+	std::vector< float32 > vertices( count * 6 );
+	std::vector< float32 > x( count ), y( count ), z( count );
+	for( uint i = 0; i < count; i++ )
+	{
+		x[ i ] = vertices[ i * 6 ] = std::sin( i * 0.7f ) * 5;
+		y[ i ] = vertices[ i * 6 + 1 ] = std::cos( i * 1.3f ) * 3;
+		z[ i ] = vertices[ i * 6 + 2 ] = i * 0.25f - 10;
+	}
+
+	Math::Quaternionf rotation = Math::Quaternionf::AxisAngle( Math::Normalize( Math::Vector3f( 1, 2, 3 ) ), 0.6f );
+	Math::Matrix4f m = Math::Matrix4f::ToTranslation( Math::Vector3f( 1, -2, 3 ) ) *
+			Math::Quaternionf::ToRotation( rotation ) * Math::Matrix4f::ToScale( Math::Vector3f( 2, 3, 0.5f ) );
+
+	SECTION( "points" ) {
+		std::vector< float32 > interleaved = vertices;
+		std::vector< float32 > sx( count ), sy( count ), sz( count );
+		MeshUtil::TransformPoints( m, MeshUtil::Interleaved( interleaved.data( ), count, 6 ), MeshUtil::Interleaved( interleaved.data( ), count, 6 ) );
+		MeshUtil::TransformPoints( m, MeshUtil::Separate( x.data( ), y.data( ), z.data( ), count ), MeshUtil::Separate( sx.data( ), sy.data( ), sz.data( ), count ) );
+
+		for( uint i = 0; i < count; i++ )
+		{
+			Math::Vector4f expected = m * Math::Vector4f( x[ i ], y[ i ], z[ i ], 1 );
+			CHECK( interleaved[ i * 6 ] == expected.X );
+			CHECK( interleaved[ i * 6 + 1 ] == expected.Y );
+			CHECK( interleaved[ i * 6 + 2 ] == expected.Z );
+			CHECK( sx[ i ] == expected.X );
+			CHECK( sy[ i ] == expected.Y );
+			CHECK( sz[ i ] == expected.Z );
+		}
+	}
+
+	SECTION( "directions" ) {
+		std::vector< float32 > sx( count ), sy( count ), sz( count );
+		MeshUtil::TransformDirections( rotation, MeshUtil::Separate( x.data( ), y.data( ), z.data( ), count ), MeshUtil::Separate( sx.data( ), sy.data( ), sz.data( ), count ) );
+
+		for( uint i = 0; i < count; i++ )
+		{
+			Math::Vector3f expected = Math::Rotate( Math::Vector3f( x[ i ], y[ i ], z[ i ] ), rotation );
+			CHECK( sx[ i ] == Approx( expected.X ).epsilon( 0.0001 ) );
+			CHECK( sy[ i ] == Approx( expected.Y ).epsilon( 0.0001 ) );
+			CHECK( sz[ i ] == Approx( expected.Z ).epsilon( 0.0001 ) );
+		}
+	}
+
+	SECTION( "normalize, cross and dot" ) {
+		//one zero vector in the first group of four and one in the rest
+		for( uint i : { 2, 100 } )
+		{
+			x[ i ] = y[ i ] = z[ i ] = 0;
+			vertices[ i * 6 ] = vertices[ i * 6 + 1 ] = vertices[ i * 6 + 2 ] = 0;
+		}
+
+		std::vector< float32 > nx = x, ny = y, nz = z;
+		MeshUtil::NormalizeArray( MeshUtil::Separate( nx.data( ), ny.data( ), nz.data( ), count ) );
+		MeshUtil::NormalizeArray( MeshUtil::Interleaved( vertices.data( ), count, 6 ) );
+
+		std::vector< float32 > cx( count ), cy( count ), cz( count ), dots( count );
+		MeshUtil::CrossArray( MeshUtil::Separate( x.data( ), y.data( ), z.data( ), count ), MeshUtil::Separate( nz.data( ), nx.data( ), ny.data( ), count ),
+				MeshUtil::Separate( cx.data( ), cy.data( ), cz.data( ), count ) );
+		MeshUtil::DotArray( MeshUtil::Separate( x.data( ), y.data( ), z.data( ), count ), MeshUtil::Interleaved( vertices.data( ), count, 6 ), dots.data( ) );
+
+		for( uint i = 0; i < count; i++ )
+		{
+			Math::Vector3f v( x[ i ], y[ i ], z[ i ] );
+			Math::Vector3f normal = Math::Normalize( v );
+			CHECK( nx[ i ] == normal.X );
+			CHECK( ny[ i ] == normal.Y );
+			CHECK( nz[ i ] == normal.Z );
+			CHECK( vertices[ i * 6 ] == normal.X );
+			CHECK( vertices[ i * 6 + 1 ] == normal.Y );
+			CHECK( vertices[ i * 6 + 2 ] == normal.Z );
+
+			Math::Vector3f cross = Math::Cross( v, Math::Vector3f( nz[ i ], nx[ i ], ny[ i ] ) );
+			CHECK( cx[ i ] == Approx( cross.X ) );
+			CHECK( cy[ i ] == Approx( cross.Y ) );
+			CHECK( cz[ i ] == Approx( cross.Z ) );
+			CHECK( dots[ i ] == Approx( Math::Dot( v, normal ) ) );
+		}
+	}
+}
+
+TEST_CASE( "Bounds cover every vector in either layout" ) {
+	using namespace Core;
+
+	//enough vectors to be split across the job system
+	const uint count = 200003;
+	std::vector< float32 > positions( count * 3 );
+	std::vector< float32 > x( count ), y( count ), z( count );
+	for( uint i = 0; i < count; i++ )
+	{
+		x[ i ] = positions[ i * 3 ] = std::sin( i * 0.001f ) * 4;
+		y[ i ] = positions[ i * 3 + 1 ] = ( i % 1000 ) * 0.5f - 100;
+		z[ i ] = positions[ i * 3 + 2 ] = i == count - 1 ? 1000.0f : 7.0f;
+	}
+
+	Math::Vector3f low( 0 ), high( 0 );
+	REQUIRE( MeshUtil::ComputeBounds( MeshUtil::Interleaved( positions.data( ), count ), low, high ) );
+	CHECK( low.X == Approx( -4 ).epsilon( 0.0001 ) );
+	CHECK( high.X == Approx( 4 ).epsilon( 0.0001 ) );
+	CHECK( low.Y == -100 );
+	CHECK( high.Y == 399.5f );
+	CHECK( low.Z == 7 );
+	CHECK( high.Z == 1000 );
+
+	Math::Vector3f separateLow( 0 ), separateHigh( 0 );
+	REQUIRE( MeshUtil::ComputeBounds( MeshUtil::Separate( x.data( ), y.data( ), z.data( ), count ), separateLow, separateHigh ) );
+	CHECK( separateLow == low );
+	CHECK( separateHigh == high );
+
+	CHECK_FALSE( MeshUtil::ComputeBounds( MeshUtil::Interleaved( positions.data( ), 0 ), low, high ) );
+}
+
+#endif
@@ -0,0 +1,156 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <vector>
+
+#include "FileIO.h"
+#include "Types.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+TEST_CASE( "Mapped .obj loader matches LoadObj2" ) {
+
+	const char* files[] = { "Assets/cube.obj", "Assets/bunny.obj", "Assets/pencil.obj" };
+
+	for( uint f = 0; f < 3; f++ )
+	{
+		INFO( "File " << files[ f ] );
+
+		FileIO objFile;
+
+		std::vector< std::vector< double > > positions, mappedPositions;
+		std::vector< std::vector< double > > textures, mappedTextures;
+		std::vector< std::vector< double > > normals, mappedNormals;
+		std::vector< std::vector< std::vector< int > > > faces, mappedFaces;
+
+		objFile.LoadObj2( boost::filesystem::path( files[ f ] ), positions, textures, normals, faces );
+		REQUIRE( objFile.LoadObjMapped( boost::filesystem::path( files[ f ] ), mappedPositions, mappedTextures, mappedNormals, mappedFaces ) );
+
+		REQUIRE( mappedPositions.size( ) == positions.size( ) );
+		REQUIRE( mappedTextures.size( ) == textures.size( ) );
+		REQUIRE( mappedNormals.size( ) == normals.size( ) );
+		REQUIRE( mappedFaces.size( ) == faces.size( ) );
+
+		for( uint i = 0; i < positions.size( ); i++ )
+		{
+			for( uint j = 0; j < 3; j++ )
+			{
+				CHECK( mappedPositions[ i ][ j ] == Approx( positions[ i ][ j ] ) );
+			}
+		}
+
+		for( uint i = 0; i < faces.size( ); i++ )
+		{
+			CHECK( mappedFaces[ i ] == faces[ i ] );
+		}
+	}
+}
+
+TEST_CASE( "Mapped .obj loader fails on missing file" ) {
+
+	FileIO objFile;
+
+	std::vector< std::vector< double > > positions, textures, normals;
+	std::vector< std::vector< std::vector< int > > > faces;
+
+	CHECK_FALSE( objFile.LoadObjMapped( boost::filesystem::path( "Assets/does-not-exist.obj" ), positions, textures, normals, faces ) );
+}
+
+TEST_CASE( "Parallel .obj loader matches single threaded loader across chunks" ) {
+
+	//big enough to be split into several chunks, faces use relative indices that cross chunk boundaries
+	boost::filesystem::path obj = boost::filesystem::temp_directory_path( ) / "modeler3d-parallel-test.obj";
+	{
+		boost::filesystem::ofstream out( obj );
+		for( uint i = 0; i < 100000; i++ )
+		{
+			out << "v " << i << " " << i * 0.5 << " " << i * 0.25 << "\n";
+			out << "vn 0 0 1\n";
+			if( i > 2 )
+				out << "f -1//-1 -2//-1 -3//-2 -4//-3\n";
+		}
+	}
+
+	FileIO objFile;
+
+	std::vector< std::vector< double > > positions, parallelPositions;
+	std::vector< std::vector< double > > textures, parallelTextures;
+	std::vector< std::vector< double > > normals, parallelNormals;
+	std::vector< std::vector< std::vector< int > > > faces, parallelFaces;
+
+	REQUIRE( objFile.LoadObjParallel( obj, positions, textures, normals, faces, 1 ) );
+	REQUIRE( objFile.LoadObjParallel( obj, parallelPositions, parallelTextures, parallelNormals, parallelFaces, 4 ) );
+	boost::filesystem::remove( obj );
+
+	REQUIRE( positions.size( ) == 100000 );
+	REQUIRE( faces.size( ) == 99997 * 2 );
+	CHECK( faces[ 0 ][ 0 ] == std::vector< int >( { 4, 0, 4 } ) );
+	CHECK( faces[ 0 ][ 2 ] == std::vector< int >( { 2, 0, 3 } ) );
+
+	CHECK( parallelPositions == positions );
+	CHECK( parallelNormals == normals );
+	CHECK( parallelFaces == faces );
+}
+
+TEST_CASE( "Flat .obj loader matches nested loader" ) {
+
+	boost::filesystem::path obj( "Assets/pencil.obj" );
+
+	FileIO objFile;
+
+	std::vector< std::vector< double > > positions, textures, normals;
+	std::vector< std::vector< std::vector< int > > > faces;
+	ObjMesh mesh;
+
+	REQUIRE( objFile.LoadObjMapped( obj, positions, textures, normals, faces ) );
+	REQUIRE( objFile.LoadObjMesh( obj, mesh ) );
+
+	REQUIRE( mesh.GetVertexCount( ) == positions.size( ) );
+	REQUIRE( mesh.GetTextureCoordinateCount( ) == textures.size( ) );
+	REQUIRE( mesh.GetNormalCount( ) == normals.size( ) );
+	REQUIRE( mesh.GetTriangleCount( ) == faces.size( ) );
+
+	for( uint i = 0; i < positions.size( ); i++ )
+	{
+		for( uint j = 0; j < 3; j++ )
+		{
+			CHECK( mesh.GeometricVertices[ i * 3 + j ] == Approx( positions[ i ][ j ] ) );
+		}
+	}
+
+	for( uint i = 0; i < faces.size( ); i++ )
+	{
+		for( uint j = 0; j < 3; j++ )
+		{
+			for( uint k = 0; k < 3; k++ )
+			{
+				CHECK( mesh.FaceElements[ i * 9 + j * 3 + k ] == static_cast< uint32 >( faces[ i ][ j ][ k ] ) );
+			}
+		}
+	}
+}
+
+TEST_CASE( "Flat .obj loader reports progress and stops when cancelled" ) {
+
+	boost::filesystem::path obj( "Assets/pencil.obj" );
+
+	FileIO objFile;
+	ObjMesh mesh;
+	ObjLoadProgress progress;
+
+	REQUIRE( objFile.LoadObjMesh( obj, mesh, 2, &progress ) );
+	CHECK( progress.Total == boost::filesystem::file_size( obj ) * 2 );
+	CHECK( progress.Processed == progress.Total );
+	CHECK( progress.GetFraction( ) == Approx( 1.0f ) );
+
+	ObjMesh cancelledMesh;
+	ObjLoadProgress cancelled;
+	cancelled.Cancelled = true;
+
+	CHECK_FALSE( objFile.LoadObjMesh( obj, cancelledMesh, 2, &cancelled ) );
+	CHECK( cancelled.Processed < cancelled.Total );
+}
+
+#endif
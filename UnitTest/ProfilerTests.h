@@ -0,0 +1,66 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "Types.h"
+#include "Profiler.h"
+#include "ThreadUtil.h"
+
+TEST_CASE( "Profiler records zones only while recording" ) {
+	uint64 before = Core::Profiler::GetEventCount( );
+	{
+		PROFILE_ZONE( "Not recorded" );
+	}
+	CHECK( Core::Profiler::GetEventCount( ) == before );
+
+	Core::Profiler::Start( );
+	CHECK( Core::Profiler::IsRecording( ) );
+	{
+		PROFILE_ZONE( "Outer zone" );
+		PROFILE_ZONE( "Inner zone" );
+	}
+	Core::Profiler::Counter( "Test counter", 42 );
+	Core::Profiler::Stop( );
+
+	CHECK( !Core::Profiler::IsRecording( ) );
+	CHECK( Core::Profiler::GetEventCount( ) == before + 3 );
+}
+
+TEST_CASE( "Profiler exports every thread's zones as a Chrome trace" ) {
+	Core::Profiler::Start( );
+	Core::Profiler::SetThreadName( "Test thread" );
+	{
+		PROFILE_ZONE( "Quoted \"zone\"" );
+	}
+	Core::Profiler::Counter( "Test counter", 1 );
+	Core::Thread::ParallelFor( 64, 1, [ ]( uint64 begin, uint64 end )
+	{
+		PROFILE_ZONE( "Test range" );
+	} );
+	Core::Profiler::Stop( );
+
+	const std::string file = "profiler_test_trace.json";
+	REQUIRE( Core::Profiler::Export( file ) );
+
+	std::ifstream in( file );
+	std::stringstream stream;
+	stream << in.rdbuf( );
+	std::string trace = stream.str( );
+	in.close( );
+	std::remove( file.c_str( ) );
+
+	CHECK( trace.find( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" ) == 0 );
+	CHECK( trace.find( "\"name\":\"Test range\",\"ph\":\"X\"" ) != std::string::npos );
+	CHECK( trace.find( "\"args\":{\"name\":\"Test thread\"}" ) != std::string::npos );
+	CHECK( trace.find( "\"name\":\"Quoted \\\"zone\\\"\"" ) != std::string::npos );
+	CHECK( trace.find( "\"ph\":\"C\"" ) != std::string::npos );
+	CHECK( trace.find( "\"name\":\"Not recorded\"" ) == std::string::npos );
+	CHECK( trace.substr( trace.size( ) - 4 ) == "\n]}\n" );
+}
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include "Types.h"
+#include "RangeAllocator.h"
+
+TEST_CASE( "Ranges are allocated first fit and merged when freed" ) {
+	using namespace Core;
+
+	RangeAllocator ranges( 100 );
+	REQUIRE( ranges.GetFreeCount( ) == 100 );
+	REQUIRE( ranges.IsEmpty( ) );
+
+	uint32 a = ranges.Allocate( 30 );
+	uint32 b = ranges.Allocate( 30 );
+	uint32 c = ranges.Allocate( 30 );
+	REQUIRE( a == 0 );
+	REQUIRE( b == 30 );
+	REQUIRE( c == 60 );
+	REQUIRE( ranges.GetFreeCount( ) == 10 );
+	REQUIRE( ranges.GetLargestFree( ) == 10 );
+	REQUIRE( ranges.Allocate( 11 ) == RangeAllocator::Invalid );
+	REQUIRE( ranges.Allocate( 0 ) == RangeAllocator::Invalid );
+
+	SECTION( "A freed range is reused by a smaller allocation" ) {
+		ranges.Free( b, 30 );
+		REQUIRE( ranges.Allocate( 20 ) == 30 );
+		REQUIRE( ranges.GetLargestFree( ) == 10 );
+	}
+
+	SECTION( "Neighbouring free ranges merge" ) {
+		ranges.Free( a, 30 );
+		ranges.Free( c, 30 );
+		REQUIRE( ranges.GetLargestFree( ) == 40 );
+
+		ranges.Free( b, 30 );
+		REQUIRE( ranges.IsEmpty( ) );
+		REQUIRE( ranges.GetLargestFree( ) == 100 );
+		REQUIRE( ranges.Allocate( 100 ) == 0 );
+	}
+}
+
+#endif
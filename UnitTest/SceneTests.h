@@ -0,0 +1,451 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <algorithm>
+#include <vector>
+
+#include "Types.h"
+#include "IGraphicsDevice.h"
+#include "MeshData.h"
+#include "Scene.h"
+#include "Math/ModelerMath.h"
+
+//buffers keep what is written to them and tell the device when they're deleted
+class StubVertexBuffer : public Video::IVertexBuffer
+{
+public:
+	StubVertexBuffer( std::vector< StubVertexBuffer* >* refLive, Video::VertexFormat format, uint length,
+			Video::BufferHint hint, Video::BufferShadow shadow )
+		: Data( length * format.GetSizeInFloats( ) ), Hint( hint ), Shadow( shadow ), mLive( refLive ), mFormat( format ),
+		  mLength( length )
+	{
+		mLive->push_back( this );
+	}
+
+	~StubVertexBuffer( ) { mLive->erase( std::find( mLive->begin( ), mLive->end( ), this ) ); }
+
+	void Release( ) {}
+	const Video::VertexFormat& GetFormat( ) const { return mFormat; }
+	uint GetLength( ) const { return mLength; }
+
+	void GetData( float32* out, uint start, uint count ) const
+	{
+		const uint size = mFormat.GetSizeInFloats( );
+		std::copy( Data.begin( ) + start * size, Data.begin( ) + ( start + count ) * size, out );
+	}
+
+	void SetData( const float32* in, uint start, uint count )
+	{
+		const uint size = mFormat.GetSizeInFloats( );
+		std::copy( in, in + count * size, Data.begin( ) + start * size );
+	}
+
+	std::vector< float32 > Data;
+	Video::BufferHint Hint;
+	Video::BufferShadow Shadow;
+private:
+	std::vector< StubVertexBuffer* >* mLive;
+	Video::VertexFormat mFormat;
+	uint mLength;
+};
+
+class StubIndexBuffer : public Video::IIndexBuffer
+{
+public:
+	StubIndexBuffer( std::vector< StubIndexBuffer* >* refLive, uint length, Video::IndexFormat format, Video::BufferHint hint )
+		: Data( length ), Hint( hint ), mLive( refLive ), mFormat( format )
+	{
+		mLive->push_back( this );
+	}
+
+	~StubIndexBuffer( ) { mLive->erase( std::find( mLive->begin( ), mLive->end( ), this ) ); }
+
+	void Release( ) {}
+	uint GetLength( ) const { return Data.size( ); }
+	Video::IndexFormat GetFormat( ) const { return mFormat; }
+	void GetData( uint32* out, uint start, uint count ) const { std::copy( &Data[ start ], &Data[ start ] + count, out ); }
+	void SetData( const uint32* in, uint start, uint count ) { std::copy( in, in + count, Data.begin( ) + start ); }
+
+	std::vector< uint32 > Data;
+	Video::BufferHint Hint;
+private:
+	std::vector< StubIndexBuffer* >* mLive;
+	Video::IndexFormat mFormat;
+};
+
+class StubGeometry : public Video::IGeometry
+{
+public:
+	StubGeometry( ) : mVbos( ), mIbo( nullptr ) {}
+
+	void Release( ) {}
+	uint GetVertexBufferCount( ) const { return mVbos.size( ); }
+	const Video::IVertexBuffer* GetVertexBuffer( uint index ) const { return mVbos[ index ]; }
+	Video::IVertexBuffer* GetVertexBuffer( uint index ) { return mVbos[ index ]; }
+	const Video::IIndexBuffer* GetIndexBuffer( ) const { return mIbo; }
+	Video::IIndexBuffer* GetIndexBuffer( ) { return mIbo; }
+	void SetVertexBuffer( Video::IVertexBuffer* vbo ) { SetVertexBuffers( &vbo, 1 ); }
+	void SetVertexBuffers( Video::IVertexBuffer** vbos, uint count ) { mVbos.assign( vbos, vbos + count ); }
+	void SetIndexBuffer( Video::IIndexBuffer* ibo ) { mIbo = ibo; }
+private:
+	std::vector< Video::IVertexBuffer* > mVbos;
+	Video::IIndexBuffer* mIbo;
+};
+
+class StubShader : public Video::IShader
+{
+public:
+	void Release( ) {}
+	const std::string& GetVertexSource( ) const { return mSource; }
+	const std::string& GetFragmentSource( ) const { return mSource; }
+	Video::UniformHandle GetUniform( const std::string& name ) const { return Video::UniformHandle( ); }
+	void SetMatrix4f( Video::UniformHandle uniform, const Core::Math::Matrix4f& mat ) {}
+	void SetMatrix3f( Video::UniformHandle uniform, const Core::Math::Matrix3f& mat ) {}
+	void SetVector4f( Video::UniformHandle uniform, const Core::Math::Vector4f& vec ) {}
+	void SetVector3f( Video::UniformHandle uniform, const Core::Math::Vector3f& vec ) {}
+	void SetVector2f( Video::UniformHandle uniform, const Core::Math::Vector2f& vec ) {}
+	void SetFloat32( Video::UniformHandle uniform, float32 f ) {}
+	void SetInt32( Video::UniformHandle uniform, int32 i ) {}
+private:
+	std::string mSource;
+};
+
+//records the buffers that are alive and every draw instead of drawing
+class StubGraphicsDevice : public Video::IGraphicsDevice
+{
+public:
+	struct DrawCall
+	{
+		Video::IGeometry* Geometry;
+		uint Start;
+		uint PrimCount;
+		uint InstanceCount;
+	};
+
+	StubGraphicsDevice( ) : VertexBuffers( ), IndexBuffers( ), Draws( ), mGeometry( nullptr ), mShader( nullptr ) {}
+
+	float32 GetWidth( ) const { return 640; }
+	float32 GetHeight( ) const { return 480; }
+	float32 GetAspectRatio( ) const { return GetWidth( ) / GetHeight( ); }
+
+	Video::IVertexBuffer* CreateVertexBuffer( Video::VertexFormat format, uint count, Video::BufferHint hint,
+			Video::BufferShadow shadow )
+	{
+		return new StubVertexBuffer( &VertexBuffers, format, count, hint, shadow );
+	}
+
+	Video::IIndexBuffer* CreateIndexBuffer( uint count, Video::BufferHint hint, Video::IndexFormat format,
+			Video::BufferShadow shadow )
+	{
+		return new StubIndexBuffer( &IndexBuffers, count, format, hint );
+	}
+
+	Video::BufferMemoryStats GetBufferMemory( ) const
+	{
+		Video::BufferMemoryStats stats = { VertexBuffers.size( ) + IndexBuffers.size( ), 0, 0 };
+		return stats;
+	}
+
+	Video::IShader* CreateShader( const std::string& vertex, const std::string& fragment ) { return new StubShader; }
+	Video::IGeometry* CreateGeometry( ) { return new StubGeometry; }
+	Video::ITexture2D* CreateTexture2D( const std::string& filename ) { return nullptr; }
+	Video::ITexture2D* CreateTexture2D( uint width, uint height ) { return nullptr; }
+
+	void SetClearColor( float32 r, float32 g, float32 b, float32 a ) {}
+	void Clear( bool color, bool depth ) {}
+	void ReadPixels( std::vector< uint8 >& refPixels, uint& refWidth, uint& refHeight ) { refWidth = refHeight = 0; }
+
+	const Video::IGeometry* GetGeometry( ) const { return mGeometry; }
+	Video::IGeometry* GetGeometry( ) { return mGeometry; }
+	const Video::IShader* GetShader( ) const { return mShader; }
+	Video::IShader* GetShader( ) { return mShader; }
+	const Video::ITexture2D* GetTexture( uint index ) const { return nullptr; }
+	Video::ITexture2D* GetTexture( uint index ) { return nullptr; }
+
+	void SetGeometry( Video::IGeometry* geom ) { mGeometry = geom; }
+	void SetShader( Video::IShader* shader ) { mShader = shader; }
+	void SetTexture( uint index, Video::ITexture2D* tex ) {}
+
+	void Draw( Video::Primitive prim, uint start, uint primCount ) { DrawIndices( prim, start, primCount ); }
+
+	void DrawIndices( Video::Primitive prim, uint start, uint primCount )
+	{
+		DrawCall draw = { mGeometry, start, primCount, 1 };
+		Draws.push_back( draw );
+	}
+
+	void DrawInstanced( Video::Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount )
+	{
+		DrawIndicesInstanced( prim, start, primCount, instanceStart, instanceCount );
+	}
+
+	void DrawIndicesInstanced( Video::Primitive prim, uint start, uint primCount, uint instanceStart, uint instanceCount )
+	{
+		DrawCall draw = { mGeometry, start, primCount, instanceCount };
+		Draws.push_back( draw );
+	}
+
+	std::vector< StubVertexBuffer* > VertexBuffers;
+	std::vector< StubIndexBuffer* > IndexBuffers;
+	std::vector< DrawCall > Draws;
+private:
+	Video::IGeometry* mGeometry;
+	Video::IShader* mShader;
+};
+
+static const Video::VertexFormat ScenePositionFormat = Video::VertexFormat( ).AddElement( Video::Attribute::Position, 3 );
+
+//vertexCount vertices along x between -0.5 and 0.5, drawn as a fan
+static Core::MeshData MakeSceneMesh( uint vertexCount )
+{
+	Core::MeshData mesh;
+	mesh.Format = ScenePositionFormat;
+	mesh.VertexCount = vertexCount;
+	for( uint i = 0; i < vertexCount; i++ )
+	{
+		float32 x = ( float32 )i / ( vertexCount - 1 ) - 0.5f;
+		mesh.Vertices.insert( mesh.Vertices.end( ), { x, ( float32 )( i % 2 ), 0 } );
+	}
+	for( uint i = 1; i + 1 < vertexCount; i++ )
+	{
+		mesh.Indices.insert( mesh.Indices.end( ), { 0, i, i + 1 } );
+	}
+	return mesh;
+}
+
+//looks straight down -z at the origin, everything made by MakeSceneMesh is in view
+static Core::Scene::RenderView MakeSceneView( )
+{
+	Core::Scene::RenderView view;
+	view.Projection = Core::Math::Matrix4f( );
+	view.View = Core::Math::Matrix4f( );
+	view.Position = Core::Math::Vector3f( 0, 0, 1 );
+	view.Perspective = false;
+	view.PixelsPerUnit = 100;
+	view.LodPixelError = 0;
+	return view;
+}
+
+TEST_CASE( "Scene packs small meshes into a shared page" ) {
+	using namespace Core;
+
+	StubGraphicsDevice device;
+	StubShader shader;
+	Scene scene( &device );
+
+	MeshData first = MakeSceneMesh( 3 );
+	MeshData second = MakeSceneMesh( 5 );
+	Scene::MeshId firstMesh = scene.AddMesh( first );
+	Scene::MeshId secondMesh = scene.AddMesh( second );
+	REQUIRE( scene.IsValidMesh( firstMesh ) );
+	REQUIRE( scene.IsValidMesh( secondMesh ) );
+
+	//one page holds both, with 16 bit indices and no copy in system memory
+	REQUIRE( device.VertexBuffers.size( ) == 1 );
+	REQUIRE( device.IndexBuffers.size( ) == 1 );
+	const StubVertexBuffer& vbo = *device.VertexBuffers[ 0 ];
+	const StubIndexBuffer& ibo = *device.IndexBuffers[ 0 ];
+	CHECK( vbo.GetLength( ) == Scene::PageVertexCount );
+	CHECK( ibo.GetLength( ) == Scene::PageIndexCount );
+	CHECK( ibo.GetFormat( ) == Video::IndexFormat::UInt16 );
+	CHECK( vbo.Hint == Video::BufferHint::Dynamic );
+	CHECK( vbo.Shadow == Video::BufferShadow::None );
+
+	//the second mesh follows the first, its indices point at where its vertices went in the page
+	CHECK( std::equal( second.Vertices.begin( ), second.Vertices.end( ), vbo.Data.begin( ) + 3 * 3 ) );
+	CHECK( std::equal( first.Indices.begin( ), first.Indices.end( ), ibo.Data.begin( ) ) );
+	for( uint i = 0; i < second.Indices.size( ); i++ )
+	{
+		CHECK( ibo.Data[ first.Indices.size( ) + i ] == second.Indices[ i ] + 3 );
+	}
+
+	//both are drawn from the page's geometry without switching it
+	scene.Add( firstMesh, &shader );
+	scene.Add( secondMesh, &shader );
+	scene.Render( MakeSceneView( ) );
+
+	REQUIRE( device.Draws.size( ) == 2 );
+	CHECK( device.Draws[ 0 ].Geometry == device.Draws[ 1 ].Geometry );
+	CHECK( device.Draws[ 0 ].Start == 0 );
+	CHECK( device.Draws[ 0 ].PrimCount == 1 );
+	CHECK( device.Draws[ 1 ].Start == 3 );
+	CHECK( device.Draws[ 1 ].PrimCount == 3 );
+	CHECK( scene.GetStats( ).PageCount == 1 );
+	CHECK( scene.GetStats( ).StateChanges == 2 );
+}
+
+TEST_CASE( "Scene gives meshes too big for a page their own page" ) {
+	using namespace Core;
+
+	StubGraphicsDevice device;
+	StubShader shader;
+	Scene scene( &device );
+
+	Scene::MeshId small = scene.AddMesh( MakeSceneMesh( 3 ) );
+	MeshData big = MakeSceneMesh( Scene::PageVertexCount + 1 );
+	Scene::MeshId bigMesh = scene.AddMesh( big );
+	REQUIRE( scene.IsValidMesh( bigMesh ) );
+
+	//sized to the mesh, with indices that reach every vertex, and written once
+	REQUIRE( device.VertexBuffers.size( ) == 2 );
+	REQUIRE( device.IndexBuffers.size( ) == 2 );
+	const StubVertexBuffer& vbo = *device.VertexBuffers[ 1 ];
+	const StubIndexBuffer& ibo = *device.IndexBuffers[ 1 ];
+	CHECK( vbo.GetLength( ) == big.VertexCount );
+	CHECK( ibo.GetLength( ) == big.Indices.size( ) );
+	CHECK( ibo.GetFormat( ) == Video::IndexFormat::UInt32 );
+	CHECK( vbo.Hint == Video::BufferHint::Static );
+	CHECK( ibo.Data == big.Indices );
+
+	//a small mesh still goes to the shared page, not the big mesh's
+	Scene::MeshId other = scene.AddMesh( MakeSceneMesh( 3 ) );
+	CHECK( device.VertexBuffers.size( ) == 2 );
+	CHECK( device.IndexBuffers[ 0 ]->Data[ 3 ] == 3 );
+
+	scene.Add( small, &shader );
+	scene.Add( bigMesh, &shader );
+	scene.Add( other, &shader );
+	scene.Render( MakeSceneView( ) );
+	CHECK( scene.GetStats( ).PageCount == 2 );
+	CHECK( scene.GetStats( ).DrawCount == 3 );
+}
+
+TEST_CASE( "Scene releases empty pages and reuses their place" ) {
+	using namespace Core;
+
+	StubGraphicsDevice device;
+	StubShader shader;
+	Scene scene( &device );
+
+	Scene::MeshId first = scene.AddMesh( MakeSceneMesh( 3 ) );
+	Scene::MeshId second = scene.AddMesh( MakeSceneMesh( 3 ) );
+	Scene::MeshId big = scene.AddMesh( MakeSceneMesh( Scene::PageVertexCount + 1 ) );
+	Scene::ObjectId object = scene.Add( first, &shader );
+	scene.Add( big, &shader );
+	REQUIRE( device.VertexBuffers.size( ) == 2 );
+
+	//the page stays while another mesh is in it, objects drawing the mesh go with it
+	scene.RemoveMesh( first );
+	CHECK_FALSE( scene.IsValidMesh( first ) );
+	CHECK_FALSE( scene.IsValid( object ) );
+	CHECK( scene.GetCount( ) == 1 );
+	CHECK( device.VertexBuffers.size( ) == 2 );
+
+	scene.RemoveMesh( second );
+	CHECK( device.VertexBuffers.size( ) == 1 );
+	CHECK( device.IndexBuffers.size( ) == 1 );
+	CHECK( device.VertexBuffers[ 0 ]->GetLength( ) == Scene::PageVertexCount + 1 );
+
+	//the new page takes the released page's place, before the big mesh's, and the mesh id is reused
+	Scene::MeshId added = scene.AddMesh( MakeSceneMesh( 4 ) );
+	CHECK( ( added == first || added == second ) );
+	CHECK( device.VertexBuffers.size( ) == 2 );
+	scene.Add( added, &shader );
+	scene.Render( MakeSceneView( ) );
+
+	REQUIRE( device.Draws.size( ) == 2 );
+	CHECK( device.Draws[ 0 ].Geometry->GetVertexBuffer( 0 )->GetLength( ) == Scene::PageVertexCount );
+	CHECK( device.Draws[ 0 ].PrimCount == 2 );
+	CHECK( device.Draws[ 1 ].Geometry->GetVertexBuffer( 0 )->GetLength( ) == Scene::PageVertexCount + 1 );
+	CHECK( scene.GetStats( ).PageCount == 2 );
+}
+
+TEST_CASE( "Clearing a scene removes every object and mesh" ) {
+	using namespace Core;
+
+	StubGraphicsDevice device;
+	StubShader shader;
+	Scene scene( &device );
+
+	Scene::MeshId small = scene.AddMesh( MakeSceneMesh( 3 ) );
+	Scene::MeshId big = scene.AddMesh( MakeSceneMesh( Scene::PageVertexCount + 1 ) );
+	Scene::ObjectId object = scene.Add( small, &shader );
+	scene.Add( small, &shader );
+	scene.Add( big, &shader );
+
+	scene.Clear( );
+	CHECK( scene.GetCount( ) == 0 );
+	CHECK_FALSE( scene.IsValid( object ) );
+	CHECK_FALSE( scene.IsValidMesh( small ) );
+	CHECK_FALSE( scene.IsValidMesh( big ) );
+	CHECK( device.VertexBuffers.empty( ) );
+	CHECK( device.IndexBuffers.empty( ) );
+
+	scene.Render( MakeSceneView( ) );
+	CHECK( device.Draws.empty( ) );
+	CHECK( scene.GetStats( ).PageCount == 0 );
+
+	//still usable afterwards
+	Scene::MeshId added = scene.AddMesh( MakeSceneMesh( 3 ) );
+	CHECK( scene.IsValidMesh( added ) );
+	CHECK( scene.IsValid( scene.Add( added, &shader ) ) );
+	CHECK( device.VertexBuffers.size( ) == 1 );
+}
+
+TEST_CASE( "Removing an object removes the objects added under it" ) {
+	using namespace Core;
+	using namespace Core::Math;
+
+	StubGraphicsDevice device;
+	StubShader shader;
+	Scene scene( &device );
+
+	Scene::MeshId mesh = scene.AddMesh( MakeSceneMesh( 3 ) );
+	Scene::ObjectId parent = scene.Add( mesh, &shader );
+	Scene::ObjectId child = scene.Add( mesh, &shader, scene.GetNode( parent ) );
+	Scene::ObjectId grandchild = scene.Add( mesh, &shader, scene.GetNode( child ) );
+	Scene::ObjectId other = scene.Add( mesh, &shader );
+	scene.GetTransforms( ).SetPosition( scene.GetNode( other ), Vector3f( 0.25f, 0, 0 ) );
+
+	scene.Remove( parent );
+	CHECK_FALSE( scene.IsValid( parent ) );
+	CHECK_FALSE( scene.IsValid( child ) );
+	CHECK_FALSE( scene.IsValid( grandchild ) );
+	CHECK( scene.IsValid( other ) );
+	CHECK( scene.GetCount( ) == 1 );
+
+	//new objects get the freed nodes, every object keeps a node of its own
+	Scene::ObjectId added = scene.Add( mesh, &shader );
+	CHECK( scene.GetNode( added ) != scene.GetNode( other ) );
+	CHECK( scene.GetTransforms( ).GetPosition( scene.GetNode( other ) ).X == 0.25f );
+
+	scene.Render( MakeSceneView( ) );
+	CHECK( device.Draws.size( ) == 2 );
+	CHECK( scene.GetStats( ).ObjectCount == 2 );
+}
+
+TEST_CASE( "Scene ignores ids that aren't valid" ) {
+	using namespace Core;
+	using namespace Core::Math;
+
+	StubGraphicsDevice device;
+	StubShader shader;
+	Scene scene( &device );
+
+	Scene::MeshId mesh = scene.AddMesh( MakeSceneMesh( 3 ) );
+	Scene::ObjectId object = scene.Add( mesh, &shader );
+	scene.Remove( object );
+
+	for( Scene::ObjectId id : { object, Scene::None } )
+	{
+		scene.SetColor( id, Vector3f( 1, 0, 0 ) );
+		scene.SetShader( id, &shader );
+		CHECK( scene.GetColor( id ) == Vector3f( 0 ) );
+		CHECK( scene.GetShader( id ) == nullptr );
+		CHECK( scene.GetMesh( id ) == Scene::None );
+		CHECK( scene.GetNode( id ) == TransformHierarchy::None );
+		scene.Remove( id );
+	}
+
+	scene.RemoveMesh( mesh );
+	Vector3f low( 1 ), high( 1 );
+	scene.GetMeshBounds( mesh, low, high );
+	CHECK( low == Vector3f( 0 ) );
+	CHECK( high == Vector3f( 0 ) );
+	scene.GetMeshBounds( Scene::None, low, high );
+	CHECK( scene.Add( mesh, &shader ) == Scene::None );
+	CHECK( scene.GetCount( ) == 0 );
+}
+
+#endif
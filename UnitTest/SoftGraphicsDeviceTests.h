@@ -0,0 +1,171 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <string>
+#include <vector>
+
+#include "Types.h"
+#include "IWindow.h"
+#include "MeshData.h"
+#include "Scene.h"
+#include "Soft/SoftGraphicsDevice.h"
+#include "Math/ModelerMath.h"
+
+//only the size is read by the software device
+class SizedWindow : public Core::IWindow
+{
+public:
+	SizedWindow( uint width, uint height ) : mTitle( ), mWidth( width ), mHeight( height ) {}
+
+	bool IsVisible( ) const { return false; }
+	void SetVisible( bool visible ) {}
+	const std::string& GetTitle( ) const { return mTitle; }
+	void SetTitle( const std::string& title ) {}
+	uint GetWidth( ) const { return mWidth; }
+	uint GetHeight( ) const { return mHeight; }
+	void SetSize( uint width, uint height ) {}
+	Gui::Environment* GetEnvironment( ) { return nullptr; }
+	Core::SdlMouse* GetMouse( ) { return nullptr; }
+	void PollEvents( ) {}
+	void WaitEvents( float64 timeout ) {}
+	void Wake( ) {}
+	void SwapBuffers( ) {}
+	float32 GetAspectRatio( ) { return ( float32 )mWidth / mHeight; }
+private:
+	std::string mTitle;
+	uint mWidth, mHeight;
+};
+
+//the software device picks its program from the declarations, the bodies are never run
+static const char* LitShaderSource =
+	"uniform mat4 Projection; \n"
+	"uniform mat4 View; \n"
+	"uniform mat4 Model; \n"
+	"uniform mat3 NormalMat; \n"
+	"uniform vec3 Color; \n"
+	"uniform vec3 LightDirection = vec3(-1, -0.5, -1); \n";
+
+static const char* InstancedLitShaderSource =
+	"attribute vec4 aModel0; \n"
+	"attribute vec4 aModel1; \n"
+	"attribute vec4 aModel2; \n"
+	"attribute vec4 aModel3; \n"
+	"attribute vec3 aNormalMat0; \n"
+	"attribute vec3 aNormalMat1; \n"
+	"attribute vec3 aNormalMat2; \n"
+	"attribute vec3 aColor; \n"
+	"uniform mat4 Projection; \n"
+	"uniform mat4 View; \n"
+	"uniform vec3 LightDirection = vec3(-1, -0.5, -1); \n";
+
+//pyramid with its tip towards the viewer, every face its own normal so the lighting shows the rotation
+static Core::MeshData MakePyramid( )
+{
+	using namespace Core::Math;
+
+	Core::MeshData mesh;
+	mesh.Format = Video::VertexFormat( ).AddElement( Video::Attribute::Position, 3 ).AddElement( Video::Attribute::Normal, 3 );
+
+	const Vector3f tip( 0, 0, 1 );
+	const Vector3f base[] = { Vector3f( -1, -1, 0 ), Vector3f( 1, -1, 0 ), Vector3f( 1, 1, 0 ), Vector3f( -1, 1, 0 ) };
+	for( uint i = 0; i < 4; i++ )
+	{
+		const Vector3f corners[] = { base[ i ], base[ ( i + 1 ) % 4 ], tip };
+		const Vector3f normal = Normalize( Cross( corners[ 1 ] - corners[ 0 ], corners[ 2 ] - corners[ 0 ] ) );
+		for( const Vector3f& corner : corners )
+		{
+			mesh.Vertices.insert( mesh.Vertices.end( ), { corner.X, corner.Y, corner.Z, normal.X, normal.Y, normal.Z } );
+			mesh.Indices.push_back( mesh.VertexCount++ );
+		}
+	}
+	return mesh;
+}
+
+static std::vector< uint8 > RenderPyramids( Video::SoftGraphicsDevice& refDevice, bool instanced, uint& refInstancedCount )
+{
+	using namespace Core;
+	using namespace Core::Math;
+
+	Video::IShader* shader = refDevice.CreateShader( LitShaderSource, "" );
+	Video::IShader* instancedShader = refDevice.CreateShader( InstancedLitShaderSource, "" );
+
+	std::vector< uint8 > pixels;
+	{
+		Scene scene( &refDevice );
+		if( instanced ) scene.SetInstancedShader( shader, instancedShader );
+
+		//a row of turned, scaled and colored copies, and one of another mesh so batches and single draws mix
+		Scene::MeshId pyramid = scene.AddMesh( MakePyramid( ) );
+		for( uint i = 0; i < 5; i++ )
+		{
+			Scene::ObjectId object = scene.Add( pyramid, shader );
+			TransformHierarchy::NodeId node = scene.GetNode( object );
+			scene.GetTransforms( ).SetPosition( node, Vector3f( -0.8f + 0.4f * i, 0.3f * ( i % 2 ), -0.2f * i ) );
+			scene.GetTransforms( ).SetRotation( node, Quaternionf::AxisAngle( Normalize( Vector3f( 1, 1, 0 ) ), 0.4f * i ) );
+			scene.GetTransforms( ).SetScale( node, Vector3f( 0.1f + 0.02f * i ) );
+			scene.SetColor( object, Vector3f( 0.2f * i, 1 - 0.2f * i, 0.5f ) );
+		}
+		Scene::MeshId other = scene.AddMesh( MakePyramid( ) );
+		Scene::ObjectId single = scene.Add( other, shader );
+		scene.GetTransforms( ).SetPosition( scene.GetNode( single ), Vector3f( 0, -0.6f, 0 ) );
+		scene.GetTransforms( ).SetScale( scene.GetNode( single ), Vector3f( 0.2f ) );
+
+		Scene::RenderView view;
+		view.Projection = Matrix4f::ToScale( Vector3f( 1, 1, -0.5f ) );
+		view.View = Matrix4f( );
+		view.Position = Vector3f( 0, 0, 2 );
+		view.Perspective = false;
+		view.PixelsPerUnit = refDevice.GetHeight( ) / 2;
+		view.LodPixelError = 0;
+
+		refDevice.Clear( );
+		scene.Render( view );
+		refInstancedCount = scene.GetStats( ).InstancedCount;
+
+		uint width, height;
+		refDevice.ReadPixels( pixels, width, height );
+	}
+
+	shader->Release( );
+	instancedShader->Release( );
+	delete shader;
+	delete instancedShader;
+	return pixels;
+}
+
+TEST_CASE( "Software device draws instances like the objects drawn one by one" ) {
+	SizedWindow window( 160, 120 );
+	Video::SoftGraphicsDevice device( &window );
+	device.Init( );
+	device.SetClearColor( 0, 0, 0 );
+
+	uint singleCount, instancedCount;
+	std::vector< uint8 > single = RenderPyramids( device, false, singleCount );
+	std::vector< uint8 > instanced = RenderPyramids( device, true, instancedCount );
+
+	CHECK( singleCount == 0 );
+	CHECK( instancedCount == 5 );
+
+	uint covered = 0, differ = 0;
+	REQUIRE( single.size( ) == instanced.size( ) );
+	for( uint i = 0; i < single.size( ); i += 4 )
+	{
+		if( single[ i ] || single[ i + 1 ] || single[ i + 2 ] ) covered++;
+		for( uint c = 0; c < 4; c++ )
+		{
+			if( single[ i + c ] != instanced[ i + c ] )
+			{
+				differ++;
+				break;
+			}
+		}
+	}
+
+	UNIT_TEST_OUTPUT( std::cout << "Pyramids covered " << covered << " pixels" << std::endl )
+
+	CHECK( covered > 500 );
+	CHECK( differ == 0 );
+}
+
+#endif
@@ -0,0 +1,140 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <cmath>
+#include <vector>
+
+#include "Types.h"
+#include "Soft/SoftRasterizer.h"
+
+//white at half alpha, so a pixel drawn twice comes out brighter than one drawn once
+class HalfWhiteShader : public Video::SoftPixelShader
+{
+public:
+	void Shade( const float32* varyings, float32* refColor ) const
+	{
+		refColor[ 0 ] = refColor[ 1 ] = refColor[ 2 ] = 1;
+		refColor[ 3 ] = 0.5f;
+	}
+};
+
+//copies the first varying to red
+class VaryingShader : public Video::SoftPixelShader
+{
+public:
+	void Shade( const float32* varyings, float32* refColor ) const
+	{
+		refColor[ 0 ] = varyings[ 0 ];
+		refColor[ 1 ] = refColor[ 2 ] = 0;
+		refColor[ 3 ] = 1;
+	}
+};
+
+static Video::SoftVertex MakeVertex( float32 x, float32 y, float32 z, float32 w, float32 varying = 0 )
+{
+	Video::SoftVertex vertex = { { x, y, z, w }, { varying } };
+	return vertex;
+}
+
+TEST_CASE( "Software rasterizer draws pixels on shared edges once" ) {
+	Video::SoftRasterizer rasterizer;
+	rasterizer.Resize( 203, 157 );
+
+	const float32 black[] = { 0, 0, 0, 1 };
+	rasterizer.Clear( black, true );
+
+	//a fan around an off center point, its triangles wound both ways
+	std::vector< Video::SoftVertex > vertices;
+	const uint count = 13;
+	for( uint i = 0; i < count; i++ )
+	{
+		float32 a0 = i * 6.2831853f / count + 0.3f;
+		float32 a1 = ( i + 1 ) % count * 6.2831853f / count + 0.3f;
+
+		Video::SoftVertex center = MakeVertex( 0.137f, -0.211f, 0, 1 );
+		Video::SoftVertex p = MakeVertex( 0.137f + cos( a0 ) * 0.8f, -0.211f + sin( a0 ) * 1.1f, 0, 1 );
+		Video::SoftVertex q = MakeVertex( 0.137f + cos( a1 ) * 0.8f, -0.211f + sin( a1 ) * 1.1f, 0, 1 );
+
+		vertices.push_back( center );
+		vertices.push_back( i % 2 ? q : p );
+		vertices.push_back( i % 2 ? p : q );
+	}
+
+	rasterizer.DrawTriangles( vertices.data( ), nullptr, count, 0, HalfWhiteShader( ) );
+
+	std::vector< uint8 > pixels;
+	rasterizer.ReadPixels( pixels );
+
+	uint covered = 0, twice = 0;
+	for( uint i = 0; i < pixels.size( ); i += 4 )
+	{
+		if( pixels[ i ] == 0 ) continue;
+		covered++;
+		if( pixels[ i ] != 128 ) twice++;
+	}
+
+	UNIT_TEST_OUTPUT( std::cout << "Fan covered " << covered << " pixels" << std::endl )
+
+	CHECK( covered > 0 );
+	CHECK( twice == 0 );
+}
+
+TEST_CASE( "Software rasterizer keeps the nearest triangle" ) {
+	Video::SoftRasterizer rasterizer;
+	rasterizer.Resize( 64, 64 );
+	rasterizer.Clear( nullptr, true );
+
+	//full screen triangles, the far one drawn last
+	Video::SoftVertex vertices[] = {
+		MakeVertex( -1, -1, -0.5f, 1, 0.25f ), MakeVertex( 3, -1, -0.5f, 1, 0.25f ), MakeVertex( -1, 3, -0.5f, 1, 0.25f ),
+		MakeVertex( -1, -1, 0.5f, 1, 1.0f ), MakeVertex( 3, -1, 0.5f, 1, 1.0f ), MakeVertex( -1, 3, 0.5f, 1, 1.0f )
+	};
+	rasterizer.DrawTriangles( vertices, nullptr, 2, 1, VaryingShader( ) );
+
+	std::vector< uint8 > pixels;
+	rasterizer.ReadPixels( pixels );
+
+	CHECK( pixels[ 0 ] == 64 );
+	CHECK( pixels[ ( 32 * 64 + 32 ) * 4 ] == 64 );
+}
+
+TEST_CASE( "Software rasterizer clips triangles behind the camera" ) {
+	Video::SoftRasterizer rasterizer;
+	rasterizer.Resize( 64, 64 );
+
+	const float32 black[] = { 0, 0, 0, 1 };
+	rasterizer.Clear( black, true );
+
+	//one vertex behind the near plane with a negative w, and one far outside the screen
+	Video::SoftVertex vertices[] = {
+		MakeVertex( -1, -1, -2, -0.5f, 1 ), MakeVertex( 1, -1, 0.5f, 1, 1 ), MakeVertex( 0, 1, 0.5f, 1, 1 ),
+		MakeVertex( -1e6f, -1e6f, 0, 1, 1 ), MakeVertex( 1e6f, -1e6f, 0, 1, 1 ), MakeVertex( 0, 1e6f, 0, 1, 1 )
+	};
+
+	rasterizer.DrawTriangles( vertices, nullptr, 1, 1, VaryingShader( ) );
+
+	std::vector< uint8 > pixels;
+	rasterizer.ReadPixels( pixels );
+
+	uint covered = 0;
+	for( uint i = 0; i < pixels.size( ); i += 4 )
+	{
+		if( pixels[ i ] != 0 ) covered++;
+	}
+	CHECK( covered > 0 );
+	CHECK( covered < 64 * 64 );
+
+	rasterizer.Clear( black, true );
+	rasterizer.DrawTriangles( vertices + 3, nullptr, 1, 1, VaryingShader( ) );
+	rasterizer.ReadPixels( pixels );
+
+	covered = 0;
+	for( uint i = 0; i < pixels.size( ); i += 4 )
+	{
+		if( pixels[ i ] == 255 ) covered++;
+	}
+	CHECK( covered == 64 * 64 );
+}
+
+#endif
@@ -0,0 +1,151 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Types.h"
+#include "ThreadUtil.h"
+
+TEST_CASE( "ParallelFor calls the body once for every index" ) {
+	const uint64 count = 100000;
+	std::vector< uint8 > hits( count, 0 );
+	std::atomic< uint64 > calls( 0 );
+
+	Core::Thread::ParallelFor( count, 100, [ & ]( uint64 begin, uint64 end )
+	{
+		calls++;
+		for( uint64 i = begin; i < end; i++ )
+			hits[ i ]++;
+	} );
+
+	CHECK( calls >= 1 );
+	CHECK( std::count( hits.begin( ), hits.end( ), 1 ) == count );
+
+	//too few items for more than one range
+	calls = 0;
+	Core::Thread::ParallelFor( 10, 100, [ & ]( uint64 begin, uint64 end )
+	{
+		calls++;
+		CHECK( begin == 0 );
+		CHECK( end == 10 );
+	} );
+	CHECK( calls == 1 );
+}
+
+TEST_CASE( "Jobs start after their dependencies finish" ) {
+	std::atomic< uint > order( 0 );
+	uint first = 0, second = 0, third = 0;
+
+	Core::Thread::JobHandle a = Core::Thread::Run( [ & ] { Core::Thread::Sleep( 10 ); first = ++order; } );
+	Core::Thread::JobHandle b = Core::Thread::Run( [ & ] { second = ++order; }, { a } );
+	Core::Thread::JobHandle c = Core::Thread::Run( [ & ] { third = ++order; }, { a, b, Core::Thread::JobHandle( ) } );
+
+	Core::Thread::Wait( c );
+
+	CHECK( Core::Thread::IsDone( a ) );
+	CHECK( Core::Thread::IsDone( b ) );
+	CHECK( first == 1 );
+	CHECK( second == 2 );
+	CHECK( third == 3 );
+
+	//a job depending only on finished jobs is queued right away
+	bool ran = false;
+	Core::Thread::Wait( Core::Thread::Run( [ & ] { ran = true; }, { a, b } ) );
+	CHECK( ran );
+}
+
+TEST_CASE( "Jobs can wait on the jobs they queue" ) {
+	std::vector< uint64 > sums( 8, 0 );
+	std::vector< Core::Thread::JobHandle > jobs;
+
+	for( uint i = 0; i < sums.size( ); i++ )
+	{
+		jobs.push_back( Core::Thread::Run( [ &sums, i ]
+		{
+			std::atomic< uint64 > sum( 0 );
+			Core::Thread::ParallelFor( 1000, 10, [ & ]( uint64 begin, uint64 end )
+			{
+				for( uint64 j = begin; j < end; j++ )
+					sum += j;
+			} );
+			sums[ i ] = sum;
+		} ) );
+	}
+
+	for( uint i = 0; i < jobs.size( ); i++ )
+		Core::Thread::Wait( jobs[ i ] );
+
+	for( uint i = 0; i < sums.size( ); i++ )
+		CHECK( sums[ i ] == 999 * 1000 / 2 );
+}
+
+TEST_CASE( "Waiting runs the waited on job but no other" ) {
+	//keep every worker busy so queued jobs stay queued
+	std::atomic< bool > release( false );
+	std::atomic< uint > started( 0 );
+	std::vector< Core::Thread::JobHandle > blockers;
+	for( uint i = 0; i < Core::Thread::GetWorkerCount( ); i++ )
+	{
+		blockers.push_back( Core::Thread::Run( [ & ]
+		{
+			started++;
+			while( !release ) Core::Thread::Sleep( 1 );
+		} ) );
+	}
+	while( started < blockers.size( ) ) Core::Thread::Sleep( 1 );
+
+	std::thread::id self = std::this_thread::get_id( );
+	std::thread::id waitedThread;
+	Core::Thread::JobHandle other = Core::Thread::Run( [ ] { } );
+	Core::Thread::JobHandle waited = Core::Thread::Run( [ & ] { waitedThread = std::this_thread::get_id( ); } );
+
+	Core::Thread::Wait( waited );
+	CHECK( waitedThread == self );
+	CHECK_FALSE( Core::Thread::IsDone( other ) );
+
+	release = true;
+	Core::Thread::Wait( other );
+	for( const Core::Thread::JobHandle& blocker : blockers )
+		Core::Thread::Wait( blocker );
+}
+
+TEST_CASE( "Main thread jobs only run in RunMainThreadJobs" ) {
+	bool ran = false;
+	Core::Thread::JobHandle work = Core::Thread::Run( [ ] { Core::Thread::Sleep( 5 ); } );
+	Core::Thread::JobHandle upload = Core::Thread::RunOnMainThread( [ & ] { ran = true; }, { work } );
+
+	Core::Thread::Wait( work );
+	Core::Thread::Sleep( 5 );
+	CHECK( !ran );
+	CHECK( !Core::Thread::IsDone( upload ) );
+
+	//the worker queues it just after work is marked done
+	for( uint i = 0; i < 100 && !Core::Thread::IsDone( upload ); i++ )
+	{
+		Core::Thread::RunMainThreadJobs( );
+		Core::Thread::Sleep( 1 );
+	}
+	CHECK( ran );
+	CHECK( Core::Thread::IsDone( upload ) );
+}
+
+TEST_CASE( "Queueing a main thread job calls the wake up" ) {
+	std::atomic< uint > wakeUps( 0 );
+	Core::Thread::SetMainThreadWakeUp( [ & ] { wakeUps++; } );
+
+	Core::Thread::Wait( Core::Thread::Run( [ ] { Core::Thread::RunOnMainThread( [ ] { } ); } ) );
+	CHECK( wakeUps == 1 );
+
+	//worker jobs don't need the main thread
+	Core::Thread::Wait( Core::Thread::Run( [ ] { } ) );
+	CHECK( wakeUps == 1 );
+
+	Core::Thread::SetMainThreadWakeUp( nullptr );
+	Core::Thread::RunMainThreadJobs( );
+}
+
+#endif
@@ -0,0 +1,159 @@
+#pragma once
+
+#if DO_UNIT_TESTING==1
+
+#include <vector>
+
+#include "Types.h"
+#include "TransformHierarchy.h"
+#include "Math/ModelerMath.h"
+
+static bool MatricesNear( const Core::Math::Matrix4f& a, const Core::Math::Matrix4f& b )
+{
+	for( uint i = 0; i < 4; i++ )
+	{
+		for( uint j = 0; j < 4; j++ )
+		{
+			if( a[ i ][ j ] != Approx( b[ i ][ j ] ).epsilon( 0.0001 ).margin( 0.00001 ) ) return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE( "World matrices are the parent's world times the local transform" ) {
+	using namespace Core;
+	using namespace Core::Math;
+
+	TransformHierarchy hierarchy;
+	TransformHierarchy::NodeId root = hierarchy.Add( );
+	TransformHierarchy::NodeId child = hierarchy.Add( root );
+	TransformHierarchy::NodeId grandchild = hierarchy.Add( child );
+
+	Quaternionf turn = Quaternionf::AxisAngle( Vector3f( 0, 1, 0 ), 0.5f );
+	hierarchy.SetPosition( root, Vector3f( 1, 2, 3 ) );
+	hierarchy.SetRotation( root, turn );
+	hierarchy.SetScale( child, Vector3f( 2 ) );
+	hierarchy.SetPosition( grandchild, Vector3f( 0, 0, 1 ) );
+	hierarchy.Update( );
+
+	Matrix4f rootLocal = Matrix4f::ToTranslation( Vector3f( 1, 2, 3 ) ) * Quaternionf::ToRotation( turn );
+	Matrix4f childLocal = Matrix4f::ToScale( Vector3f( 2 ) );
+	Matrix4f grandchildLocal = Matrix4f::ToTranslation( Vector3f( 0, 0, 1 ) );
+
+	CHECK( hierarchy.GetLevelCount( ) == 3 );
+	CHECK( MatricesNear( hierarchy.GetLocalMatrix( root ), rootLocal ) );
+	CHECK( MatricesNear( hierarchy.GetWorldMatrix( root ), rootLocal ) );
+	CHECK( MatricesNear( hierarchy.GetWorldMatrix( child ), rootLocal * childLocal ) );
+	CHECK( MatricesNear( hierarchy.GetWorldMatrix( grandchild ), rootLocal * childLocal * grandchildLocal ) );
+
+	//the grandchild's origin, one unit along z from the scaled child, turned and moved by the root
+	Vector4f origin = hierarchy.GetWorldMatrix( grandchild ) * Vector4f( 0, 0, 0, 1 );
+	CHECK( origin.X == Approx( 1 + 2 * std::sin( 0.5f ) ) );
+	CHECK( origin.Y == Approx( 2 ) );
+	CHECK( origin.Z == Approx( 3 + 2 * std::cos( 0.5f ) ) );
+
+	SECTION( "changes reach every node below" ) {
+		hierarchy.SetPosition( root, Vector3f( 0 ) );
+		hierarchy.Update( );
+		Matrix4f moved = Quaternionf::ToRotation( turn ) * childLocal * grandchildLocal;
+		CHECK( MatricesNear( hierarchy.GetWorldMatrix( grandchild ), moved ) );
+	}
+
+	SECTION( "reparenting keeps the local transform" ) {
+		REQUIRE( hierarchy.SetParent( grandchild, TransformHierarchy::None ) );
+		hierarchy.Update( );
+		CHECK( hierarchy.GetParent( grandchild ) == TransformHierarchy::None );
+		CHECK( hierarchy.GetLevelCount( ) == 2 );
+		CHECK( MatricesNear( hierarchy.GetWorldMatrix( grandchild ), grandchildLocal ) );
+
+		//a node can't move below itself
+		CHECK_FALSE( hierarchy.SetParent( root, child ) );
+		CHECK_FALSE( hierarchy.SetParent( root, root ) );
+		CHECK( hierarchy.GetParent( root ) == TransformHierarchy::None );
+	}
+
+	SECTION( "removing a node removes everything below it" ) {
+		TransformHierarchy::NodeId other = hierarchy.Add( root );
+		hierarchy.Remove( child );
+		CHECK_FALSE( hierarchy.IsValid( child ) );
+		CHECK_FALSE( hierarchy.IsValid( grandchild ) );
+		CHECK( hierarchy.IsValid( other ) );
+		CHECK( hierarchy.GetCount( ) == 2 );
+
+		hierarchy.Update( );
+		CHECK( hierarchy.GetLevelCount( ) == 2 );
+		CHECK( hierarchy.GetParent( other ) == root );
+		CHECK( MatricesNear( hierarchy.GetWorldMatrix( other ), rootLocal ) );
+
+		//ids are reused
+		TransformHierarchy::NodeId added = hierarchy.Add( other );
+		CHECK( ( added == child || added == grandchild ) );
+		hierarchy.Update( );
+		CHECK( hierarchy.GetCount( ) == 3 );
+		CHECK( hierarchy.GetLevelCount( ) == 3 );
+	}
+
+	SECTION( "removed nodes are ignored" ) {
+		hierarchy.Remove( grandchild );
+
+		CHECK_FALSE( hierarchy.SetParent( grandchild, root ) );
+		CHECK( hierarchy.GetParent( grandchild ) == TransformHierarchy::None );
+		CHECK( hierarchy.GetParent( TransformHierarchy::None ) == TransformHierarchy::None );
+		hierarchy.SetPosition( grandchild, Vector3f( 5 ) );
+		hierarchy.SetRotation( grandchild, turn );
+		hierarchy.SetScale( TransformHierarchy::None, Vector3f( 3 ) );
+		CHECK( MatricesNear( hierarchy.GetLocalMatrix( grandchild ), Matrix4f( ) ) );
+
+		hierarchy.Update( );
+		CHECK( hierarchy.GetCount( ) == 2 );
+		CHECK( MatricesNear( hierarchy.GetWorldMatrix( child ), rootLocal * childLocal ) );
+	}
+}
+
+TEST_CASE( "Nodes added before their parent's level still update in order" ) {
+	using namespace Core;
+	using namespace Core::Math;
+
+	//a wide tree split across the job system, with a chain hung off its last node
+	TransformHierarchy hierarchy;
+	TransformHierarchy::NodeId root = hierarchy.Add( );
+	hierarchy.SetPosition( root, Vector3f( 1, 0, 0 ) );
+
+	std::vector< TransformHierarchy::NodeId > leaves;
+	for( uint i = 0; i < 20000; i++ )
+	{
+		leaves.push_back( hierarchy.Add( root ) );
+		hierarchy.SetPosition( leaves.back( ), Vector3f( 0, i, 0 ) );
+	}
+
+	TransformHierarchy::NodeId bottom = hierarchy.Add( );
+	TransformHierarchy::NodeId chain = bottom;
+	for( uint i = 0; i < 10; i++ )
+	{
+		TransformHierarchy::NodeId next = hierarchy.Add( );
+		hierarchy.SetPosition( next, Vector3f( 0, 0, 1 ) );
+		hierarchy.SetParent( chain, next );
+		chain = next;
+	}
+	hierarchy.SetParent( chain, leaves.back( ) );
+	hierarchy.Update( );
+
+	CHECK( hierarchy.GetLevelCount( ) == 13 );
+	bool placed = true;
+	for( uint i = 0; i < leaves.size( ); i++ )
+	{
+		Vector4f origin = hierarchy.GetWorldMatrix( leaves[ i ] ) * Vector4f( 0, 0, 0, 1 );
+		placed = placed && origin.X == 1 && origin.Y == i;
+	}
+	CHECK( placed );
+
+	//moving the root moves the bottom of the chain, eleven levels below the leaf it hangs off
+	hierarchy.SetPosition( root, Vector3f( 5, 0, 0 ) );
+	hierarchy.Update( );
+	Vector4f origin = hierarchy.GetWorldMatrix( bottom ) * Vector4f( 0, 0, 0, 1 );
+	CHECK( origin.X == 5 );
+	CHECK( origin.Y == 19999 );
+	CHECK( origin.Z == 10 );
+}
+
+#endif
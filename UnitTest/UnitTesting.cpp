@@ -16,6 +16,18 @@
 
 //Unit test files
 #include "MathTests.h"
+#include "MeshCacheTests.h"
+#include "MeshOptimizerTests.h"
+#include "MeshSimplifierTests.h"
+#include "MeshUtilTests.h"
+#include "ObjLoaderTests.h"
+#include "ProfilerTests.h"
+#include "RangeAllocatorTests.h"
+#include "SceneTests.h"
+#include "SoftGraphicsDeviceTests.h"
+#include "SoftRasterizerTests.h"
+#include "ThreadUtilTests.h"
+#include "TransformHierarchyTests.h"
 //#include "FileIOTests.h"
 
 #endif